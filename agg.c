@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "agg.h"
+
+void groupby_init(GroupBy* g) {
+    g->rows = NULL;
+    g->num_rows = g->cap_rows = 0;
+    g->slots = NULL;
+    g->num_slots = 0;
+}
+
+void groupby_free(GroupBy* g) {
+    free(g->rows);
+    free(g->slots);
+    groupby_init(g);
+}
+
+unsigned group_hash(int key) {
+    unsigned h = (unsigned)key * 2654435761u;
+    return h ^ (h >> 16);
+}
+
+void groupby_rehash(GroupBy* g, int num_slots) {
+    int* slots = (int*)calloc(num_slots, sizeof(int));
+    if (!slots) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (int r = 0; r < g->num_rows; r++) {
+        unsigned h = group_hash(g->rows[r].key) & (num_slots - 1);
+        while (slots[h]) h = (h + 1) & (num_slots - 1);
+        slots[h] = r + 1;
+    }
+    free(g->slots);
+    g->slots = slots;
+    g->num_slots = num_slots;
+}
+
+void groupby_add(GroupBy* g, int key, double amount) {
+    if (g->num_rows * 2 >= g->num_slots) groupby_rehash(g, g->num_slots ? g->num_slots * 2 : 64);
+
+    unsigned h = group_hash(key) & (g->num_slots - 1);
+    while (g->slots[h]) {
+        GroupRow* row = &g->rows[g->slots[h] - 1];
+        if (row->key == key) {
+            row->count++;
+            row->revenue += amount;
+            return;
+        }
+        h = (h + 1) & (g->num_slots - 1);
+    }
+
+    if (g->num_rows == g->cap_rows) {
+        int cap_rows = g->cap_rows ? g->cap_rows * 2 : 32;
+        GroupRow* rows = (GroupRow*)realloc(g->rows, cap_rows * sizeof(GroupRow));
+        if (!rows) {
+            printf("Memory allocation failed!\n");
+            exit(1);
+        }
+        g->rows = rows;
+        g->cap_rows = cap_rows;
+    }
+    GroupRow* row = &g->rows[g->num_rows++];
+    row->key = key;
+    row->count = 1;
+    row->revenue = amount;
+    g->slots[h] = g->num_rows;
+}
+
+int car_group_key(const Car* c, GroupField field) {
+    switch (field) {
+        case GROUP_COLOR: return c->color;
+        case GROUP_FUEL: return c->fuel;
+        case GROUP_TYPE: return c->type;
+        default: return c->model;
+    }
+}
+
+const char* group_label(GroupField field, int key) {
+    switch (field) {
+        case GROUP_COLOR: return dict_name(&car_colors, key);
+        case GROUP_FUEL: return dict_name(&car_fuels, key);
+        case GROUP_TYPE: return dict_name(&car_types, key);
+        default: return dict_name(&car_models, key);
+    }
+}
+
+// One pass over the leaf chain of a car tree.
+void groupby_cars(GroupBy* g, BPTreeNode* root, GroupField field) {
+    BPTreeCursor cur;
+    void* data;
+    bptree_cursor_first(&cur, root);
+    while (bptree_cursor_next(&cur, NULL, &data)) {
+        Car* car = (Car*)data;
+        groupby_add(g, car_group_key(car, field), car->price);
+    }
+}
+
+int compare_rows_by_revenue(const void* a, const void* b) {
+    double ra = ((const GroupRow*)a)->revenue, rb = ((const GroupRow*)b)->revenue;
+    return (ra < rb) - (ra > rb);
+}
+
+// Highest revenue first. Invalidates the hash slots, so call it last.
+void groupby_sort(GroupBy* g) {
+    qsort(g->rows, g->num_rows, sizeof(GroupRow), compare_rows_by_revenue);
+    free(g->slots);
+    g->slots = NULL;
+    g->num_slots = 0;
+}
+
+void print_popular_car(Car* car, void* ctx) {
+    report_car(&report, car, ((Showroom*)ctx)->showroom_id);
+}
+
+// Most popular = highest sales value across all showrooms.
+void find_most_popular_car(Showroom* showrooms, int count) {
+    GroupBy g;
+    groupby_init(&g);
+    for (int i = 0; i < count; i++)
+        groupby_cars(&g, showrooms[i].sold_stock, GROUP_MODEL);
+
+    if (g.num_rows == 0) {
+        report_message(&report, "No cars sold yet.\n");
+        groupby_free(&g);
+        return;
+    }
+
+    GroupRow* best = &g.rows[0];
+    for (int r = 1; r < g.num_rows; r++) {
+        if (g.rows[r].revenue > best->revenue) best = &g.rows[r];
+    }
+
+    report_begin(&report, 0);
+    report_str(&report, "Most popular car", "model", group_label(GROUP_MODEL, best->key));
+    report_break(&report, 0);
+    report_int(&report, "Units sold", "units", best->count);
+    report_money(&report, "Sales value", "revenue", best->revenue);
+    report_end(&report);
+    for (int i = 0; i < count; i++) {
+        if (showrooms[i].indexes & IDX_MODEL) {
+            index_range(showrooms[i].model_index, best->key, best->key, print_popular_car, &showrooms[i]);
+            continue;
+        }
+        BPTreeCursor cur;
+        void* data;
+        bptree_cursor_first(&cur, showrooms[i].sold_stock);
+        while (bptree_cursor_next(&cur, NULL, &data)) {
+            if (((Car*)data)->model == best->key) report_car(&report, (Car*)data, showrooms[i].showroom_id);
+        }
+    }
+    groupby_free(&g);
+}
+
+void print_sales_breakdown(Showroom* showrooms, int count, GroupField field) {
+    const char* titles[] = { "Model", "Color", "Fuel", "Type" };
+    const char* keys[] = { "model", "color", "fuel", "type" };
+    GroupBy g;
+    groupby_init(&g);
+    for (int i = 0; i < count; i++)
+        groupby_cars(&g, showrooms[i].sold_stock, field);
+    groupby_sort(&g);
+
+    // The table keeps its aligned columns; CSV and JSON get one record per group
+    report_text(&report, "%-15s %8s %16s\n", titles[field], "Units", "Sales value");
+    for (int r = 0; r < g.num_rows; r++) {
+        if (report.format == REPORT_TABLE) {
+            report_text(&report, "%-15s %8ld %16.2f\n", group_label(field, g.rows[r].key), g.rows[r].count,
+                        g.rows[r].revenue);
+            continue;
+        }
+        report_begin(&report, 0);
+        report_str(&report, NULL, keys[field], group_label(field, g.rows[r].key));
+        report_int(&report, NULL, "units", g.rows[r].count);
+        report_money(&report, NULL, "revenue", g.rows[r].revenue);
+        report_end(&report);
+    }
+    groupby_free(&g);
+}
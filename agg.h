@@ -0,0 +1,41 @@
+#ifndef AGG_H
+#define AGG_H
+
+#include "bptree.h"
+
+//  Car attribute to group sales by
+typedef enum GroupField {
+    GROUP_MODEL,
+    GROUP_COLOR,
+    GROUP_FUEL,
+    GROUP_TYPE
+} GroupField;
+
+//  One output group
+typedef struct GroupRow {
+    int key;            // dictionary id of the attribute
+    long count;
+    double revenue;
+} GroupRow;
+
+//  Hash aggregation table: key -> row, open addressing
+typedef struct GroupBy {
+    GroupRow* rows;
+    int num_rows;
+    int cap_rows;
+    int* slots;         // row index + 1 (0 = empty)
+    int num_slots;
+} GroupBy;
+
+void groupby_init(GroupBy* g);
+void groupby_free(GroupBy* g);
+void groupby_add(GroupBy* g, int key, double amount);
+void groupby_cars(GroupBy* g, BPTreeNode* root, GroupField field);
+void groupby_sort(GroupBy* g);
+int car_group_key(const Car* c, GroupField field);
+const char* group_label(GroupField field, int key);
+
+void find_most_popular_car(Showroom* showrooms, int count);
+void print_sales_breakdown(Showroom* showrooms, int count, GroupField field);
+
+#endif
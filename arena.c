@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "arena.h"
+
+ArenaStats arena_stats = { 0, 0, 0 };
+
+void* arena_system_alloc(size_t size) {
+    void* p = malloc(size);
+    if (!p) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    __atomic_fetch_add(&arena_stats.mallocs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&arena_stats.bytes, size, __ATOMIC_RELAXED);
+    return p;
+}
+
+Arena* arena_create() {
+    Arena* a = (Arena*)arena_system_alloc(sizeof(Arena));
+    a->chunks = NULL;
+    a->next_chunk_size = ARENA_FIRST_CHUNK;
+    a->num_free_lists = 0;
+    a->lock = (SpinLock)SPIN_LOCK_INIT;
+    return a;
+}
+
+ArenaFreeList* arena_free_list(Arena* a, size_t size, int create) {
+    for (int i = 0; i < a->num_free_lists; i++) {
+        if (a->free_lists[i].size == size) return &a->free_lists[i];
+    }
+    if (!create || a->num_free_lists == ARENA_FREE_CLASSES) return NULL;
+    ArenaFreeList* fl = &a->free_lists[a->num_free_lists++];
+    fl->size = size;
+    fl->head = NULL;
+    return fl;
+}
+
+// Caller holds a->lock.
+void* arena_alloc_locked(Arena* a, size_t size) {
+    // Reuse a block handed back by arena_free
+    ArenaFreeList* fl = arena_free_list(a, size, 0);
+    if (fl && fl->head) {
+        void* p = fl->head;
+        fl->head = *(void**)p;
+        return p;
+    }
+
+    ArenaChunk* c = a->chunks;
+    if (!c || c->size - c->used < size) {
+        size_t chunk_size = a->next_chunk_size;
+        while (chunk_size < size) chunk_size *= 2;
+        if (a->next_chunk_size < ARENA_MAX_CHUNK) a->next_chunk_size *= 2;
+
+        c = (ArenaChunk*)arena_system_alloc(ARENA_ROUND(sizeof(ArenaChunk)) + chunk_size);
+        c->size = chunk_size;
+        c->used = 0;
+        c->next = a->chunks;
+        a->chunks = c;
+    }
+
+    void* p = (char*)c + ARENA_ROUND(sizeof(ArenaChunk)) + c->used;
+    c->used += size;
+    return p;
+}
+
+// A NULL arena means plain malloc, so callers never need two code paths.
+void* arena_alloc(Arena* a, size_t size) {
+    if (!a) return arena_system_alloc(size);
+
+    spin_lock(&a->lock);
+    void* p = arena_alloc_locked(a, ARENA_ROUND(size));
+    spin_unlock(&a->lock);
+    return p;
+}
+
+// Blocks go onto a per-size free list; memory itself returns on arena_destroy.
+void arena_free(Arena* a, void* p, size_t size) {
+    if (!p) return;
+    if (!a) {
+        __atomic_fetch_add(&arena_stats.frees, 1, __ATOMIC_RELAXED);
+        free(p);
+        return;
+    }
+
+    size = ARENA_ROUND(size);
+    spin_lock(&a->lock);
+    ArenaFreeList* fl = arena_free_list(a, size, 1);
+    if (fl) {
+        *(void**)p = fl->head;
+        fl->head = p;
+    }
+    spin_unlock(&a->lock);
+}
+
+// Releases every chunk at once: cost is the number of chunks, which grows
+// only logarithmically with the data because chunk sizes double.
+void arena_destroy(Arena* a) {
+    if (!a) return;
+    ArenaChunk* c = a->chunks;
+    while (c) {
+        ArenaChunk* next = c->next;
+        free(c);
+        __atomic_fetch_add(&arena_stats.frees, 1, __ATOMIC_RELAXED);
+        c = next;
+    }
+    free(a);
+    __atomic_fetch_add(&arena_stats.frees, 1, __ATOMIC_RELAXED);
+}
+
+// Moves every chunk of src into dst and releases src. Blocks allocated from
+// src stay valid and are freed with dst. dst keeps its current chunk at the
+// head so it continues bump-allocating where it left off.
+void arena_adopt(Arena* dst, Arena* src) {
+    if (!dst || !src) return;
+    spin_lock(&dst->lock);
+    ArenaChunk* last = src->chunks;
+    if (last) {
+        while (last->next) last = last->next;
+        if (dst->chunks) {
+            last->next = dst->chunks->next;
+            dst->chunks->next = src->chunks;
+        } else {
+            dst->chunks = src->chunks;
+        }
+    }
+    spin_unlock(&dst->lock);
+    free(src);
+    __atomic_fetch_add(&arena_stats.frees, 1, __ATOMIC_RELAXED);
+}
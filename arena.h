@@ -0,0 +1,51 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include "latch.h"
+
+#define ARENA_ALIGN 16
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+#define ARENA_FIRST_CHUNK (1 << 20)    // 1 MB, doubled for every new chunk
+#define ARENA_MAX_CHUNK (64 << 20)     // stop doubling at 64 MB
+#define ARENA_FREE_CLASSES 8           // distinct block sizes that get a free list
+
+//  Arena Chunk: header followed by the usable bytes
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;
+    size_t size;
+    size_t used;
+} ArenaChunk;
+
+//  Free list of recycled blocks of one size
+typedef struct ArenaFreeList {
+    size_t size;
+    void* head;
+} ArenaFreeList;
+
+//  Arena: bump allocator owning every record and node of one showroom
+typedef struct Arena {
+    ArenaChunk* chunks;            // newest chunk first
+    size_t next_chunk_size;
+    ArenaFreeList free_lists[ARENA_FREE_CLASSES];
+    int num_free_lists;
+    SpinLock lock;                 // sales on several terminals share one arena
+} Arena;
+
+//  Process-wide allocation counters (system allocations only), updated
+//  atomically so loader threads can share them
+typedef struct ArenaStats {
+    long mallocs;
+    long frees;
+    size_t bytes;
+} ArenaStats;
+
+extern ArenaStats arena_stats;
+
+Arena* arena_create();
+void* arena_alloc(Arena* a, size_t size);
+void arena_free(Arena* a, void* p, size_t size);
+void arena_destroy(Arena* a);
+void arena_adopt(Arena* dst, Arena* src);
+
+#endif
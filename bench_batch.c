@@ -0,0 +1,126 @@
+// Batch sale benchmark: replays a day's purchase lines one showroom_sell_car
+// at a time, then through sell_cars_batch at several batch sizes. Some lines
+// name cars already sold or never stocked. Every run checks that the same
+// cars end up sold to the same salespersons.
+// Build: gcc -O2 -pthread -o bench_batch bench_batch.c
+// Run:   ./bench_batch [num_cars] [num_sales] [indexes]   (default 1000000 500000 0)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bptree.c"
+
+#define BENCH_SALESPERSONS 16
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Sum of VIN * salesperson id over all sold cars, to compare runs
+long long sold_signature(Salesperson** sps) {
+    long long sig = 0;
+    BPTreeCursor cur;
+    int vin;
+    for (int i = 0; i < BENCH_SALESPERSONS; i++) {
+        bptree_cursor_first(&cur, sps[i]->soldCarsRoot);
+        while (bptree_cursor_next(&cur, &vin, NULL))
+            sig += (long long)vin * sps[i]->id;
+    }
+    return sig;
+}
+
+// batch == 0 sells one car at a time
+void run(int n, int m, int batch, int indexes, const int* vins, const int* sp_of) {
+    Showroom s;
+    showroom_init(&s, 1, 1);
+
+    int* keys = (int*)malloc(n * sizeof(int));
+    void** cars = (void**)malloc(n * sizeof(void*));
+    for (int i = 0; i < n; i++) {
+        Car* c = (Car*)arena_alloc(s.arena, sizeof(Car));
+        c->vin = i + 1;
+        c->price = 500000 + (i % 50) * 20000;
+        c->model = c->color = c->fuel = c->type = 0;
+        c->sale = NULL;
+        keys[i] = c->vin;
+        cars[i] = c;
+    }
+    bptree_bulk_load(&s.available_stock, keys, cars, n, bptree_bulk_fill);
+    free(keys);
+    free(cars);
+
+    Salesperson* sps[BENCH_SALESPERSONS];
+    for (int i = 0; i < BENCH_SALESPERSONS; i++) {
+        sps[i] = (Salesperson*)arena_alloc(s.arena, sizeof(Salesperson));
+        memset(sps[i], 0, sizeof(Salesperson));
+        sps[i]->id = i + 1;
+        sps[i]->target = 50.0;
+        sps[i]->soldCarsRoot = create_bptree_meta(s.meta);
+        bptree_insert(&s.salespersons, sps[i]->id, sps[i]);
+    }
+    if (indexes) showroom_enable_indexes(&s, IDX_ALL);
+
+    Sale cust;
+    memset(&cust, 0, sizeof(Sale));
+    strcpy(cust.cust_name, "Bench");
+    strcpy(cust.payment_method, "Cash");
+    cust.d_o_prchse = 15062024;
+
+    long sold = 0;
+    double t0 = now_sec();
+    if (batch == 0) {
+        for (int i = 0; i < m; i++)
+            sold += showroom_sell_car(&s, vins[i], sps[sp_of[i]], &cust) == SALE_OK;
+    } else {
+        SaleRequest* reqs = (SaleRequest*)malloc(batch * sizeof(SaleRequest));
+        for (int i = 0; i < m; i += batch) {
+            int k = m - i < batch ? m - i : batch;
+            for (int j = 0; j < k; j++) {
+                reqs[j].vin = vins[i + j];
+                reqs[j].sp = sps[sp_of[i + j]];
+                reqs[j].sale = &cust;
+            }
+            sold += sell_cars_batch(&s, reqs, k);
+        }
+        free(reqs);
+    }
+    double t = now_sec() - t0;
+
+    char label[32];
+    if (batch) snprintf(label, sizeof(label), "batch %d", batch);
+    else snprintf(label, sizeof(label), "per-sale");
+    printf("%-14s %-10ld %-12.0f %-12.1f %llx\n", label, sold, m / t, t * 1e3, sold_signature(sps));
+    fflush(stdout);
+
+    showroom_destroy(&s);
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    int m = argc > 2 ? atoi(argv[2]) : 500000;
+    int indexes = argc > 3 ? atoi(argv[3]) : 0;
+    if (n < 1) n = 1;
+    if (m < 1) m = 1;
+
+    // Purchase lines over VINs 1..n plus 5% beyond the stock, repeats allowed
+    int* vins = (int*)malloc(m * sizeof(int));
+    int* sp_of = (int*)malloc(m * sizeof(int));
+    srand(11);
+    for (int i = 0; i < m; i++) {
+        vins[i] = 1 + (int)(((long long)rand() * RAND_MAX + rand()) % (n + n / 20 + 1));
+        sp_of[i] = rand() % BENCH_SALESPERSONS;
+    }
+
+    printf("%d cars, %d purchase lines, %d salespersons, indexes %s\n", n, m, BENCH_SALESPERSONS,
+           indexes ? "on" : "off");
+    printf("%-14s %-10s %-12s %-12s %s\n", "mode", "sold", "lines/s", "ms", "signature");
+    run(n, m, 0, indexes, vins, sp_of);
+    for (int batch = 256; batch <= SALE_BATCH * 4; batch *= 16)
+        run(n, m, batch, indexes, vins, sp_of);
+
+    free(vins);
+    free(sp_of);
+    return 0;
+}
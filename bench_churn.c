@@ -0,0 +1,132 @@
+// Churn benchmark: a stock tree under millions of sell / restock cycles.
+// Each cycle sells a random car and restocks a new, higher VIN. Tracks
+// tree height and fill as the cycles run, for eager deletes, lazy deletes
+// (tombstones), and lazy deletes compacted after every day of sales, then
+// times searches and a full scan of the final tree and checks its contents.
+// Build: gcc -O2 -pthread -o bench_churn bench_churn.c
+// Run:   ./bench_churn [num_cars] [cycles] [sales_per_day]   (default 1000000 4000000 100000)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bptree.c"
+
+#define CHURN_CHECKPOINTS 8
+#define CHURN_LOOKUPS 1000000
+
+typedef enum ChurnMode {
+    CHURN_EAGER,
+    CHURN_LAZY,
+    CHURN_LAZY_COMPACT
+} ChurnMode;
+
+const char* churn_mode_names[] = { "eager", "lazy", "lazy+compact" };
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+unsigned churn_seed;
+
+unsigned churn_next() {
+    churn_seed = churn_seed * 1103515245u + 12345u;
+    return churn_seed >> 4;
+}
+
+void print_shape(const char* mode, long cycles, double ns_per_cycle, BPTreeNode* root) {
+    BPTreeStats st;
+    bptree_stats(root, &st);
+    printf("%-13s %-10ld %-7d %-9ld %-10.3f %-14.3f %-11.2f %-10.1f\n", mode, cycles, st.height, st.leaves,
+           st.leaf_fill, st.internal_fill, st.keys ? 100.0 * st.tombstones / st.keys : 0.0, ns_per_cycle);
+}
+
+// stock[] holds the VINs in the tree, in no particular order.
+void run_churn(ChurnMode mode, int n, long cycles, int per_day) {
+    int* stock = (int*)malloc(n * sizeof(int));
+    void** cars = (void**)malloc(n * sizeof(void*));
+    if (!stock || !cars) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    static int car;     // the tree only needs non-NULL data
+    for (int i = 0; i < n; i++) {
+        stock[i] = i + 1;
+        cars[i] = &car;
+    }
+    BPTreeNode* root = create_bptree();
+    bptree_bulk_load(&root, stock, cars, n, bptree_bulk_fill);
+    free(cars);
+
+    const char* name = churn_mode_names[mode];
+    print_shape(name, 0, 0, root);
+    churn_seed = 7;
+    int next_vin = n + 1;
+    long step = cycles / CHURN_CHECKPOINTS > 0 ? cycles / CHURN_CHECKPOINTS : 1;
+    double t0 = now_sec(), compact_time = 0;
+    for (long c = 1; c <= cycles; c++) {
+        int slot = (int)(churn_next() % (unsigned)n);
+        if (mode == CHURN_EAGER) bptree_delete(&root, stock[slot]);
+        else bptree_delete_lazy(&root, stock[slot]);
+        stock[slot] = next_vin++;
+        bptree_insert(&root, stock[slot], &car);
+
+        if (mode == CHURN_LAZY_COMPACT && c % per_day == 0) {
+            double tc = now_sec();
+            bptree_compact(&root);
+            compact_time += now_sec() - tc;
+        }
+        if (c % step == 0 || c == cycles) {
+            double elapsed = now_sec() - t0;
+            print_shape(name, c, elapsed * 1e9 / c, root);
+        }
+    }
+    if (mode == CHURN_LAZY_COMPACT)
+        printf("%-13s compaction: %.1f ms total, %.1f ns per cycle\n", name, compact_time * 1e3,
+               compact_time * 1e9 / cycles);
+
+    // The final tree: random searches, then a full scan that also checks it
+    long found = 0;
+    double t_search = now_sec();
+    for (int i = 0; i < CHURN_LOOKUPS; i++)
+        found += bptree_search(root, stock[churn_next() % (unsigned)n]) != NULL;
+    t_search = now_sec() - t_search;
+
+    BPTreeCursor cur;
+    int key, prev = 0;
+    long entries = 0, unsorted = 0;
+    double t_scan = now_sec();
+    bptree_cursor_first(&cur, root);
+    while (bptree_cursor_next(&cur, &key, NULL)) {
+        unsorted += entries > 0 && key <= prev;
+        prev = key;
+        entries++;
+    }
+    t_scan = now_sec() - t_scan;
+    printf("%-13s search %.1f ns/op, scan %.2f ns/entry\n", name, t_search * 1e9 / CHURN_LOOKUPS,
+           entries ? t_scan * 1e9 / entries : 0.0);
+    if (found != CHURN_LOOKUPS || entries != n || unsorted)
+        printf("%-13s BROKEN: %ld of %d lookups found, %ld of %d entries, %ld out of order\n", name, found,
+               CHURN_LOOKUPS, entries, n, unsorted);
+
+    bptree_destroy(root);
+    epoch_drain();
+    free(stock);
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    long cycles = argc > 2 ? atol(argv[2]) : 4000000;
+    int per_day = argc > 3 ? atoi(argv[3]) : 100000;
+    if (n < 1) n = 1;
+    if (per_day < 1) per_day = 1;
+
+    printf("%d cars, %ld sell/restock cycles, compaction every %d sales (order %d, bulk fill %.2f)\n", n,
+           cycles, per_day, BPTREE_DEFAULT_ORDER, bptree_bulk_fill);
+    printf("%-13s %-10s %-7s %-9s %-10s %-14s %-11s %-10s\n", "mode", "cycles", "height", "leaves", "leaf fill",
+           "internal fill", "tombstone%", "ns/cycle");
+    for (int mode = CHURN_EAGER; mode <= CHURN_LAZY_COMPACT; mode++)
+        run_churn((ChurnMode)mode, n, cycles, per_day);
+    return 0;
+}
@@ -0,0 +1,183 @@
+// Leaderboard benchmark: dashboard queries (top 10, rank, achieved range)
+// against full scans of every salesperson tree, and the cost the leaderboard
+// adds to crediting sales from several terminal threads.
+// Build: gcc -O2 -pthread -o bench_leaderboard bench_leaderboard.c
+// Run:   ./bench_leaderboard [salespersons] [threads]   (default 100000 4)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "bptree.c"
+
+#define BENCH_SHOWROOMS 10
+#define BENCH_CREDITS 500000      // per thread
+#define BENCH_QUERIES 2000
+
+typedef struct CreditWorker {
+    pthread_t thread;
+    Salesperson** sps;
+    int n;
+    unsigned seed;
+} CreditWorker;
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void* credit_worker(void* arg) {
+    CreditWorker* w = (CreditWorker*)arg;
+    for (int i = 0; i < BENCH_CREDITS; i++) {
+        w->seed = w->seed * 1103515245u + 12345u;
+        Salesperson* sp = w->sps[(w->seed >> 8) % w->n];
+        salesperson_credit(sp, 500000 + (w->seed >> 20) % 50 * 20000);
+    }
+    return NULL;
+}
+
+double run_credits(Salesperson** sps, int n, int threads) {
+    CreditWorker* w = (CreditWorker*)calloc(threads, sizeof(CreditWorker));
+    double t0 = now_sec();
+    for (int t = 0; t < threads; t++) {
+        w[t].sps = sps;
+        w[t].n = n;
+        w[t].seed = 17 + t;
+        pthread_create(&w[t].thread, NULL, credit_worker, &w[t]);
+    }
+    for (int t = 0; t < threads; t++)
+        pthread_join(w[t].thread, NULL);
+    double t = now_sec() - t0;
+    free(w);
+    return t;
+}
+
+// What find_most_successful_sales_person used to do.
+Salesperson* scan_best(Showroom* showrooms, int count) {
+    Salesperson* best = NULL;
+    for (int i = 0; i < count; i++) {
+        BPTreeCursor cur;
+        void* data;
+        bptree_cursor_first(&cur, showrooms[i].salespersons);
+        while (bptree_cursor_next(&cur, NULL, &data)) {
+            Salesperson* sp = (Salesperson*)data;
+            if (!best || sp->achieved > best->achieved) best = sp;
+        }
+    }
+    return best;
+}
+
+long scan_range(Showroom* showrooms, int count, float lo, float hi) {
+    long n = 0;
+    for (int i = 0; i < count; i++) {
+        BPTreeCursor cur;
+        void* data;
+        bptree_cursor_first(&cur, showrooms[i].salespersons);
+        while (bptree_cursor_next(&cur, NULL, &data)) {
+            Salesperson* sp = (Salesperson*)data;
+            n += sp->achieved >= lo && sp->achieved <= hi;
+        }
+    }
+    return n;
+}
+
+// Checks the treap: ordered, sizes right, keys equal to the live totals.
+long check_node(const LeaderNode* t, const LeaderNode** prev, int* ok) {
+    if (!t) return 0;
+    long n = check_node(t->left, prev, ok);
+    if (*prev && !leader_before(*prev, t)) *ok = 0;
+    if (t->achieved != t->sp->achieved || t->sp->rank_node != t) *ok = 0;
+    *prev = t;
+    n += 1 + check_node(t->right, prev, ok);
+    if (n != t->size) *ok = 0;
+    return n;
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 100000;
+    int threads = argc > 2 ? atoi(argv[2]) : 4;
+
+    Showroom showrooms[BENCH_SHOWROOMS];
+    Salesperson** sps = (Salesperson**)malloc(n * sizeof(Salesperson*));
+    for (int i = 0; i < BENCH_SHOWROOMS; i++)
+        showroom_init(&showrooms[i], i + 1, 1);
+    double t0 = now_sec();
+    for (int i = 0; i < n; i++) {
+        char name[NAME_LEN];
+        snprintf(name, sizeof(name), "Seller%d", i);
+        sps[i] = showroom_add_salesperson(&showrooms[i % BENCH_SHOWROOMS], i / BENCH_SHOWROOMS + 1, name, 50.0);
+    }
+    printf("%d salespersons in %d showrooms, added in %.3f s\n", n, BENCH_SHOWROOMS, now_sec() - t0);
+
+    // 1. Crediting sales with and without leaderboard upkeep
+    LeaderNode** nodes = (LeaderNode**)malloc(n * sizeof(LeaderNode*));
+    for (int i = 0; i < n; i++) {
+        nodes[i] = sps[i]->rank_node;
+        sps[i]->rank_node = NULL;
+    }
+    double t_plain = run_credits(sps, n, threads);
+    for (int i = 0; i < n; i++)
+        sps[i]->rank_node = nodes[i];
+    for (int i = 0; i < n; i++)
+        leaderboard_update(&leaderboard, sps[i]);
+    double t_ranked = run_credits(sps, n, threads);
+    long credits = (long)BENCH_CREDITS * threads;
+    printf("credit, %d threads: %.0f ns/sale without leaderboard, %.0f ns/sale with\n",
+           threads, t_plain * 1e9 / credits, t_ranked * 1e9 / credits);
+
+    int ok = 1;
+    const LeaderNode* prev = NULL;
+    if (check_node(leaderboard.root, &prev, &ok) != n) ok = 0;
+
+    // 2. Dashboard queries
+    LeaderEntry top[10];
+    t0 = now_sec();
+    for (int q = 0; q < BENCH_QUERIES; q++)
+        leaderboard_top(&leaderboard, 10, top);
+    double t_top = (now_sec() - t0) / BENCH_QUERIES;
+    t0 = now_sec();
+    Salesperson* best = NULL;
+    for (int q = 0; q < 20; q++)
+        best = scan_best(showrooms, BENCH_SHOWROOMS);
+    double t_scan = (now_sec() - t0) / 20;
+    if (best->achieved != top[0].achieved) ok = 0;
+
+    t0 = now_sec();
+    long rank_sum = 0;
+    for (int q = 0; q < BENCH_QUERIES; q++)
+        rank_sum += leaderboard_rank(&leaderboard, sps[(q * 7919) % n]);
+    double t_rank = (now_sec() - t0) / BENCH_QUERIES;
+
+    float lo = top[9].achieved * 0.9f, hi = top[9].achieved;
+    LeaderEntry* range = NULL;
+    long matches = 0;
+    t0 = now_sec();
+    for (int q = 0; q < BENCH_QUERIES; q++) {
+        free(range);
+        matches = leaderboard_range(&leaderboard, lo, hi, &range);
+    }
+    double t_range = (now_sec() - t0) / BENCH_QUERIES;
+    t0 = now_sec();
+    long scanned = 0;
+    for (int q = 0; q < 20; q++)
+        scanned = scan_range(showrooms, BENCH_SHOWROOMS, lo, hi);
+    double t_scan_range = (now_sec() - t0) / 20;
+    if (scanned != matches) ok = 0;
+    for (long i = 1; i < matches; i++)
+        if (range[i].rank != range[i - 1].rank + 1) ok = 0;
+    free(range);
+
+    printf("%-22s %12s %12s\n", "query", "leaderboard", "full scan");
+    printf("%-22s %10.2f us %10.2f us\n", "top 10 / best", t_top * 1e6, t_scan * 1e6);
+    printf("%-22s %10.2f us %12s\n", "rank of salesperson", t_rank * 1e6, "-");
+    printf("%-22s %10.2f us %10.2f us  (%ld matches)\n", "achieved range", t_range * 1e6, t_scan_range * 1e6, matches);
+    printf("check: %s\n", ok && rank_sum > 0 ? "ok" : "MISMATCH");
+
+    for (int i = 0; i < BENCH_SHOWROOMS; i++)
+        showroom_destroy(&showrooms[i]);
+    printf("left on the leaderboard after destroy: %ld\n", leaderboard_size(&leaderboard));
+    free(sps);
+    free(nodes);
+    return 0;
+}
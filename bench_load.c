@@ -0,0 +1,84 @@
+// Showroom load benchmark: malloc-per-record vs per-showroom arena.
+// Build: gcc -O2 -pthread -o bench_load bench_load.c
+// Run:   ./bench_load [num_cars]         (default 1000000, POSIX only)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "bptree.c"
+
+#define BENCH_FILE "bench_inventory.txt"
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void write_inventory(int n) {
+    const char* names[] = { "Swift", "Baleno", "Creta", "Fortuner", "Nexon", "City" };
+    const char* colors[] = { "White", "Black", "Red", "Blue", "Grey" };
+    const char* fuels[] = { "Petrol", "Diesel", "CNG" };
+    const char* types[] = { "Hatchback", "Sedan", "SUV" };
+    FILE* f = fopen(BENCH_FILE, "w");
+    for (int i = 1; i <= n; i++) {
+        fprintf(f, "%d %s %s %s %s %d\n", i, names[i % 6], colors[i % 5], fuels[i % 3], types[i % 3],
+                500000 + (i % 50) * 20000);
+    }
+    fclose(f);
+}
+
+// Runs in a forked child so ru_maxrss covers this mode only.
+void run(int use_arena, int n) {
+    Showroom s;
+    showroom_init(&s, 1, use_arena);
+
+    double t0 = now_sec();
+    load_showroom_data(&s, BENCH_FILE);
+    double t_load = now_sec() - t0;
+
+    // Sell every tenth car: exercises node frees and the sold tree
+    t0 = now_sec();
+    for (int vin = 1; vin <= n; vin += 10) {
+        Car* c = (Car*)bptree_search(s.available_stock, vin);
+        bptree_delete(&s.available_stock, vin);
+        bptree_insert(&s.sold_stock, vin, c);
+    }
+    double t_sell = now_sec() - t0;
+    long mallocs = arena_stats.mallocs;
+    size_t bytes = arena_stats.bytes;
+
+    t0 = now_sec();
+    showroom_destroy(&s);
+    double t_free = now_sec() - t0;
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    printf("%-7s %-10.3f %-10.3f %-10.6f %-12ld %-12zu %-10ld\n", use_arena ? "arena" : "malloc",
+           t_load, t_sell, t_free, mallocs, bytes, ru.ru_maxrss);
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    write_inventory(n);
+
+    printf("%d cars\n", n);
+    printf("%-7s %-10s %-10s %-10s %-12s %-12s %-10s\n", "mode", "load s", "sell s", "free s",
+           "mallocs", "bytes", "peak KB");
+    fflush(stdout);
+    for (int use_arena = 0; use_arena <= 1; use_arena++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            run(use_arena, n);
+            fflush(stdout);
+            _exit(0);
+        }
+        waitpid(pid, NULL, 0);
+    }
+
+    remove(BENCH_FILE);
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Loan portfolio benchmark: a month-end run over every loan, collecting the
+// book from the payment-code index and amortizing it with the scalar and
+// the vector kernel, against stepping each schedule month by month.
+// Build: gcc -O2 -pthread -o bench_loan bench_loan.c
+// Run:   ./bench_loan [num_sales] [showrooms]   (default 500000 4)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bptree.c"
+
+#define BENCH_RUNS 20
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Sold cars dated 2019..2024; one in four was paid in cash.
+void stock_sold(Showroom* s, int first_vin, int n, unsigned seed) {
+    int* keys = (int*)malloc(n * sizeof(int));
+    void** cars = (void**)malloc(n * sizeof(void*));
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        Car* car = (Car*)arena_alloc(s->arena, sizeof(Car));
+        memset(car, 0, sizeof(Car));
+        car->vin = first_vin + i;
+        car->price = 500000 + (seed >> 8) % 100 * 20000;
+        car->sale = (Sale*)arena_alloc(s->arena, sizeof(Sale));
+        memset(car->sale, 0, sizeof(Sale));
+        car->sale->payment_code = (seed >> 16) % 4;
+        strcpy(car->sale->payment_method, car->sale->payment_code ? "Loan" : "Cash");
+        car->sale->d_o_prchse = 15 * 1000000 + (1 + (seed >> 4) % 12) * 10000 + 2019 + (seed >> 12) % 6;
+        keys[i] = car->vin;
+        cars[i] = car;
+    }
+    bptree_bulk_load(&s->sold_stock, keys, cars, n, bptree_bulk_fill);
+    free(keys);
+    free(cars);
+}
+
+// The textbook way: walk each schedule one installment at a time.
+double step_schedules(const LoanBook* b, int as_of_month, double* outstanding) {
+    double interest = 0;
+    for (long i = 0; i < b->n; i++) {
+        int k = as_of_month - b->start[i];
+        k = k < 0 ? 0 : k > b->months[i] ? b->months[i] : k;
+        double left = b->principal[i], r = b->rate[i];
+        for (int m = 0; m < k; m++) {
+            double due = left * r;
+            interest += due;
+            left -= b->emi[i] - due;
+        }
+        outstanding[i] = left;
+    }
+    return interest;
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 500000;
+    int count = argc > 2 ? atoi(argv[2]) : 4;
+    if (count < 1) count = 1;
+    int per = n / count;
+
+    Showroom* showrooms = (Showroom*)malloc(count * sizeof(Showroom));
+    for (int i = 0; i < count; i++) {
+        showroom_init(&showrooms[i], i + 1, 1);
+        stock_sold(&showrooms[i], 1 + i * per, per, 11 + i);
+    }
+    double t0 = now_sec();
+    for (int i = 0; i < count; i++)
+        showroom_enable_indexes(&showrooms[i], IDX_PAYMENT);
+    double t_index = now_sec() - t0;
+
+    LoanBook b;
+    loan_book_init(&b);
+    t0 = now_sec();
+    loan_book_collect(&b, showrooms, count);
+    double t_collect = now_sec() - t0;
+
+    int as_of = ts_month_number(31122024);
+    t0 = now_sec();
+    for (int r = 0; r < BENCH_RUNS; r++)
+        loan_amortize_scalar(&b, as_of - r);
+    double t_scalar = (now_sec() - t0) / BENCH_RUNS;
+    double* emi = (double*)malloc((b.n ? b.n : 1) * sizeof(double));
+    double* left = (double*)malloc((b.n ? b.n : 1) * sizeof(double));
+    double* interest = (double*)malloc((b.n ? b.n : 1) * sizeof(double));
+    loan_amortize_scalar(&b, as_of);
+    memcpy(emi, b.emi, b.n * sizeof(double));
+    memcpy(left, b.outstanding, b.n * sizeof(double));
+    memcpy(interest, b.interest, b.n * sizeof(double));
+
+    const char* kernel = loan_amortize_name();
+    t0 = now_sec();
+    for (int r = 0; r < BENCH_RUNS; r++)
+        loan_amortize(&b, as_of - r);
+    double t_vector = (now_sec() - t0) / BENCH_RUNS;
+    loan_amortize(&b, as_of);
+    int ok = memcmp(emi, b.emi, b.n * sizeof(double)) == 0 &&
+             memcmp(left, b.outstanding, b.n * sizeof(double)) == 0 &&
+             memcmp(interest, b.interest, b.n * sizeof(double)) == 0;
+
+    t0 = now_sec();
+    double stepped_interest = step_schedules(&b, as_of, left);
+    double t_step = now_sec() - t0;
+    double total_interest = 0;
+    for (long i = 0; i < b.n; i++) {
+        total_interest += b.interest[i];
+        double d = left[i] - b.outstanding[i];
+        if (d > 0.01 || d < -0.01) ok = 0;
+    }
+    double d = stepped_interest - total_interest;
+    if (d > 1.0 || d < -1.0) ok = 0;
+
+    printf("%ld loans out of %d sales in %d showrooms\n", b.n, per * count, count);
+    printf("%-28s %10.2f ms\n", "payment index build", t_index * 1e3);
+    printf("%-28s %10.2f ms\n", "collect from index", t_collect * 1e3);
+    printf("%-28s %10.2f ms\n", "amortize, scalar", t_scalar * 1e3);
+    printf("%-28s %10.2f ms\n", kernel[0] == 's' ? "amortize, scalar (no simd)" : "amortize, avx2", t_vector * 1e3);
+    printf("%-28s %10.2f ms\n", "step every schedule", t_step * 1e3);
+    printf("check: %s\n", ok ? "ok" : "MISMATCH");
+
+    loan_book_free(&b);
+    for (int i = 0; i < count; i++)
+        showroom_destroy(&showrooms[i]);
+    free(showrooms);
+    free(emi);
+    free(left);
+    free(interest);
+    return 0;
+}
@@ -0,0 +1,168 @@
+// VIN lookup benchmark for display_car_info: rescanning the inventory text
+// (the old way) against searching every showroom's trees and the VIN
+// directory, one VIN at a time and in batches.
+// Build: gcc -O2 -pthread -o bench_lookup bench_lookup.c
+// Run:   ./bench_lookup [num_cars] [showrooms]   (default 4000000 4; writes bench_lookup.txt)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bptree.c"
+
+#define BENCH_FILE "bench_lookup.txt"
+#define BENCH_PROBES 2000000
+#define BENCH_SCANS 5
+#define BENCH_BATCH 4096
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int random_int(int bound) {
+    return (int)(((long long)rand() * RAND_MAX + rand()) % bound);
+}
+
+// Showroom r stocks VINs r + 1, r + 1 + count, ...; every tenth car is sold.
+void stock_showrooms(Showroom* showrooms, int count, int n, FILE* text) {
+    int per = n / count;
+    int* keys = (int*)malloc(per * sizeof(int));
+    void** cars = (void**)malloc(per * sizeof(void*));
+    int* sold_keys = (int*)malloc(per * sizeof(int));
+    void** sold = (void**)malloc(per * sizeof(void*));
+    int model = dict_intern(&car_models, "Creta", 5), color = dict_intern(&car_colors, "White", 5);
+    int fuel = dict_intern(&car_fuels, "Petrol", 6), type = dict_intern(&car_types, "SUV", 3);
+    for (int r = 0; r < count; r++) {
+        Showroom* s = &showrooms[r];
+        showroom_init(s, r + 1, 1);
+        int na = 0, ns = 0;
+        for (int i = 0; i < per; i++) {
+            Car* car = (Car*)arena_alloc(s->arena, sizeof(Car));
+            car->vin = r + 1 + i * count;
+            car->price = 500000 + (i % 50) * 20000;
+            car->model = model;
+            car->color = color;
+            car->fuel = fuel;
+            car->type = type;
+            car->sale = NULL;
+            fprintf(text, "%d Creta White Petrol SUV %.0f\n", car->vin, car->price);
+            if (i % 10 == 9) {
+                car->sale = (Sale*)arena_alloc(s->arena, sizeof(Sale));
+                memset(car->sale, 0, sizeof(Sale));
+                sold_keys[ns] = car->vin;
+                sold[ns++] = car;
+            } else {
+                keys[na] = car->vin;
+                cars[na++] = car;
+            }
+        }
+        bptree_bulk_load(&s->available_stock, keys, cars, na, bptree_bulk_fill);
+        bptree_bulk_load(&s->sold_stock, sold_keys, sold, ns, bptree_bulk_fill);
+    }
+    free(keys);
+    free(cars);
+    free(sold_keys);
+    free(sold);
+}
+
+// The old display_car_info: sscanf every line until the VIN turns up.
+int scan_text(int vin) {
+    FILE* f = fopen(BENCH_FILE, "r");
+    char line[256];
+    int found = 0;
+    while (!found && fgets(line, sizeof(line), f)) {
+        int v;
+        char name[64], color[64], fuel[64], type[64];
+        float price;
+        sscanf(line, "%d %s %s %s %s %f", &v, name, color, fuel, type, &price);
+        found = v == vin;
+    }
+    fclose(f);
+    return found;
+}
+
+int search_trees(Showroom* showrooms, int count, int vin) {
+    for (int r = 0; r < count; r++) {
+        if (bptree_search(showrooms[r].available_stock, vin)) return 1;
+        if (bptree_search(showrooms[r].sold_stock, vin)) return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 4000000;
+    int count = argc > 2 ? atoi(argv[2]) : 4;
+    if (count < 1) count = 1;
+    n = n / count * count;
+
+    FILE* text = fopen(BENCH_FILE, "w");
+    Showroom* showrooms = (Showroom*)malloc(count * sizeof(Showroom));
+    stock_showrooms(showrooms, count, n, text);
+    fclose(text);
+
+    double t0 = now_sec();
+    for (int r = 0; r < count; r++)
+        vindir_add_showroom(&vin_directory, &showrooms[r]);
+    printf("%d cars in %d showrooms; directory built in %.3f s (%ld slots)\n",
+           n, count, now_sec() - t0, vin_directory.num_slots);
+
+    // One VIN in twenty is unknown
+    int* vins = (int*)malloc(BENCH_PROBES * sizeof(int));
+    srand(3);
+    for (int i = 0; i < BENCH_PROBES; i++)
+        vins[i] = 1 + random_int(n + n / 19);
+
+    t0 = now_sec();
+    long found_scan = 0;
+    for (int i = 0; i < BENCH_SCANS; i++)
+        found_scan += scan_text(vins[i]);
+    double t_scan = (now_sec() - t0) / BENCH_SCANS;
+
+    t0 = now_sec();
+    long found_tree = 0;
+    for (int i = 0; i < BENCH_PROBES; i++)
+        found_tree += search_trees(showrooms, count, vins[i]);
+    double t_tree = (now_sec() - t0) / BENCH_PROBES;
+
+    VinLookup* out = (VinLookup*)malloc(BENCH_PROBES * sizeof(VinLookup));
+    t0 = now_sec();
+    long found_dir = 0, sold = 0;
+    for (int i = 0; i < BENCH_PROBES; i++) {
+        found_dir += vindir_lookup(&vin_directory, vins[i], &out[i]);
+        sold += out[i].sold;
+    }
+    double t_dir = (now_sec() - t0) / BENCH_PROBES;
+
+    t0 = now_sec();
+    long found_batch = 0;
+    for (int i = 0; i < BENCH_PROBES; i += BENCH_BATCH) {
+        int m = BENCH_PROBES - i < BENCH_BATCH ? BENCH_PROBES - i : BENCH_BATCH;
+        found_batch += vindir_lookup_batch(&vin_directory, vins + i, m, out + i);
+    }
+    double t_batch = (now_sec() - t0) / BENCH_PROBES;
+
+    long wrong = 0;
+    for (int i = 0; i < BENCH_PROBES; i++) {
+        if (!out[i].car) continue;
+        wrong += out[i].car->vin != vins[i] || out[i].showroom->showroom_id != (vins[i] - 1) % count + 1 ||
+                 out[i].sold != (out[i].car->sale != NULL);
+    }
+
+    printf("%-20s %14s\n", "method", "ns/lookup");
+    printf("%-20s %14.0f  (%d probes)\n", "text rescan", t_scan * 1e9, BENCH_SCANS);
+    printf("%-20s %14.1f\n", "every showroom tree", t_tree * 1e9);
+    printf("%-20s %14.1f\n", "directory", t_dir * 1e9);
+    printf("%-20s %14.1f  (batches of %d)\n", "directory batch", t_batch * 1e9, BENCH_BATCH);
+    printf("found %ld of %d, %ld sold%s\n", found_dir, BENCH_PROBES, sold,
+           found_dir == found_tree && found_dir == found_batch && wrong == 0 ? "" : "  MISMATCH");
+
+    for (int r = 0; r < count; r++)
+        showroom_destroy(&showrooms[r]);
+    vindir_free(&vin_directory);
+    free(showrooms);
+    free(vins);
+    free(out);
+    remove(BENCH_FILE);
+    return 0;
+}
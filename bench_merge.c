@@ -0,0 +1,131 @@
+// Catalog merge benchmark: the old per-showroom concatenation against the
+// k-way heap merge, in text and binary form, as the number of showrooms grows.
+// Build: gcc -O2 -pthread -o bench_merge bench_merge.c
+// Run:   ./bench_merge [num_cars] [max_showrooms]   (default 2000000 64; writes bench_merge.txt/.bin)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bptree.c"
+
+#define BENCH_TEXT "bench_merge.txt"
+#define BENCH_BIN "bench_merge.bin"
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int random_int(int bound) {
+    return (int)(((long long)rand() * RAND_MAX + rand()) % bound);
+}
+
+// Deals VINs 1..n out to random showrooms; one VIN in a thousand is also
+// stocked by a second showroom. Returns the number of duplicates.
+long stock_showrooms(Showroom* showrooms, int count, int n) {
+    int** keys = (int**)malloc(count * sizeof(int*));
+    void*** cars = (void***)malloc(count * sizeof(void**));
+    int* used = (int*)calloc(count, sizeof(int));
+    for (int i = 0; i < count; i++) {
+        showroom_init(&showrooms[i], i + 1, 1);
+        keys[i] = (int*)malloc((n / count * 2 + 16) * sizeof(int));
+        cars[i] = (void**)malloc((n / count * 2 + 16) * sizeof(void*));
+    }
+    int model = dict_intern(&car_models, "Creta", 5), color = dict_intern(&car_colors, "White", 5);
+    int fuel = dict_intern(&car_fuels, "Petrol", 6), type = dict_intern(&car_types, "SUV", 3);
+    long dups = 0;
+    for (int vin = 1; vin <= n; vin++) {
+        int copies = count > 1 && vin % 1000 == 0 ? 2 : 1;
+        int first = random_int(count);
+        for (int c = 0; c < copies; c++) {
+            int r = (first + c) % count;
+            if (used[r] == n / count * 2 + 16) continue;
+            Car* car = (Car*)arena_alloc(showrooms[r].arena, sizeof(Car));
+            car->vin = vin;
+            car->price = 500000 + (vin % 50) * 20000;
+            car->model = model;
+            car->color = color;
+            car->fuel = fuel;
+            car->type = type;
+            car->sale = NULL;
+            keys[r][used[r]] = vin;
+            cars[r][used[r]++] = car;
+            dups += c;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        bptree_bulk_load(&showrooms[i].available_stock, keys[i], cars[i], used[i], bptree_bulk_fill);
+        free(keys[i]);
+        free(cars[i]);
+    }
+    free(keys);
+    free(cars);
+    free(used);
+    return dups;
+}
+
+// What merge_and_sort_database used to do: one showroom after another.
+void concat_showrooms(Showroom* showrooms, int count, const char* path) {
+    FILE* f = fopen(path, "w");
+    for (int i = 0; i < count; i++) {
+        BPTreeCursor cur;
+        void* data;
+        bptree_cursor_first(&cur, showrooms[i].available_stock);
+        while (bptree_cursor_next(&cur, NULL, &data)) {
+            Car* car = (Car*)data;
+            fprintf(f, "%d %s %s %s %s %.2f\n", car->vin, car_name(car), car_color(car), car_fuel(car), car_type(car), car->price);
+        }
+    }
+    fclose(f);
+}
+
+// Reads the binary catalog back: VINs strictly increasing and the checksum intact.
+int check_catalog(const char* path, long expect) {
+    TextFile tf;
+    if (!text_file_open(&tf, path)) return 0;
+    const MergeHeader* h = (const MergeHeader*)tf.data;
+    int ok = tf.size >= MERGE_HEADER_BYTES && memcmp(h->magic, MERGE_MAGIC, 8) == 0 && (long)h->num_cars == expect &&
+             crc32c_update(0, tf.data + MERGE_HEADER_BYTES, tf.size - MERGE_HEADER_BYTES) == h->body_crc;
+    const MergeRecord* r = (const MergeRecord*)(tf.data + h->cars_off);
+    for (unsigned long long i = 1; ok && i < h->num_cars; i++)
+        ok = r[i - 1].vin < r[i].vin;
+    text_file_close(&tf);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 2000000;
+    int max_showrooms = argc > 2 ? atoi(argv[2]) : 64;
+    srand(5);
+
+    printf("%d cars\n", n);
+    printf("%-10s %-12s %-14s %-14s %-10s %-10s\n", "showrooms", "concat s", "merge text s", "merge bin s", "dups", "check");
+    for (int count = 1; count <= max_showrooms; count *= 4) {
+        Showroom* showrooms = (Showroom*)malloc(count * sizeof(Showroom));
+        long dups = stock_showrooms(showrooms, count, n);
+
+        double t0 = now_sec();
+        concat_showrooms(showrooms, count, BENCH_TEXT);
+        double t_concat = now_sec() - t0;
+
+        MergeStats text, bin;
+        t0 = now_sec();
+        merge_showrooms(showrooms, count, BENCH_TEXT, MERGE_TEXT, &text);
+        double t_text = now_sec() - t0;
+        t0 = now_sec();
+        merge_showrooms(showrooms, count, BENCH_BIN, MERGE_BINARY, &bin);
+        double t_bin = now_sec() - t0;
+
+        int ok = text.cars == n && bin.cars == n && bin.duplicates == dups && check_catalog(BENCH_BIN, n);
+        printf("%-10d %-12.3f %-14.3f %-14.3f %-10ld %-10s\n", count, t_concat, t_text, t_bin, bin.duplicates,
+               ok ? "ok" : "MISMATCH");
+
+        for (int i = 0; i < count; i++)
+            showroom_destroy(&showrooms[i]);
+        free(showrooms);
+    }
+    remove(BENCH_TEXT);
+    remove(BENCH_BIN);
+    return 0;
+}
@@ -0,0 +1,63 @@
+// B+ tree order benchmark: insert / search latency for different node orders.
+// Build: gcc -O2 -pthread -o bench_order bench_order.c
+// Run:   ./bench_order [num_cars]        (default 1000000)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bptree.c"
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    int orders[] = { 4, 16, 64, 128 };
+
+    // Random permutation of VINs 1..n
+    int* vins = (int*)malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) vins[i] = i + 1;
+    srand(42);
+    for (int i = n - 1; i > 0; i--) {
+        int j = (int)(((long long)rand() * RAND_MAX + rand()) % (i + 1));
+        int t = vins[i]; vins[i] = vins[j]; vins[j] = t;
+    }
+
+    printf("%-6s %-7s %-14s %-14s %-14s\n", "order", "height", "insert ns/op", "search ns/op", "seq ins ns/op");
+    for (size_t o = 0; o < sizeof(orders) / sizeof(orders[0]); o++) {
+        // Random-order inserts
+        BPTreeNode* root = create_bptree_order(orders[o]);
+        double t0 = now_sec();
+        for (int i = 0; i < n; i++)
+            bptree_insert(&root, vins[i], &vins[i]);
+        double t_insert = now_sec() - t0;
+
+        // Random-order lookups
+        long found = 0;
+        t0 = now_sec();
+        for (int i = 0; i < n; i++)
+            found += bptree_search(root, vins[n - 1 - i]) != NULL;
+        double t_search = now_sec() - t0;
+        if (found != n) printf("order %d: only %ld of %d keys found!\n", orders[o], found, n);
+
+        int height = bptree_height(root);
+        bptree_destroy(root);
+
+        // Sorted inserts, the shape of showroom*.txt
+        root = create_bptree_order(orders[o]);
+        t0 = now_sec();
+        for (int i = 0; i < n; i++)
+            bptree_insert(&root, i + 1, &vins[i]);
+        double t_seq = now_sec() - t0;
+        bptree_destroy(root);
+
+        printf("%-6d %-7d %-14.1f %-14.1f %-14.1f\n", orders[o], height,
+               t_insert * 1e9 / n, t_search * 1e9 / n, t_seq * 1e9 / n);
+    }
+
+    free(vins);
+    return 0;
+}
@@ -0,0 +1,92 @@
+// Inventory parser benchmark: legacy fscanf loop vs mapped tokenizer.
+// Build: gcc -O2 -pthread -o bench_parse bench_parse.c
+// Run:   ./bench_parse [megabytes]       (default 1024)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bptree.c"
+
+#define BENCH_FILE "bench_parse.txt"
+
+// The Car layout the old loader scanned into
+typedef struct LegacyCar {
+    int vin;
+    char name[NAME_LEN];
+    char color[NAME_LEN];
+    float price;
+    char fuel[NAME_LEN];
+    char type[NAME_LEN];
+} LegacyCar;
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+long write_inventory(long megabytes) {
+    const char* names[] = { "Swift", "Baleno", "Creta", "Fortuner", "Nexon", "City", "Innova", "Verna" };
+    const char* colors[] = { "White", "Black", "Red", "Blue", "Grey", "Silver" };
+    const char* fuels[] = { "Petrol", "Diesel", "CNG", "Electric" };
+    const char* types[] = { "Hatchback", "Sedan", "SUV", "MUV" };
+    FILE* f = fopen(BENCH_FILE, "w");
+    long bytes = 0, rows = 0;
+    while (bytes < megabytes << 20) {
+        rows++;
+        bytes += fprintf(f, "%ld  %s  %s  %s  %s  %ld\r\n", rows, names[rows % 8], colors[rows % 6],
+                         fuels[rows % 4], types[rows % 4], 500000 + (rows % 97) * 10000);
+    }
+    fclose(f);
+    return rows;
+}
+
+long parse_fscanf() {
+    FILE* f = fopen(BENCH_FILE, "r");
+    LegacyCar car;
+    long rows = 0;
+    while (!feof(f)) {
+        if (fscanf(f, "%d %s %s %s %s %f", &car.vin, car.name, car.color, car.fuel, car.type, &car.price) != 6)
+            break;
+        rows++;
+    }
+    fclose(f);
+    return rows;
+}
+
+long parse_mapped() {
+    TextFile tf;
+    text_file_open(&tf, BENCH_FILE);
+    LineScanner sc;
+    scanner_init(&sc, BENCH_FILE, tf.data, tf.size);
+    Car car;
+    long rows = 0;
+    while (scanner_next_line(&sc)) {
+        if (parse_car_line(&sc, &car)) rows++;
+    }
+    text_file_close(&tf);
+    return rows;
+}
+
+int main(int argc, char** argv) {
+    long megabytes = argc > 1 ? atol(argv[1]) : 1024;
+    printf("generating %ld MB...\n", megabytes);
+    long rows = write_inventory(megabytes);
+
+    double t0 = now_sec();
+    long rows_fscanf = parse_fscanf();
+    double t_fscanf = now_sec() - t0;
+
+    t0 = now_sec();
+    long rows_mapped = parse_mapped();
+    double t_mapped = now_sec() - t0;
+
+    printf("%-8s %-12s %-10s %-10s\n", "parser", "rows", "seconds", "MB/s");
+    printf("%-8s %-12ld %-10.3f %-10.1f\n", "fscanf", rows_fscanf, t_fscanf, megabytes / t_fscanf);
+    printf("%-8s %-12ld %-10.3f %-10.1f\n", "mapped", rows_mapped, t_mapped, megabytes / t_mapped);
+    if (rows_fscanf != rows || rows_mapped != rows)
+        printf("row count mismatch: generated %ld\n", rows);
+
+    remove(BENCH_FILE);
+    return 0;
+}
@@ -0,0 +1,102 @@
+// Batch query benchmark: what a nightly job pays per report when it
+// relaunches the binary (a full load each time) against running all of its
+// queries as one batch on a single load (see query.c). The queries are a mix
+// of VIN lookups, the leaderboard, breakdowns and sales-range searches; their
+// output is discarded.
+// Build: gcc -O2 -pthread -o bench_query bench_query.c
+// Run:   ./gen_data -d data -c 100000 && ./bench_query -d data
+//        ./bench_query [-d dir] [-n queries] [-j threads]   (defaults: . 10000 one per CPU)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "bptree.c"
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    const char* dir = ".";
+    long n = 10000;
+    int threads = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-d") == 0) dir = argv[i + 1];
+        else if (strcmp(argv[i], "-n") == 0) n = atol(argv[i + 1]);
+        else if (strcmp(argv[i], "-j") == 0) threads = atoi(argv[i + 1]);
+    }
+    if (n < 1) n = 1;
+    if (chdir(dir) != 0) {
+        perror(dir);
+        return 1;
+    }
+    int count = discover_showrooms();
+    if (count == 0) {
+        fprintf(stderr, "no showroom files in %s (generate some with gen_data)\n", dir);
+        return 1;
+    }
+
+    // Results go to the real stdout; everything the library prints goes nowhere
+    FILE* out = fdopen(dup(STDOUT_FILENO), "w");
+    fflush(stdout);
+    if (!out || !freopen("/dev/null", "w", stdout)) {
+        perror("stdout");
+        return 1;
+    }
+    report_log_level = LOG_QUIET;
+
+    Showroom* showrooms = (Showroom*)malloc(count * sizeof(Showroom));
+    double t0 = now_sec();
+    for (int i = 0; i < count; i++)
+        showroom_init(&showrooms[i], i + 1, 1);
+    load_all_showrooms(showrooms, count, threads);
+    double t_load = now_sec() - t0;
+
+    int max_vin = 0;
+    for (int i = 0; i < count; i++) {
+        BPTreeNode* trees[2] = { showrooms[i].available_stock, showrooms[i].sold_stock };
+        for (int t = 0; t < 2; t++) {
+            BPTreeCursor cur;
+            int key;
+            bptree_cursor_first(&cur, trees[t]);
+            while (bptree_cursor_next(&cur, &key, NULL))
+                if (key > max_vin) max_vin = key;
+        }
+    }
+
+    QuerySession q;
+    query_session_init(&q, showrooms, count, 0);
+    char line[QUERY_LINE_LEN];
+    unsigned seed = 5;
+    t0 = now_sec();
+    for (long i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        switch (i % 8) {
+            case 0: snprintf(line, sizeof(line), "top 10"); break;
+            case 1: snprintf(line, sizeof(line), "breakdown %s", i % 16 < 8 ? "model" : "fuel"); break;
+            case 2: snprintf(line, sizeof(line), "sales-range %u %u", seed % 50, seed % 50 + 10); break;
+            default: snprintf(line, sizeof(line), "car %u", 1 + (seed >> 4) % (unsigned)(max_vin ? max_vin : 1)); break;
+        }
+        query_run(&q, line, "bench");
+    }
+    report_flush(&report);
+    double t_batch = now_sec() - t0;
+
+    double per_query = t_batch / n;
+    fprintf(out, "%d showroom(s), %ld queries, %ld failed\n", count, q.commands, q.failed);
+    fprintf(out, "load (one relaunch):  %10.3f ms\n", t_load * 1e3);
+    fprintf(out, "batch, all queries:   %10.3f ms\n", t_batch * 1e3);
+    fprintf(out, "batch, per query:     %10.3f us\n", per_query * 1e6);
+    fprintf(out, "relaunching per query would take %.1f s, %.0fx the batch\n", (t_load + per_query) * n,
+            (t_load + per_query) * n / (t_load + t_batch));
+    fclose(out);
+
+    for (int i = 0; i < count; i++)
+        showroom_destroy(&showrooms[i]);
+    vindir_free(&vin_directory);
+    free(showrooms);
+    return 0;
+}
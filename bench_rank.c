@@ -0,0 +1,101 @@
+// In-node rank microbenchmark: scalar vs binary search vs SSE2/AVX2.
+// Build: gcc -O2 -pthread -o bench_rank bench_rank.c
+// Run:   ./bench_rank [num_cars]        (default 1000000)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bptree.c"
+
+typedef struct RankImpl {
+    const char* name;
+    int (*fn)(const int* keys, int n, int key);
+} RankImpl;
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int random_int(int bound) {
+    return (int)(((long long)rand() * RAND_MAX + rand()) % bound);
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    RankImpl impls[4];
+    int num_impls = 0;
+
+    impls[num_impls++] = (RankImpl){ "scalar", bptree_rank_scalar };
+    impls[num_impls++] = (RankImpl){ "binary", bptree_rank_binary };
+#if BPTREE_HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+        impls[num_impls++] = (RankImpl){ "sse2", bptree_rank_sse2 };
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+        impls[num_impls++] = (RankImpl){ "avx2", bptree_rank_avx2 };
+#endif
+    printf("runtime selection: %s\n\n", bptree_rank_name());
+
+    // 1. Raw rank on a single node of each width
+    int widths[] = { 16, 32, 64, 128 };
+    int probes = 1 << 22;
+    int* probe_keys = (int*)malloc(probes * sizeof(int));
+    srand(7);
+    printf("%-8s %-6s %-10s\n", "impl", "keys", "ns/rank");
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+        int keys[128];
+        for (int i = 0; i < widths[w]; i++) keys[i] = (i + 1) * 10;
+        for (int i = 0; i < probes; i++) probe_keys[i] = random_int(widths[w] * 10 + 20);
+
+        for (int m = 0; m < num_impls; m++) {
+            long sink = 0;
+            double t0 = now_sec();
+            for (int i = 0; i < probes; i++)
+                sink += impls[m].fn(keys, widths[w], probe_keys[i]);
+            double t = now_sec() - t0;
+            // Cross-check against the scalar result
+            long expect = 0;
+            for (int i = 0; i < probes; i++)
+                expect += bptree_rank_scalar(keys, widths[w], probe_keys[i]);
+            printf("%-8s %-6d %-10.2f%s\n", impls[m].name, widths[w], t * 1e9 / probes,
+                   sink == expect ? "" : "  MISMATCH");
+        }
+    }
+    free(probe_keys);
+
+    // 2. Whole-tree VIN lookups, random and sequential order
+    int orders[] = { BPTREE_DEFAULT_ORDER, 127 };
+    int* vins = (int*)malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) vins[i] = i + 1;
+    for (int i = n - 1; i > 0; i--) {
+        int j = random_int(i + 1);
+        int t = vins[i]; vins[i] = vins[j]; vins[j] = t;
+    }
+
+    printf("\n%-8s %-6s %-14s %-14s\n", "impl", "order", "random ns/op", "seq ns/op");
+    for (size_t o = 0; o < sizeof(orders) / sizeof(orders[0]); o++) {
+        BPTreeNode* root = create_bptree_order(orders[o]);
+        for (int i = 0; i < n; i++)
+            bptree_insert(&root, i + 1, &vins[i]);
+
+        for (int m = 0; m < num_impls; m++) {
+            bptree_rank = impls[m].fn;
+            long found = 0;
+            double t0 = now_sec();
+            for (int i = 0; i < n; i++)
+                found += bptree_search(root, vins[i]) != NULL;
+            double t_rand = now_sec() - t0;
+            t0 = now_sec();
+            for (int i = 0; i < n; i++)
+                found += bptree_search(root, i + 1) != NULL;
+            double t_seq = now_sec() - t0;
+            printf("%-8s %-6d %-14.1f %-14.1f%s\n", impls[m].name, orders[o],
+                   t_rand * 1e9 / n, t_seq * 1e9 / n, found == 2L * n ? "" : "  MISSING KEYS");
+        }
+    }
+
+    free(vins);
+    return 0;
+}
@@ -0,0 +1,140 @@
+// Read-heavy benchmark: 95% VIN lookups, 5% sales, as threads scale.
+// Lookups take no latch, so read throughput should grow with the cores.
+// Build: gcc -O2 -pthread -o bench_read bench_read.c
+// Run:   ./bench_read [num_cars] [max_threads] [ops_per_thread]   (default 1000000 8 2000000)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "bptree.c"
+
+#define BENCH_WRITE_PERCENT 5
+
+typedef struct ReadWorker {
+    pthread_t thread;
+    Showroom* showroom;
+    Salesperson* sp;
+    int n;
+    long ops;
+    const int* sell_order;  // this worker's share of the shuffled VINs
+    int num_sell;
+    unsigned seed;
+    long reads, hits, writes, wrong;
+} ReadWorker;
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// xorshift, so workers do not contend on rand()'s state
+unsigned next_random(unsigned* s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+void* read_worker(void* arg) {
+    ReadWorker* w = (ReadWorker*)arg;
+    Sale sale;
+    memset(&sale, 0, sizeof(sale));
+    sale.d_o_prchse = 15062024;
+    int next_sale = 0;
+
+    for (long k = 0; k < w->ops; k++) {
+        unsigned r = next_random(&w->seed);
+        if (r % 100 < BENCH_WRITE_PERCENT && next_sale < w->num_sell) {
+            showroom_sell_car(w->showroom, w->sell_order[next_sale++], w->sp, &sale);
+            w->writes++;
+        } else {
+            int vin = 1 + (int)(next_random(&w->seed) % w->n);
+            Car* c = (Car*)bptree_search(w->showroom->available_stock, vin);
+            if (c) {
+                w->hits++;
+                if (c->vin != vin) w->wrong++;
+            }
+            w->reads++;
+        }
+    }
+    return NULL;
+}
+
+void stock_showroom(Showroom* s, Salesperson* sp, int n) {
+    showroom_init(s, 1, 1);
+    int* keys = (int*)malloc(n * sizeof(int));
+    void** cars = (void**)malloc(n * sizeof(void*));
+    for (int i = 0; i < n; i++) {
+        Car* c = (Car*)arena_alloc(s->arena, sizeof(Car));
+        c->vin = i + 1;
+        c->price = 500000 + (i % 50) * 20000;
+        c->model = c->color = c->fuel = c->type = 0;
+        c->sale = NULL;
+        keys[i] = c->vin;
+        cars[i] = c;
+    }
+    bptree_bulk_load(&s->available_stock, keys, cars, n, bptree_bulk_fill);
+    free(keys);
+    free(cars);
+
+    memset(sp, 0, sizeof(Salesperson));
+    sp->id = 1;
+    sp->soldCarsRoot = create_bptree_meta(s->meta);
+    bptree_insert(&s->salespersons, sp->id, sp);
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 8;
+    long ops = argc > 3 ? atol(argv[3]) : 2000000;
+
+    int* vins = (int*)malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) vins[i] = i + 1;
+    srand(5);
+    for (int i = n - 1; i > 0; i--) {
+        int j = (int)(((long long)rand() * RAND_MAX + rand()) % (i + 1));
+        int t = vins[i]; vins[i] = vins[j]; vins[j] = t;
+    }
+
+    printf("%d cars, %ld ops/thread, %d%% writes, %d CPU(s)\n", n, ops, BENCH_WRITE_PERCENT,
+           threadpool_default_threads());
+    printf("%-8s %-14s %-14s %-10s %-8s\n", "threads", "reads/s", "writes/s", "speedup", "wrong");
+    double base = 0;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        Showroom s;
+        Salesperson sp;
+        stock_showroom(&s, &sp, n);
+
+        ReadWorker* w = (ReadWorker*)calloc(threads, sizeof(ReadWorker));
+        double t0 = now_sec();
+        for (int t = 0; t < threads; t++) {
+            w[t].showroom = &s;
+            w[t].sp = &sp;
+            w[t].n = n;
+            w[t].ops = ops;
+            w[t].num_sell = n / threads;
+            w[t].sell_order = vins + (long)t * w[t].num_sell;
+            w[t].seed = 2463534242u + t;
+            pthread_create(&w[t].thread, NULL, read_worker, &w[t]);
+        }
+        long reads = 0, writes = 0, wrong = 0;
+        for (int t = 0; t < threads; t++) {
+            pthread_join(w[t].thread, NULL);
+            reads += w[t].reads;
+            writes += w[t].writes;
+            wrong += w[t].wrong;
+        }
+        double t = now_sec() - t0;
+        if (threads == 1) base = reads / t;
+        printf("%-8d %-14.0f %-14.0f %-10.2f %-8ld\n", threads, reads / t, writes / t, reads / t / base, wrong);
+        fflush(stdout);
+
+        free(w);
+        showroom_destroy(&s);
+    }
+
+    free(vins);
+    return 0;
+}
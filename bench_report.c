@@ -0,0 +1,129 @@
+// Report output benchmark: lists a large inventory the way the menu used to
+// (printf per car) and through the buffered report layer as a table, CSV
+// and JSON lines, half of the cars sold so every other record carries its
+// sale. Also checks that the table is byte for byte what printf wrote.
+// Build: gcc -O2 -pthread -o bench_report bench_report.c
+// Run:   ./bench_report [num_cars] [output]   (default 1000000 /dev/null)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bptree.c"
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// What display_car did before the report layer.
+void printf_car(FILE* f, Car* c) {
+    fprintf(f, "    VIN: %d | Name: %s | Color: %s | Price: %.2f | Fuel: %s | Type: %s\n", c->vin, car_name(c), car_color(c), c->price, car_fuel(c), car_type(c));
+    if (c->sale) {
+        Sale* sale = c->sale;
+        int current_day = sale->d_o_prchse / 1000000;
+        int current_month = (sale->d_o_prchse / 10000) % 100;
+        int current_year = sale->d_o_prchse % 10000;
+        fprintf(f, "        Sold To: %s | Mobile: %s | Address: %s | Reg No: %s | Payment: %s | Payment date: %d-%d-%d\n\n",
+                sale->cust_name, sale->cust_mobile, sale->cust_address, sale->reg_no, sale->payment_method, current_day, current_month, current_year);
+    }
+}
+
+// format < 0 is the printf listing; returns the bytes written.
+long list_cars(FILE* f, BPTreeNode* root, int format) {
+    BPTreeCursor cur;
+    void* data;
+    long start = ftell(f);
+    Report r;
+    report_init(&r, f, format < 0 ? REPORT_TABLE : (ReportFormat)format);
+    bptree_cursor_first(&cur, root);
+    while (bptree_cursor_next(&cur, NULL, &data)) {
+        if (format < 0) printf_car(f, (Car*)data);
+        else report_car(&r, (Car*)data, 0);
+    }
+    report_free(&r);
+    fflush(f);
+    return ftell(f) - start;
+}
+
+int same_contents(FILE* a, FILE* b) {
+    char x[65536], y[65536];
+    rewind(a);
+    rewind(b);
+    while (1) {
+        size_t n = fread(x, 1, sizeof(x), a), m = fread(y, 1, sizeof(y), b);
+        if (n != m || memcmp(x, y, n)) return 0;
+        if (n == 0) return 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    const char* path = argc > 2 ? argv[2] : "/dev/null";
+    if (n < 1) n = 1;
+
+    const char* models[] = { "Swift", "Baleno", "Creta", "Harrier", "Fortuner", "Nexon" };
+    const char* colors[] = { "White", "Black", "Red", "Blue", "Grey" };
+    Showroom s;
+    showroom_init(&s, 1, 1);
+    int* keys = (int*)malloc(n * sizeof(int));
+    void** cars = (void**)malloc(n * sizeof(void*));
+    for (int i = 0; i < n; i++) {
+        Car* c = (Car*)arena_alloc(s.arena, sizeof(Car));
+        c->vin = i + 1;
+        c->price = 500000 + (i % 97) * 12345.67f;
+        c->model = dict_intern(&car_models, models[i % 6], strlen(models[i % 6]));
+        c->color = dict_intern(&car_colors, colors[i % 5], strlen(colors[i % 5]));
+        c->fuel = dict_intern(&car_fuels, i % 3 ? "Petrol" : "Diesel", 6);
+        c->type = dict_intern(&car_types, i % 6 < 2 ? "Hatchback" : "SUV", i % 6 < 2 ? 9 : 3);
+        c->sale = NULL;
+        if (i % 2) {
+            Sale* sale = (Sale*)arena_alloc(s.arena, sizeof(Sale));
+            memset(sale, 0, sizeof(Sale));
+            snprintf(sale->cust_name, NAME_LEN, "Customer%d", i);
+            snprintf(sale->cust_mobile, NAME_LEN, "%d", 900000000 + i);
+            snprintf(sale->cust_address, ADDRESS_LEN, "Street %d, Hyderabad", i % 1000);
+            snprintf(sale->reg_no, NAME_LEN, "%d", 1000 + i % 9000);
+            snprintf(sale->payment_method, NAME_LEN, i % 3 ? "Loan" : "Cash");
+            sale->d_o_prchse = (1 + i % 28) * 1000000 + (1 + i % 12) * 10000 + 2009 + i % 10;
+            c->sale = sale;
+        }
+        keys[i] = c->vin;
+        cars[i] = c;
+    }
+    bptree_bulk_load(&s.available_stock, keys, cars, n, bptree_bulk_fill);
+    free(keys);
+    free(cars);
+
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    const char* names[] = { "printf", "table", "csv", "json" };
+    printf("%d cars (half sold) to %s\n", n, path);
+    printf("%-8s %-12s %-10s %-10s\n", "format", "records/s", "MB/s", "ms");
+    for (int format = -1; format <= REPORT_JSON; format++) {
+        rewind(f);
+        double t0 = now_sec();
+        long bytes = list_cars(f, s.available_stock, format);
+        double t = now_sec() - t0;
+        char rate[32] = "-";    // ftell does not count on /dev/null
+        if (bytes > 0) snprintf(rate, sizeof(rate), "%.1f", bytes / t / 1e6);
+        printf("%-8s %-12.0f %-10s %-10.1f\n", names[format + 1], n / t, rate, t * 1e3);
+        fflush(stdout);
+    }
+    fclose(f);
+
+    FILE* a = tmpfile();
+    FILE* b = tmpfile();
+    if (a && b) {
+        list_cars(a, s.available_stock, -1);
+        list_cars(b, s.available_stock, REPORT_TABLE);
+        printf("table output %s printf output\n", same_contents(a, b) ? "matches" : "DIFFERS from");
+        fclose(a);
+        fclose(b);
+    }
+    showroom_destroy(&s);
+    return 0;
+}
@@ -0,0 +1,181 @@
+// Concurrent sales stress benchmark: sales/second as terminal threads scale.
+// Every run also checks the result: each car ends up either available or
+// sold (never both, never neither) and the salesperson totals add up.
+// Build: gcc -O2 -pthread -o bench_sell bench_sell.c
+// Run:   ./bench_sell [num_cars] [max_threads] [indexes]   (default 1000000 8 0)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "bptree.c"
+
+#define BENCH_SALESPERSONS 16
+
+typedef struct SellWorker {
+    pthread_t thread;
+    Showroom* showroom;
+    Salesperson** salespersons;
+    const int* vins;        // shared shuffled VIN order
+    int n;
+    int first, step, count; // tries vins[first], vins[first + step], ... (mod n)
+    long sold, lost;
+} SellWorker;
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void* sell_worker(void* arg) {
+    SellWorker* w = (SellWorker*)arg;
+    Sale sale;
+    memset(&sale, 0, sizeof(sale));
+    strcpy(sale.cust_name, "Bench");
+    strcpy(sale.payment_method, "Cash");
+    sale.d_o_prchse = 15062024;
+
+    for (int k = 0; k < w->count; k++) {
+        int vin = w->vins[(w->first + (long long)k * w->step) % w->n];
+        Salesperson* sp = w->salespersons[vin % BENCH_SALESPERSONS];
+        SaleStatus status = showroom_sell_car(w->showroom, vin, sp, &sale);
+        if (status == SALE_OK) w->sold++;
+        else w->lost++;
+    }
+    return NULL;
+}
+
+long count_entries(BPTreeNode* root) {
+    BPTreeCursor cur;
+    long n = 0;
+    int prev = 0, key;
+    bptree_cursor_first(&cur, root);
+    while (bptree_cursor_next(&cur, &key, NULL)) {
+        if (n > 0 && key <= prev) return -1;
+        prev = key;
+        n++;
+    }
+    return n;
+}
+
+// Returns an error message, or NULL if the showroom is consistent.
+const char* verify(Showroom* s, Salesperson** sps, int n, long sold) {
+    long available = count_entries(s->available_stock);
+    long in_sold = count_entries(s->sold_stock);
+    if (available < 0 || in_sold < 0) return "keys out of order";
+    if (in_sold != sold) return "sold_stock does not match the sales made";
+    if (available + in_sold != n) return "cars lost or duplicated";
+
+    BPTreeCursor cur;
+    int vin;
+    void* data;
+    bptree_cursor_first(&cur, s->sold_stock);
+    while (bptree_cursor_next(&cur, &vin, &data)) {
+        if (!((Car*)data)->sale) return "sold car without a sale record";
+        if (bptree_search(s->available_stock, vin)) return "car both available and sold";
+    }
+    bptree_cursor_first(&cur, s->available_stock);
+    while (bptree_cursor_next(&cur, NULL, &data))
+        if (((Car*)data)->sale) return "available car with a sale record";
+
+    long per_sp = 0;
+    double achieved = 0, expect = 0;
+    for (int i = 0; i < BENCH_SALESPERSONS; i++) {
+        per_sp += count_entries(sps[i]->soldCarsRoot);
+        achieved += sps[i]->achieved;
+        if (sps[i]->commission != (float)(0.02 * sps[i]->achieved)) return "commission out of step";
+    }
+    if (per_sp != sold) return "salesperson trees do not match the sales made";
+    bptree_cursor_first(&cur, s->sold_stock);
+    while (bptree_cursor_next(&cur, NULL, &data))
+        expect += ((Car*)data)->price / 100000.0f;
+    if (achieved < expect * 0.999 || achieved > expect * 1.001) return "achieved totals do not add up";
+    return NULL;
+}
+
+// One timed run: `contended` makes every thread walk every VIN, so each car
+// is fought over by all of them; otherwise the VINs are dealt out.
+void run(int n, int threads, int contended, int indexes, const int* vins) {
+    Showroom s;
+    showroom_init(&s, 1, 1);
+
+    int* keys = (int*)malloc(n * sizeof(int));
+    void** cars = (void**)malloc(n * sizeof(void*));
+    for (int i = 0; i < n; i++) {
+        Car* c = (Car*)arena_alloc(s.arena, sizeof(Car));
+        c->vin = i + 1;
+        c->price = 500000 + (i % 50) * 20000;
+        c->model = c->color = c->fuel = c->type = 0;
+        c->sale = NULL;
+        keys[i] = c->vin;
+        cars[i] = c;
+    }
+    bptree_bulk_load(&s.available_stock, keys, cars, n, bptree_bulk_fill);
+    free(keys);
+    free(cars);
+
+    Salesperson* sps[BENCH_SALESPERSONS];
+    for (int i = 0; i < BENCH_SALESPERSONS; i++) {
+        sps[i] = (Salesperson*)arena_alloc(s.arena, sizeof(Salesperson));
+        memset(sps[i], 0, sizeof(Salesperson));
+        sps[i]->id = i + 1;
+        sps[i]->target = 50.0;
+        sps[i]->soldCarsRoot = create_bptree_meta(s.meta);
+        bptree_insert(&s.salespersons, sps[i]->id, sps[i]);
+    }
+    if (indexes) showroom_enable_indexes(&s, IDX_ALL);
+
+    SellWorker* w = (SellWorker*)calloc(threads, sizeof(SellWorker));
+    double t0 = now_sec();
+    for (int t = 0; t < threads; t++) {
+        w[t].showroom = &s;
+        w[t].salespersons = sps;
+        w[t].vins = vins;
+        w[t].n = n;
+        w[t].first = contended ? (int)((long long)n * t / threads) : t;
+        w[t].step = contended ? 1 : threads;
+        w[t].count = contended ? n : (n - t + threads - 1) / threads;
+        pthread_create(&w[t].thread, NULL, sell_worker, &w[t]);
+    }
+    long sold = 0, lost = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(w[t].thread, NULL);
+        sold += w[t].sold;
+        lost += w[t].lost;
+    }
+    double t = now_sec() - t0;
+
+    const char* err = verify(&s, sps, n, sold);
+    printf("%-10s %-8d %-10ld %-10ld %-12.0f %s\n", contended ? "contended" : "disjoint", threads, sold, lost,
+           sold / t, err ? err : "ok");
+    fflush(stdout);
+
+    free(w);
+    showroom_destroy(&s);
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 8;
+    int indexes = argc > 3 ? atoi(argv[3]) : 0;
+
+    // Random sale order over VINs 1..n
+    int* vins = (int*)malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) vins[i] = i + 1;
+    srand(11);
+    for (int i = n - 1; i > 0; i--) {
+        int j = (int)(((long long)rand() * RAND_MAX + rand()) % (i + 1));
+        int t = vins[i]; vins[i] = vins[j]; vins[j] = t;
+    }
+
+    printf("%d cars, %d salespersons, indexes %s, %d CPU(s)\n", n, BENCH_SALESPERSONS, indexes ? "on" : "off",
+           threadpool_default_threads());
+    printf("%-10s %-8s %-10s %-10s %-12s %s\n", "mode", "threads", "sold", "lost", "sales/s", "check");
+    for (int contended = 0; contended <= 1; contended++)
+        for (int threads = 1; threads <= max_threads; threads *= 2)
+            run(n, threads, contended, indexes, vins);
+
+    free(vins);
+    return 0;
+}
@@ -0,0 +1,248 @@
+// Query server load generator: connections, each on its own thread, keep
+// up to a pipeline depth of requests in flight against a running server
+// (showroom -S / -p, see server.h) and time every response from the send
+// of its request. Requests are VIN lookups with a share of reports
+// ("top 10", "breakdown model") and optionally sales of random VINs.
+// Prints throughput and latency percentiles for each depth.
+// Build: gcc -O2 -pthread -o bench_server bench_server.c
+// Run:   ./gen_data -d data -c 100000 && (cd data && ../showroom -n -q -q -S /tmp/showroom.sock &)
+//        ./bench_server -S /tmp/showroom.sock -v 300000
+//        ./bench_server [-S socket | -p port] [-c connections] [-n requests] [-d depth]
+//                       [-v max VIN] [-r report %] [-w sell %] [-k showrooms]
+//        (defaults: /tmp/showroom.sock 4 200000 1,16,128 100000 1 0 3; sales assume
+//        gen_data's layout of equal VIN blocks per showroom)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "server.h"
+
+typedef struct BenchConfig {
+    const char* path;
+    int port;
+    long requests;          // per connection
+    int depth;
+    int max_vin;
+    int report_pct;
+    int sell_pct;
+    int showrooms;
+} BenchConfig;
+
+typedef struct BenchClient {
+    const BenchConfig* cfg;
+    int id;
+    double* latency;        // seconds, one per response
+    long statuses[4];
+    long bytes;
+    int failed;             // connection error
+} BenchClient;
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int bench_connect(const BenchConfig* cfg) {
+    int fd;
+    if (cfg->port) {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((unsigned short)cfg->port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) return -1;
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    } else {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", cfg->path);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) return -1;
+    }
+    return fd;
+}
+
+int bench_request(const BenchConfig* cfg, unsigned* seed, long i, char* out) {
+    *seed = *seed * 1103515245u + 12345u;
+    unsigned r = *seed >> 4;
+    int vin = 1 + (int)(r % (unsigned)cfg->max_vin);
+    int pct = (int)(r / (unsigned)cfg->max_vin % 100);
+    if (pct < cfg->report_pct) return sprintf(out, i % 2 ? "top 10\n" : "breakdown model\n");
+    if (pct < cfg->report_pct + cfg->sell_pct) {
+        int per_showroom = cfg->max_vin / cfg->showrooms;
+        int showroom = per_showroom > 0 ? (vin - 1) / per_showroom + 1 : 1;
+        if (showroom > cfg->showrooms) showroom = cfg->showrooms;
+        return sprintf(out, "sell %d Bench 9000000000 Pune %d MH12-%ld 15062024 Cash 0 1\n", showroom, vin, i);
+    }
+    return sprintf(out, "car %d\n", vin);
+}
+
+void* bench_client(void* arg) {
+    BenchClient* c = (BenchClient*)arg;
+    const BenchConfig* cfg = c->cfg;
+    int fd = bench_connect(cfg);
+    if (fd < 0) {
+        perror(cfg->port ? "connect" : cfg->path);
+        c->failed = 1;
+        return NULL;
+    }
+    double* sent_at = (double*)malloc(cfg->depth * sizeof(double));
+    char* req = (char*)malloc((size_t)cfg->depth * 128);
+    size_t in_cap = 1 << 20;
+    char* in = (char*)malloc(in_cap);
+    if (!sent_at || !req || !in) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    unsigned seed = 7 + 31u * c->id;
+    long sent = 0, done = 0;
+    size_t in_len = 0;
+    while (done < cfg->requests) {
+        // Top the pipeline up, in one write
+        size_t len = 0;
+        double t = now_sec();
+        while (sent < cfg->requests && sent - done < cfg->depth) {
+            len += bench_request(cfg, &seed, sent, req + len);
+            sent_at[sent % cfg->depth] = t;
+            sent++;
+        }
+        for (size_t off = 0; off < len;) {
+            ssize_t n = send(fd, req + off, len - off, MSG_NOSIGNAL);
+            if (n <= 0) {
+                c->failed = 1;
+                goto out;
+            }
+            off += n;
+        }
+
+        // Read until at least one response is complete
+        long before = done;
+        while (done == before) {
+            if (in_len == in_cap) {
+                in_cap *= 2;
+                if (!(in = (char*)realloc(in, in_cap))) {
+                    printf("Memory allocation failed!\n");
+                    exit(1);
+                }
+            }
+            ssize_t n = recv(fd, in + in_len, in_cap - in_len, 0);
+            if (n <= 0) {
+                c->failed = 1;
+                goto out;
+            }
+            in_len += n;
+            c->bytes += n;
+            t = now_sec();
+            size_t pos = 0;
+            while (in_len - pos >= SERVER_HEADER_LEN) {
+                size_t body = strtoul(in + pos + 2, NULL, 10);
+                if (in_len - pos < SERVER_HEADER_LEN + body) break;
+                int status = in[pos] - '0';
+                if (status >= 0 && status < 4) c->statuses[status]++;
+                c->latency[done] = t - sent_at[done % cfg->depth];
+                done++;
+                pos += SERVER_HEADER_LEN + body;
+            }
+            memmove(in, in + pos, in_len - pos);
+            in_len -= pos;
+        }
+    }
+out:
+    close(fd);
+    free(sent_at);
+    free(req);
+    free(in);
+    return NULL;
+}
+
+int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+int bench_run(const BenchConfig* cfg, int connections) {
+    BenchClient* clients = (BenchClient*)calloc(connections, sizeof(BenchClient));
+    pthread_t* threads = (pthread_t*)malloc(connections * sizeof(pthread_t));
+    double* latency = (double*)malloc((size_t)connections * cfg->requests * sizeof(double));
+    if (!clients || !threads || !latency) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    double t0 = now_sec();
+    for (int i = 0; i < connections; i++) {
+        clients[i].cfg = cfg;
+        clients[i].id = i;
+        clients[i].latency = latency + (size_t)i * cfg->requests;
+        pthread_create(&threads[i], NULL, bench_client, &clients[i]);
+    }
+    long statuses[4] = { 0 };
+    long bytes = 0;
+    int failed = 0;
+    for (int i = 0; i < connections; i++) {
+        pthread_join(threads[i], NULL);
+        for (int s = 0; s < 4; s++)
+            statuses[s] += clients[i].statuses[s];
+        bytes += clients[i].bytes;
+        failed |= clients[i].failed;
+    }
+    double elapsed = now_sec() - t0;
+
+    long total = (long)connections * cfg->requests;
+    if (!failed) {
+        qsort(latency, total, sizeof(double), compare_double);
+        printf("depth %4d: %10.0f req/s %8.1f MB/s   p50 %8.1f us   p99 %8.1f us   p99.9 %8.1f us   max %8.1f us"
+               "   (%ld ok, %ld failed, %ld syntax)\n",
+               cfg->depth, total / elapsed, bytes / elapsed / 1e6, latency[total / 2] * 1e6, latency[total * 99 / 100] * 1e6,
+               latency[total * 999 / 1000] * 1e6, latency[total - 1] * 1e6, statuses[QUERY_OK], statuses[QUERY_FAILED],
+               statuses[QUERY_SYNTAX]);
+    } else {
+        fprintf(stderr, "depth %d: connection failed\n", cfg->depth);
+    }
+    free(clients);
+    free(threads);
+    free(latency);
+    return failed;
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = { "/tmp/showroom.sock", 0, 0, 0, 100000, 1, 0, 3 };
+    int connections = 4;
+    long requests = 200000;
+    int depth = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-S") == 0) cfg.path = argv[i + 1];
+        else if (strcmp(argv[i], "-p") == 0) cfg.port = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-c") == 0) connections = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-n") == 0) requests = atol(argv[i + 1]);
+        else if (strcmp(argv[i], "-d") == 0) depth = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-v") == 0) cfg.max_vin = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-r") == 0) cfg.report_pct = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-w") == 0) cfg.sell_pct = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-k") == 0) cfg.showrooms = atoi(argv[i + 1]);
+    }
+    if (connections < 1) connections = 1;
+    if (cfg.max_vin < 1) cfg.max_vin = 1;
+    if (cfg.showrooms < 1) cfg.showrooms = 1;
+    cfg.requests = requests / connections > 0 ? requests / connections : 1;
+
+    printf("%d connection(s), %ld requests each, VINs 1-%d, %d%% reports, %d%% sales, over %s\n", connections, cfg.requests,
+           cfg.max_vin, cfg.report_pct, cfg.sell_pct, cfg.port ? "TCP" : cfg.path);
+    int depths[] = { 1, 16, 128 };
+    int failed = 0;
+    for (int i = 0; i < (depth > 0 ? 1 : 3) && !failed; i++) {
+        cfg.depth = depth > 0 ? depth : depths[i];
+        failed = bench_run(&cfg, connections);
+    }
+    return failed;
+}
@@ -0,0 +1,207 @@
+// Snapshot benchmark: write a binary image of synthetic showrooms, then time
+// a cold start that serves VIN lookups straight from the mapping, a start
+// that checksums the whole image first, and a full restore into B+ trees.
+// Build: gcc -O2 -pthread -o bench_snapshot bench_snapshot.c
+// Run:   ./bench_snapshot [num_cars] [showrooms]   (default 10000000 4; writes bench_showroom.snap)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bptree.c"
+
+#define BENCH_SNAP "bench_showroom.snap"
+#define BENCH_SALESPERSONS 100
+#define BENCH_PROBES 1000000
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int random_int(int bound) {
+    return (int)(((long long)rand() * RAND_MAX + rand()) % bound);
+}
+
+// VINs 1..n; every 20th car is sold, round robin over the salespersons.
+void stock_showroom(Showroom* s, int id, int n) {
+    const char* models[] = { "Swift", "Baleno", "Creta", "Harrier", "Fortuner", "XUV500" };
+    const char* colors[] = { "White", "Black", "Red", "Blue", "Grey" };
+    showroom_init(s, id, 1);
+
+    int* keys = (int*)malloc(n * sizeof(int));
+    void** cars = (void**)malloc(n * sizeof(void*));
+    int* sold_keys = (int*)malloc((n / 20 + 1) * sizeof(int));
+    void** sold = (void**)malloc((n / 20 + 1) * sizeof(void*));
+    int na = 0, ns = 0;
+    Sale sale;
+    memset(&sale, 0, sizeof(sale));
+    strcpy(sale.cust_name, "Bench");
+    strcpy(sale.payment_method, "Loan");
+    sale.d_o_prchse = 15062024;
+    sale.payment_code = 3;
+    for (int i = 0; i < n; i++) {
+        Car* c = (Car*)arena_alloc(s->arena, sizeof(Car));
+        c->vin = i + 1;
+        c->price = 500000 + (i % 50) * 20000;
+        c->model = dict_intern(&car_models, models[i % 6], strlen(models[i % 6]));
+        c->color = dict_intern(&car_colors, colors[i % 5], strlen(colors[i % 5]));
+        c->fuel = dict_intern(&car_fuels, i % 3 ? "Petrol" : "Diesel", 6);
+        c->type = dict_intern(&car_types, i % 6 < 2 ? "Hatchback" : "SUV", i % 6 < 2 ? 9 : 3);
+        c->sale = NULL;
+        if (i % 20 == 19) {
+            c->sale = (Sale*)arena_alloc(s->arena, sizeof(Sale));
+            *c->sale = sale;
+            sold_keys[ns] = c->vin;
+            sold[ns++] = c;
+        } else {
+            keys[na] = c->vin;
+            cars[na++] = c;
+        }
+    }
+    bptree_bulk_load(&s->available_stock, keys, cars, na, bptree_bulk_fill);
+    bptree_bulk_load(&s->sold_stock, sold_keys, sold, ns, bptree_bulk_fill);
+
+    for (int p = 0; p < BENCH_SALESPERSONS; p++) {
+        char name[NAME_LEN];
+        snprintf(name, sizeof(name), "Seller%d", p + 1);
+        Salesperson* sp = showroom_add_salesperson(s, p + 1, name, 50.0);
+        int m = 0;
+        for (int j = p; j < ns; j += BENCH_SALESPERSONS) {
+            keys[m] = sold_keys[j];
+            cars[m++] = sold[j];
+            sp->achieved += ((Car*)sold[j])->price / 100000.0f;
+        }
+        sp->commission = 0.02 * sp->achieved;
+        bptree_bulk_load(&sp->soldCarsRoot, keys, cars, m, bptree_bulk_fill);
+    }
+    free(keys);
+    free(cars);
+    free(sold_keys);
+    free(sold);
+}
+
+// Drops the file from the page cache so the next open really is cold.
+void evict(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 10000000;
+    int count = argc > 2 ? atoi(argv[2]) : 4;
+    if (count < 1) count = 1;
+    int per = n / count;
+
+    Showroom* showrooms = (Showroom*)malloc(count * sizeof(Showroom));
+    double t0 = now_sec();
+    for (int i = 0; i < count; i++)
+        stock_showroom(&showrooms[i], i + 1, per);
+    printf("%d showrooms x %d cars built in %.2f s\n", count, per, now_sec() - t0);
+
+    t0 = now_sec();
+    if (!snapshot_write(BENCH_SNAP, showrooms, count)) return 1;
+    double t_write = now_sec() - t0;
+    Snapshot* snap = snapshot_open(BENCH_SNAP, 0);
+    if (!snap) return 1;
+    double mb = snap->size / 1048576.0;
+    snapshot_close(snap);
+    printf("write:   %.2f s, %.1f MB (%.0f MB/s, fsync included)\n", t_write, mb, mb / t_write);
+
+    // Probes are (showroom, VIN) pairs; a few miss on purpose
+    int* probe_room = (int*)malloc(BENCH_PROBES * sizeof(int));
+    int* probe_vin = (int*)malloc(BENCH_PROBES * sizeof(int));
+    srand(11);
+    for (int i = 0; i < BENCH_PROBES; i++) {
+        probe_room[i] = random_int(count);
+        probe_vin[i] = 1 + random_int(per + per / 100 + 1);
+    }
+
+    // 1. Cold start: map without checksumming, answer the first lookup
+    evict(BENCH_SNAP);
+    t0 = now_sec();
+    snap = snapshot_open(BENCH_SNAP, 0);
+    const SnapCar* first = snapshot_find_car(snap, snapshot_showroom(snap, 1), probe_vin[0]);
+    double t_cold = now_sec() - t0;
+    t0 = now_sec();
+    long found = 0, wrong = 0;
+    for (int i = 0; i < 1000; i++) {
+        const SnapShowroom* ss = &snap->showrooms[probe_room[i]];
+        found += snapshot_find_car(snap, ss, probe_vin[i]) != NULL;
+    }
+    double t_first = now_sec() - t0;
+    printf("cold open + first lookup: %.3f ms%s; next 1000 cold lookups: %.1f us/op\n",
+           t_cold * 1e3, first || probe_vin[0] > per ? "" : "  MISSING", t_first * 1e6 / 1000);
+
+    // 2. Warm lookups from the mapping against the in-memory trees
+    t0 = now_sec();
+    found = 0;
+    for (int i = 0; i < BENCH_PROBES; i++) {
+        const SnapShowroom* ss = &snap->showrooms[probe_room[i]];
+        found += snapshot_find_car(snap, ss, probe_vin[i]) != NULL;
+    }
+    double t_map = now_sec() - t0;
+    t0 = now_sec();
+    long expect = 0;
+    for (int i = 0; i < BENCH_PROBES; i++) {
+        Showroom* s = &showrooms[probe_room[i]];
+        expect += bptree_search(s->available_stock, probe_vin[i]) != NULL ||
+                  bptree_search(s->sold_stock, probe_vin[i]) != NULL;
+    }
+    double t_tree = now_sec() - t0;
+    for (int i = 0; i < BENCH_PROBES; i += 97) {
+        const SnapCar* sc = snapshot_find_car(snap, &snap->showrooms[probe_room[i]], probe_vin[i]);
+        Showroom* s = &showrooms[probe_room[i]];
+        Car* c = (Car*)bptree_search(s->available_stock, probe_vin[i]);
+        if (!c) c = (Car*)bptree_search(s->sold_stock, probe_vin[i]);
+        if (!sc != !c || (c && (sc->price != c->price || (sc->sale != SNAPSHOT_NO_SALE) != (c->sale != NULL))))
+            wrong++;
+    }
+    printf("lookups: mapped %.1f ns/op, B+ tree %.1f ns/op (%ld of %d found%s)\n",
+           t_map * 1e9 / BENCH_PROBES, t_tree * 1e9 / BENCH_PROBES, found, BENCH_PROBES,
+           found == expect && wrong == 0 ? "" : ", MISMATCH");
+    snapshot_close(snap);
+
+    // 3. Start with the full checksum, from the page cache and from disk
+    t0 = now_sec();
+    snap = snapshot_open(BENCH_SNAP, 1);
+    double t_verify = now_sec() - t0;
+    snapshot_close(snap);
+    evict(BENCH_SNAP);
+    t0 = now_sec();
+    snap = snapshot_open(BENCH_SNAP, 1);
+    double t_verify_cold = now_sec() - t0;
+    printf("open + CRC-32C: %.1f ms cached (%.0f MB/s), %.1f ms cold\n",
+           t_verify * 1e3, mb / t_verify, t_verify_cold * 1e3);
+
+    // 4. Full restore into mutable trees, as showroom -s does
+    Showroom* restored = (Showroom*)malloc(count * sizeof(Showroom));
+    t0 = now_sec();
+    for (int i = 0; i < count; i++)
+        showroom_init(&restored[i], snap->showrooms[i].showroom_id, 1);
+    snapshot_restore(snap, restored, 0);
+    double t_restore = now_sec() - t0;
+    snapshot_close(snap);
+    wrong = 0;
+    for (int i = 0; i < BENCH_PROBES; i += 97) {
+        Car* a = (Car*)bptree_search(showrooms[probe_room[i]].sold_stock, probe_vin[i]);
+        Car* b = (Car*)bptree_search(restored[probe_room[i]].sold_stock, probe_vin[i]);
+        if (!a != !b || (a && (a->price != b->price || !sale_equal(a->sale, b->sale)))) wrong++;
+    }
+    printf("restore: %.2f s (%.0f cars/s)%s\n", t_restore, per * (double)count / t_restore,
+           wrong ? "  MISMATCH" : "");
+
+    for (int i = 0; i < count; i++) {
+        showroom_destroy(&showrooms[i]);
+        showroom_destroy(&restored[i]);
+    }
+    free(showrooms);
+    free(restored);
+    free(probe_room);
+    free(probe_vin);
+    remove(BENCH_SNAP);
+    return 0;
+}
@@ -0,0 +1,372 @@
+// Benchmark suite: loads a dataset (see gen_data.c) and times loading, the
+// raw tree operations, every menu report, the merge, a snapshot and
+// selling cars. Results go out as JSON or CSV for regression tracking;
+// the reports' own output is discarded.
+// Build: gcc -O2 -pthread -o bench_suite bench_suite.c
+// Run:   ./gen_data -d data -c 100000 && ./bench_suite -d data
+//        ./bench_suite [-d dir] [-f json|csv] [-o file] [-r reps] [-n ops] [-j threads]
+//        (defaults: . json stdout 3 100000 one per CPU; runs inside dir and
+//        writes merge.txt there)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "bptree.c"
+
+#define SUITE_MAX_RESULTS 64
+#define SUITE_LOOKUPS 10000
+#define SUITE_SNAPSHOT "bench_suite.snap"
+
+//  One timed case, accumulated over its repetitions
+typedef struct SuiteResult {
+    const char* name;
+    int reps;
+    long ops;                   // operations per repetition
+    double total;               // seconds
+    double best;
+} SuiteResult;
+
+//  Everything a case needs; query parameters are derived from the data
+typedef struct Suite {
+    Showroom* showrooms;
+    int count;
+    int threads;
+    int reps;
+    long ops;
+    int today;                  // latest sale date, ddmmyyyy
+    int from_date, to_date;     // the month before it
+    float min_price, max_price;
+    float min_sales, max_sales;
+    int max_vin;
+    int* probes;                // VINs for display_car_info
+    long cars, sold, salespersons;
+    SuiteResult results[SUITE_MAX_RESULTS];
+    int num_results;
+} Suite;
+
+typedef void (*SuiteCase)(Suite* s);
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void suite_record(Suite* s, const char* name, long ops, double seconds) {
+    SuiteResult* r = NULL;
+    for (int i = 0; i < s->num_results; i++)
+        if (strcmp(s->results[i].name, name) == 0) r = &s->results[i];
+    if (!r) {
+        if (s->num_results == SUITE_MAX_RESULTS) return;
+        r = &s->results[s->num_results++];
+        memset(r, 0, sizeof(SuiteResult));
+        r->name = name;
+    }
+    r->reps++;
+    r->ops = ops;
+    r->total += seconds;
+    if (r->reps == 1 || seconds < r->best) r->best = seconds;
+}
+
+void suite_time(Suite* s, const char* name, long ops, SuiteCase fn) {
+    for (int rep = 0; rep < s->reps; rep++) {
+        double t0 = now_sec();
+        fn(s);
+        report_flush(&report);  // reports are buffered; count writing them out
+        suite_record(s, name, ops, now_sec() - t0);
+    }
+}
+
+void suite_load(Suite* s) {
+    for (int i = 0; i < s->count; i++)
+        showroom_init(&s->showrooms[i], i + 1, 1);
+    load_all_showrooms(s->showrooms, s->count, s->threads);
+}
+
+void suite_unload(Suite* s) {
+    for (int i = 0; i < s->count; i++)
+        showroom_destroy(&s->showrooms[i]);
+}
+
+long suite_size(BPTreeNode* root) {
+    BPTreeCursor cur;
+    long n = 0;
+    bptree_cursor_first(&cur, root);
+    while (bptree_cursor_next(&cur, NULL, NULL)) n++;
+    return n;
+}
+
+// Sizes the dataset and picks query parameters that select a few percent of it.
+void suite_survey(Suite* s) {
+    int latest = 0;
+    float lo = 0, hi = 0;
+    for (int i = 0; i < s->count; i++) {
+        Showroom* sh = &s->showrooms[i];
+        BPTreeCursor cur;
+        void* data;
+        int key;
+        bptree_cursor_first(&cur, sh->available_stock);
+        while (bptree_cursor_next(&cur, &key, &data)) {
+            float p = ((Car*)data)->price;
+            if (s->cars == 0 || p < lo) lo = p;
+            if (s->cars == 0 || p > hi) hi = p;
+            if (key > s->max_vin) s->max_vin = key;
+            s->cars++;
+        }
+        bptree_cursor_first(&cur, sh->sold_stock);
+        while (bptree_cursor_next(&cur, &key, &data)) {
+            int d = date_key(((Car*)data)->sale->d_o_prchse);
+            if (d > latest) latest = d;
+            if (key > s->max_vin) s->max_vin = key;
+            s->sold++;
+        }
+        s->salespersons += suite_size(sh->salespersons);
+    }
+    s->cars += s->sold;
+    if (!latest) latest = 20240101;
+    int year = latest / 10000, month = latest / 100 % 100;
+    int prev_year = month == 1 ? year - 1 : year, prev = month == 1 ? 12 : month - 1;
+    s->today = (latest % 100) * 1000000 + month * 10000 + year;
+    s->from_date = 1 * 1000000 + prev * 10000 + prev_year;
+    s->to_date = 28 * 1000000 + prev * 10000 + prev_year;
+    s->min_price = lo;
+    s->max_price = lo + (hi - lo) / 20;
+
+    LeaderEntry top;
+    s->max_sales = leaderboard_top(&leaderboard, 1, &top) ? top.achieved : 0;
+    s->min_sales = s->max_sales / 2;
+
+    s->probes = (int*)malloc(SUITE_LOOKUPS * sizeof(int));
+    if (!s->probes) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    unsigned seed = 5;
+    for (int i = 0; i < SUITE_LOOKUPS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        s->probes[i] = 1 + (int)((seed >> 4) % (unsigned)(s->max_vin ? s->max_vin : 1));
+    }
+}
+
+void case_available_stock(Suite* s) { bptree_traverse(s->showrooms[0].available_stock, 1); }
+void case_sold_cars(Suite* s) { bptree_traverse(s->showrooms[0].sold_stock, 1); }
+void case_salespersons(Suite* s) { bptree_traverse(s->showrooms[0].salespersons, 0); }
+void case_merge(Suite* s) { merge_and_sort_database(s->showrooms, s->count); }
+void case_popular_car(Suite* s) { find_most_popular_car(s->showrooms, s->count); }
+void case_best_salesperson(Suite* s) { find_most_successful_sales_person(s->showrooms, s->count); }
+void case_predict(Suite* s) { predict_next_month_sales(s->showrooms, s->count, s->today); }
+void case_emi_customers(Suite* s) { print_customers_with_36_months_emi_loan(s->showrooms, s->count); }
+void case_price_range(Suite* s) { list_cars_in_price_range(s->showrooms, s->count, s->min_price, s->max_price); }
+void case_date_range(Suite* s) { list_sales_between_dates(s->showrooms, s->count, s->from_date, s->to_date); }
+void case_leaderboard(Suite* s) { print_leaderboard(10); }
+void case_trend(Suite* s) { print_sales_trend(s->showrooms, s->count, s->today, 12); }
+void case_loans(Suite* s) { print_loan_portfolio(s->showrooms, s->count, s->today); }
+
+void case_car_info(Suite* s) {
+    for (int i = 0; i < SUITE_LOOKUPS; i++)
+        display_car_info(s->showrooms, s->count, s->probes[i]);
+}
+
+void case_sales_range(Suite* s) {
+    search_sales_person_by_sales_range(s->showrooms, s->count, s->min_sales, s->max_sales);
+}
+
+void case_breakdown(Suite* s) {
+    for (int f = GROUP_MODEL; f <= GROUP_TYPE; f++)
+        print_sales_breakdown(s->showrooms, s->count, (GroupField)f);
+}
+
+void case_snapshot(Suite* s) {
+    snapshot_write(SUITE_SNAPSHOT, s->showrooms, s->count);
+}
+
+// Insert, search and delete ops shuffled keys on a fresh tree per repetition.
+void suite_tree_ops(Suite* s) {
+    int* keys = (int*)malloc(s->ops * sizeof(int));
+    if (!keys) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (long i = 0; i < s->ops; i++) keys[i] = (int)i + 1;
+    unsigned seed = 9;
+    for (long i = s->ops - 1; i > 0; i--) {
+        seed = seed * 1103515245u + 12345u;
+        long j = (seed >> 4) % (i + 1);
+        int t = keys[i];
+        keys[i] = keys[j];
+        keys[j] = t;
+    }
+    for (int rep = 0; rep < s->reps; rep++) {
+        BPTreeNode* root = create_bptree();
+        double t0 = now_sec();
+        for (long i = 0; i < s->ops; i++) bptree_insert(&root, keys[i], &keys[i]);
+        suite_record(s, "bptree_insert", s->ops, now_sec() - t0);
+
+        t0 = now_sec();
+        long found = 0;
+        for (long i = 0; i < s->ops; i++) found += bptree_search(root, keys[i]) != NULL;
+        suite_record(s, "bptree_search", s->ops, now_sec() - t0);
+        if (found != s->ops) fprintf(stderr, "bptree_search: %ld of %ld keys found\n", found, s->ops);
+
+        t0 = now_sec();
+        for (long i = 0; i < s->ops; i++) bptree_delete(&root, keys[i]);
+        suite_record(s, "bptree_delete", s->ops, now_sec() - t0);
+        bptree_destroy(root);
+    }
+    free(keys);
+}
+
+// Sells up to ops cars of showroom 1; runs last since it changes the data.
+void suite_sell(Suite* s) {
+    Showroom* sh = &s->showrooms[0];
+    BPTreeCursor cur;
+    void* data;
+    bptree_cursor_first(&cur, sh->salespersons);
+    if (!bptree_cursor_next(&cur, NULL, &data)) return;
+    Salesperson* sp = (Salesperson*)data;
+
+    int* vins = (int*)malloc(s->ops * sizeof(int));
+    if (!vins) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    long n = 0;
+    int vin;
+    bptree_cursor_first(&cur, sh->available_stock);
+    while (n < s->ops && bptree_cursor_next(&cur, &vin, NULL)) vins[n++] = vin;
+
+    Sale sale;
+    memset(&sale, 0, sizeof(sale));
+    strcpy(sale.cust_name, "Bench");
+    strcpy(sale.payment_method, "Cash");
+    sale.d_o_prchse = s->today;
+    double t0 = now_sec();
+    for (long i = 0; i < n; i++) showroom_sell_car(sh, vins[i], sp, &sale);
+    suite_record(s, "sell_car", n, now_sec() - t0);
+    free(vins);
+}
+
+void suite_write_json(Suite* s, FILE* out, const char* dir) {
+    fprintf(out, "{\n  \"dataset\": {\"dir\": \"%s\", \"showrooms\": %d, \"cars\": %ld, \"sold\": %ld, \"salespersons\": %ld},\n",
+            dir, s->count, s->cars, s->sold, s->salespersons);
+    fprintf(out, "  \"reps\": %d,\n  \"results\": [\n", s->reps);
+    for (int i = 0; i < s->num_results; i++) {
+        SuiteResult* r = &s->results[i];
+        double mean = r->total / r->reps;
+        fprintf(out, "    {\"name\": \"%s\", \"reps\": %d, \"ops\": %ld, \"mean_ms\": %.3f, \"best_ms\": %.3f, \"ns_per_op\": %.1f}%s\n",
+                r->name, r->reps, r->ops, mean * 1e3, r->best * 1e3, r->ops ? mean * 1e9 / r->ops : 0.0,
+                i + 1 < s->num_results ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+void suite_write_csv(Suite* s, FILE* out) {
+    fprintf(out, "name,reps,ops,mean_ms,best_ms,ns_per_op\n");
+    for (int i = 0; i < s->num_results; i++) {
+        SuiteResult* r = &s->results[i];
+        double mean = r->total / r->reps;
+        fprintf(out, "%s,%d,%ld,%.3f,%.3f,%.1f\n", r->name, r->reps, r->ops, mean * 1e3, r->best * 1e3,
+                r->ops ? mean * 1e9 / r->ops : 0.0);
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* dir = ".";
+    const char* format = "json";
+    const char* out_path = NULL;
+    Suite s;
+    memset(&s, 0, sizeof(s));
+    s.reps = 3;
+    s.ops = 100000;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            fprintf(stderr, "usage: %s [-d dir] [-f json|csv] [-o file] [-r reps] [-n ops] [-j threads]\n", argv[0]);
+            return 1;
+        }
+        if (strcmp(argv[i], "-d") == 0) dir = argv[++i];
+        else if (strcmp(argv[i], "-f") == 0) format = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0) out_path = argv[++i];
+        else if (strcmp(argv[i], "-r") == 0) s.reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-n") == 0) s.ops = atol(argv[++i]);
+        else if (strcmp(argv[i], "-j") == 0) s.threads = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (strcmp(format, "json") != 0 && strcmp(format, "csv") != 0) {
+        fprintf(stderr, "format must be json or csv\n");
+        return 1;
+    }
+    if (s.reps < 1) s.reps = 1;
+    if (s.ops < 1) s.ops = 1;
+
+    // Results go to the real stdout (or -o); everything the library prints goes nowhere
+    FILE* out = out_path ? fopen(out_path, "w") : fdopen(dup(STDOUT_FILENO), "w");
+    if (!out) {
+        perror(out_path ? out_path : "stdout");
+        return 1;
+    }
+    if (chdir(dir) != 0) {
+        perror(dir);
+        return 1;
+    }
+    s.count = discover_showrooms();
+    if (s.count == 0) {
+        fprintf(stderr, "no showroom files in %s (generate some with gen_data)\n", dir);
+        return 1;
+    }
+    fflush(stdout);
+    if (!freopen("/dev/null", "w", stdout)) {
+        perror("/dev/null");
+        return 1;
+    }
+    s.showrooms = (Showroom*)malloc(s.count * sizeof(Showroom));
+    if (!s.showrooms) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        return 1;
+    }
+
+    for (int rep = 0; rep < s.reps; rep++) {
+        if (rep) suite_unload(&s);
+        double t0 = now_sec();
+        suite_load(&s);
+        suite_record(&s, "load", 0, now_sec() - t0);
+    }
+    suite_survey(&s);
+    s.results[0].ops = s.cars;
+
+    suite_tree_ops(&s);
+    suite_time(&s, "report_available_stock", s.showrooms[0].available_stock ? suite_size(s.showrooms[0].available_stock) : 0,
+               case_available_stock);
+    suite_time(&s, "report_sold_cars", suite_size(s.showrooms[0].sold_stock), case_sold_cars);
+    suite_time(&s, "report_salespersons", suite_size(s.showrooms[0].salespersons), case_salespersons);
+    suite_time(&s, "merge_and_sort_database", s.cars - s.sold, case_merge);
+    suite_time(&s, "report_popular_car", s.sold, case_popular_car);
+    suite_time(&s, "report_best_salesperson", 1, case_best_salesperson);
+    suite_time(&s, "report_predict_sales", 1, case_predict);
+    suite_time(&s, "report_car_info", SUITE_LOOKUPS, case_car_info);
+    suite_time(&s, "report_sales_range", 1, case_sales_range);
+    suite_time(&s, "report_emi_customers", 1, case_emi_customers);
+    suite_time(&s, "report_price_range", 1, case_price_range);
+    suite_time(&s, "report_date_range", 1, case_date_range);
+    suite_time(&s, "report_breakdown", 4, case_breakdown);
+    suite_time(&s, "snapshot_write", s.cars, case_snapshot);
+    suite_time(&s, "report_leaderboard", 1, case_leaderboard);
+    suite_time(&s, "report_sales_trend", 12, case_trend);
+    suite_time(&s, "report_loan_portfolio", 1, case_loans);
+    remove(SUITE_SNAPSHOT);
+    suite_sell(&s);
+
+    if (strcmp(format, "json") == 0) suite_write_json(&s, out, dir);
+    else suite_write_csv(&s, out);
+    int failed = ferror(out) != 0;
+    failed |= fclose(out) != 0;
+
+    suite_unload(&s);
+    vindir_free(&vin_directory);
+    free(s.showrooms);
+    free(s.probes);
+    return failed;
+}
@@ -0,0 +1,141 @@
+// Sales time-series benchmark: windowed queries (last 12 months, 90 days,
+// per-model forecast) from the series against walking sold_stock the way
+// predict_next_month_sales used to, plus the one-pass backfill.
+// Build: gcc -O2 -pthread -o bench_timeseries bench_timeseries.c
+// Run:   ./bench_timeseries [num_sales] [showrooms]   (default 1000000 4)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bptree.c"
+
+#define BENCH_MODELS 8
+#define BENCH_YEARS 5
+#define BENCH_QUERIES 2000
+#define BENCH_WALKS 5
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Sells every car of the showroom on a pseudo-random date in 2020..2024.
+void sell_all(Showroom* s, int first_vin, int n, unsigned seed) {
+    char name[16];
+    int models[BENCH_MODELS];
+    for (int m = 0; m < BENCH_MODELS; m++) {
+        snprintf(name, sizeof(name), "Model%d", m);
+        models[m] = dict_intern(&car_models, name, strlen(name));
+    }
+    int* keys = (int*)malloc(n * sizeof(int));
+    void** cars = (void**)malloc(n * sizeof(void*));
+    for (int i = 0; i < n; i++) {
+        Car* car = (Car*)arena_alloc(s->arena, sizeof(Car));
+        memset(car, 0, sizeof(Car));
+        car->vin = first_vin + i;
+        car->price = 500000 + (i % 50) * 20000;
+        car->model = models[i % BENCH_MODELS];
+        keys[i] = car->vin;
+        cars[i] = car;
+    }
+    bptree_bulk_load(&s->available_stock, keys, cars, n, bptree_bulk_fill);
+    Salesperson* sp = showroom_add_salesperson(s, 1, "Seller", 50.0);
+    Sale sale;
+    memset(&sale, 0, sizeof(sale));
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int day = 1 + (seed >> 8) % 28, month = 1 + (seed >> 16) % 12, year = 2020 + (seed >> 4) % BENCH_YEARS;
+        sale.d_o_prchse = day * 1000000 + month * 10000 + year;
+        showroom_sell_car(s, first_vin + i, sp, &sale);
+    }
+    free(keys);
+    free(cars);
+}
+
+// The old way: every sold car, bucketed by month on the fly.
+void walk_months(Showroom* showrooms, int count, int last_month, int n, SalesBucket* out) {
+    memset(out, 0, n * sizeof(SalesBucket));
+    for (int i = 0; i < count; i++) {
+        BPTreeCursor cur;
+        void* data;
+        bptree_cursor_first(&cur, showrooms[i].sold_stock);
+        while (bptree_cursor_next(&cur, NULL, &data)) {
+            Car* car = (Car*)data;
+            int k = ts_month_number(car->sale->d_o_prchse) - (last_month - n + 1);
+            if (k < 0 || k >= n) continue;
+            out[k].count++;
+            out[k].revenue += car->price;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    int count = argc > 2 ? atoi(argv[2]) : 4;
+    if (count < 1) count = 1;
+    int per = n / count;
+
+    Showroom* showrooms = (Showroom*)malloc(count * sizeof(Showroom));
+    double t0 = now_sec();
+    for (int i = 0; i < count; i++) {
+        showroom_init(&showrooms[i], i + 1, 1);
+        sell_all(&showrooms[i], 1 + i * per, per, 7 + i);
+    }
+    printf("%d sales in %d showrooms, sold in %.3f s\n", per * count, count, now_sec() - t0);
+
+    t0 = now_sec();
+    for (int i = 0; i < count; i++)
+        showroom_backfill_series(&showrooms[i]);
+    double t_backfill = now_sec() - t0;
+
+    int last_month = ts_month_number(31122024), last_day = ts_day_number(31122024);
+    SalesBucket months[12], walked[12], days[90], models[2];
+    int ok = 1;
+
+    t0 = now_sec();
+    for (int q = 0; q < BENCH_QUERIES; q++)
+        timeseries_months(showrooms, count, last_month - q % 24, 12, months);
+    double t_months = (now_sec() - t0) / BENCH_QUERIES;
+
+    t0 = now_sec();
+    for (int q = 0; q < BENCH_WALKS; q++)
+        walk_months(showrooms, count, last_month, 12, walked);
+    double t_walk = (now_sec() - t0) / BENCH_WALKS;
+    timeseries_months(showrooms, count, last_month, 12, months);
+    for (int i = 0; i < 12; i++)
+        if (months[i].count != walked[i].count || months[i].revenue != walked[i].revenue) ok = 0;
+
+    t0 = now_sec();
+    long day_sales = 0;
+    for (int q = 0; q < BENCH_QUERIES; q++) {
+        timeseries_days(showrooms, count, last_day - q % 365, 90, days);
+        day_sales += days[89].count;
+    }
+    double t_days = (now_sec() - t0) / BENCH_QUERIES;
+
+    t0 = now_sec();
+    double forecast = 0;
+    for (int q = 0; q < BENCH_QUERIES; q++) {
+        for (int m = 0; m < car_models.count; m++) {
+            timeseries_model_months(showrooms, count, m, last_month, 2, models);
+            forecast += timeseries_moving_average(models, 2, 2);
+        }
+    }
+    double t_models = (now_sec() - t0) / BENCH_QUERIES;
+    timeseries_months(showrooms, count, last_month, 2, months);
+    if ((long)(forecast / BENCH_QUERIES * 2 + 0.5) != months[0].count + months[1].count) ok = 0;
+
+    printf("%-26s %12s\n", "query", "us/query");
+    printf("%-26s %12.2f\n", "last 12 months (series)", t_months * 1e6);
+    printf("%-26s %12.2f\n", "last 12 months (walk)", t_walk * 1e6);
+    printf("%-26s %12.2f\n", "last 90 days (series)", t_days * 1e6);
+    printf("%-26s %12.2f  (%d models)\n", "per-model forecast", t_models * 1e6, car_models.count);
+    printf("backfill: %.3f s (%.0f ns/sale)\n", t_backfill, t_backfill * 1e9 / (per * count));
+    printf("check: %s\n", ok && day_sales > 0 ? "ok" : "MISMATCH");
+
+    for (int i = 0; i < count; i++)
+        showroom_destroy(&showrooms[i]);
+    free(showrooms);
+    return 0;
+}
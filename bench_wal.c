@@ -0,0 +1,133 @@
+// Write-ahead log benchmark: durable sales/second with group commit versus
+// one fsync per sale, as terminal threads scale, plus replay speed.
+// Build: gcc -O2 -pthread -o bench_wal bench_wal.c
+// Run:   ./bench_wal [sales_per_thread] [max_threads]   (default 2000 16; writes bench_showroom.wal)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "bptree.c"
+
+#define BENCH_WAL "bench_showroom.wal"
+
+typedef struct WalWorker {
+    pthread_t thread;
+    Showroom* showroom;
+    Salesperson* sp;
+    int first, count;       // sells VINs first .. first + count - 1
+    long sold;
+} WalWorker;
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void* wal_worker(void* arg) {
+    WalWorker* w = (WalWorker*)arg;
+    Sale sale;
+    memset(&sale, 0, sizeof(sale));
+    strcpy(sale.cust_name, "Bench");
+    strcpy(sale.payment_method, "Cash");
+    sale.d_o_prchse = 15062024;
+    for (int vin = w->first; vin < w->first + w->count; vin++)
+        w->sold += showroom_sell_car(w->showroom, vin, w->sp, &sale) == SALE_OK;
+    return NULL;
+}
+
+void stock_showroom(Showroom* s, int n) {
+    showroom_init(s, 1, 1);
+    int* keys = (int*)malloc(n * sizeof(int));
+    void** cars = (void**)malloc(n * sizeof(void*));
+    for (int i = 0; i < n; i++) {
+        Car* c = (Car*)arena_alloc(s->arena, sizeof(Car));
+        c->vin = i + 1;
+        c->price = 500000 + (i % 50) * 20000;
+        c->model = c->color = c->fuel = c->type = 0;
+        c->sale = NULL;
+        keys[i] = c->vin;
+        cars[i] = c;
+    }
+    bptree_bulk_load(&s->available_stock, keys, cars, n, bptree_bulk_fill);
+    free(keys);
+    free(cars);
+    showroom_add_salesperson(s, 1, "Bench", 50.0);
+}
+
+int main(int argc, char** argv) {
+    int per_thread = argc > 1 ? atoi(argv[1]) : 2000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 16;
+
+    printf("%d sales per thread, log %s\n", per_thread, BENCH_WAL);
+    printf("%-7s %-8s %-12s %-10s %-12s\n", "commit", "threads", "sales/s", "fsyncs", "sales/fsync");
+    for (int group = 0; group <= 1; group++) {
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            int n = per_thread * threads;
+            Showroom s;
+            stock_showroom(&s, n);
+            remove(BENCH_WAL);
+            Wal* wal = wal_open(BENCH_WAL, &s, 1);
+            wal_replay(wal);
+            wal->group_commit = group;
+            s.wal = wal;
+            Salesperson* sp = get_salesperson(s.salespersons, 1);
+
+            WalWorker* w = (WalWorker*)calloc(threads, sizeof(WalWorker));
+            double t0 = now_sec();
+            for (int t = 0; t < threads; t++) {
+                w[t].showroom = &s;
+                w[t].sp = sp;
+                w[t].first = 1 + t * per_thread;
+                w[t].count = per_thread;
+                pthread_create(&w[t].thread, NULL, wal_worker, &w[t]);
+            }
+            long sold = 0;
+            for (int t = 0; t < threads; t++) {
+                pthread_join(w[t].thread, NULL);
+                sold += w[t].sold;
+            }
+            double t = now_sec() - t0;
+            printf("%-7s %-8d %-12.0f %-10ld %-12.1f\n", group ? "group" : "single", threads, sold / t,
+                   wal->syncs, (double)sold / (wal->syncs ? wal->syncs : 1));
+            fflush(stdout);
+
+            s.wal = NULL;
+            wal_close(wal);
+            free(w);
+            showroom_destroy(&s);
+        }
+    }
+
+    // Replay: sell n cars in memory, log them in one batch, then rebuild
+    // a fresh showroom from the log
+    int n = per_thread * max_threads;
+    Showroom s;
+    stock_showroom(&s, n);
+    remove(BENCH_WAL);
+    Wal* wal = wal_open(BENCH_WAL, &s, 1);
+    wal_replay(wal);
+    Salesperson* sp = get_salesperson(s.salespersons, 1);
+    Sale sale;
+    memset(&sale, 0, sizeof(sale));
+    for (int vin = 1; vin <= n; vin++) {
+        showroom_sell_car(&s, vin, sp, &sale);
+        wal_append(wal, WAL_SALE, 1, &(WalSale){ 1, vin, sale }, sizeof(WalSale));
+    }
+    wal_commit(wal, wal->next_lsn - 1);
+    wal_close(wal);
+    showroom_destroy(&s);
+
+    stock_showroom(&s, n);
+    double t0 = now_sec();
+    wal = wal_open(BENCH_WAL, &s, 1);
+    int applied = wal_replay(wal);
+    double t = now_sec() - t0;
+    printf("\nreplay: %d of %d sales from %zu bytes in %.3f s, %.0f records/s\n", applied, n,
+           wal->file_bytes, t, n / t);
+    wal_close(wal);
+    showroom_destroy(&s);
+    remove(BENCH_WAL);
+    return 0;
+}
@@ -1,65 +1,265 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include "bptree.h"
+#if BPTREE_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+#include "latch.c"
+#include "report.c"
+#include "epoch.c"
+#include "arena.c"
+#include "parse.c"
+#include "index.c"
+#include "agg.c"
+#include "threadpool.c"
+#include "vindir.c"
+#include "leaderboard.c"
+#include "timeseries.c"
+#include "loan.c"
+#include "loader.c"
+#include "wal.c"
+#include "snapshot.c"
+#include "merge.c"
+#include "query.c"
+#include "server.c"
+
+// Key slots are padded so the pointer slots after them stay aligned
+#define BPTREE_KEY_BYTES(order) ((((order) + 1) * sizeof(int) + sizeof(void*) - 1) & ~(sizeof(void*) - 1))
+#define BPTREE_NODE_SIZE(order) (sizeof(BPTreeNode) + BPTREE_KEY_BYTES(order) + ((order) + 2) * sizeof(void*))
+
+BPTreeMeta bptree_builtin_meta = { BPTREE_DEFAULT_ORDER, BPTREE_NODE_SIZE(BPTREE_DEFAULT_ORDER), NULL };
+BPTreeMeta* bptree_default_meta = &bptree_builtin_meta;  // used for trees grown from a NULL root
+
+BPTreeMeta* bptree_new_meta(int order, Arena* arena) {
+    BPTreeMeta* meta = (BPTreeMeta*)arena_alloc(arena, sizeof(BPTreeMeta));
+    if (order < BPTREE_MIN_ORDER) order = BPTREE_MIN_ORDER;
+    meta->order = order;
+    meta->node_size = BPTREE_NODE_SIZE(order);
+    meta->arena = arena;
+    return meta;
+}
 
-BPTreeNode* create_bptree() {
-    BPTreeNode* node = (BPTreeNode*)malloc(sizeof(BPTreeNode));
-    node->is_leaf = 1;
-    node->num_keys = 0;
-    for (int i = 0; i < MAX + 2; i++) node->ptr[i] = NULL;
-    node->next = NULL;
-    return node;
+// Only affects trees created afterwards; existing trees keep their own meta.
+void bptree_set_default_order(int order) {
+    bptree_default_meta = bptree_new_meta(order, NULL);
 }
 
-BPTreeNode* create_node(int is_leaf) {
-    BPTreeNode* node = (BPTreeNode*)malloc(sizeof(BPTreeNode));
-    if (!node) {
-        printf("Memory allocation failed!\n");
-        exit(1);
-    }
+BPTreeNode* create_node_meta(BPTreeMeta* meta, int is_leaf) {
+    int order = meta->order;
+    BPTreeNode* node = (BPTreeNode*)arena_alloc(meta->arena, meta->node_size);
 
     node->is_leaf = is_leaf;
     node->num_keys = 0;
+    node->latch = 0;
+    node->keys = (int*)(node + 1);
+    node->ptr = (void**)((char*)(node + 1) + BPTREE_KEY_BYTES(order));
+    node->meta = meta;
     node->parent = NULL;
+    node->next = NULL;  // For leaf node chaining
 
-    for (int i = 0; i < MAX + 1; i++)
+    for (int i = 0; i < order + 2; i++)
         node->ptr[i] = NULL;
 
-    if (is_leaf) {
-        node->next = NULL;  // For leaf node chaining
-    } else {
-        node->next = NULL;  // Not needed for internal nodes but kept for uniformity
+    return node;
+}
+
+void bptree_free_node(BPTreeNode* node) {
+    arena_free(node->meta->arena, node, node->meta->node_size);
+}
+
+// Frees the nodes only; records hanging off the leaves belong to the caller.
+void bptree_destroy(BPTreeNode* root) {
+    if (!root) return;
+    if (!root->is_leaf) {
+        for (int i = 0; i <= root->num_keys; i++)
+            bptree_destroy((BPTreeNode*)root->ptr[i]);
     }
+    bptree_free_node(root);
+}
 
-    return node;
+BPTreeNode* create_bptree() {
+    return create_node_meta(bptree_default_meta, 1);
+}
+
+BPTreeNode* create_bptree_order(int order) {
+    return create_node_meta(bptree_new_meta(order, NULL), 1);
+}
+
+BPTreeNode* create_bptree_meta(BPTreeMeta* meta) {
+    return create_node_meta(meta, 1);
+}
+
+BPTreeNode* create_node(int is_leaf) {
+    return create_node_meta(bptree_default_meta, is_leaf);
+}
+
+int bptree_height(BPTreeNode* root) {
+    int height = 0;
+    for (BPTreeNode* node = root; node; height++) {
+        if (node->is_leaf) return height + 1;
+        node = (BPTreeNode*)node->ptr[0];
+    }
+    return height;
+}
+
+// In-node rank: the number of keys <= key, which is also the child slot a
+// descent has to follow. Keys inside a node are sorted, so counting every
+// key <= key gives the same answer as the old early-exit scan without a
+// data-dependent branch per key.
+int bptree_rank_scalar(const int* keys, int n, int key) {
+    int r = 0;
+    for (int i = 0; i < n; i++)
+        r += keys[i] <= key;
+    return r;
+}
+
+int bptree_rank_binary(const int* keys, int n, int key) {
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (keys[mid] <= key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+#if BPTREE_HAVE_X86_SIMD
+// SSE2 has no popcnt, so lanes are accumulated: a true compare is -1.
+__attribute__((target("sse2")))
+int bptree_rank_sse2(const int* keys, int n, int key) {
+    __m128i k = _mm_set1_epi32(key);
+    __m128i acc = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(keys + i));
+        acc = _mm_sub_epi32(acc, _mm_cmpgt_epi32(v, k));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    int gt = _mm_cvtsi128_si32(acc);
+    for (; i < n; i++)
+        gt += keys[i] > key;
+    return n - gt;
+}
+
+__attribute__((target("avx2,popcnt")))
+int bptree_rank_avx2(const int* keys, int n, int key) {
+    __m256i k = _mm256_set1_epi32(key);
+    int gt = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(keys + i));
+        gt += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, k))));
+    }
+    if (i + 4 <= n) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(keys + i));
+        gt += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, _mm256_castsi256_si128(k)))));
+        i += 4;
+    }
+    for (; i < n; i++)
+        gt += keys[i] > key;
+    return n - gt;
+}
+#endif
+
+// Picks the widest implementation the CPU supports on first use.
+int bptree_rank_resolve(const int* keys, int n, int key) {
+    bptree_rank = bptree_rank_scalar;
+#if BPTREE_HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+        bptree_rank = bptree_rank_avx2;
+    else if (__builtin_cpu_supports("sse2"))
+        bptree_rank = bptree_rank_sse2;
+#endif
+    return bptree_rank(keys, n, key);
+}
+
+int (*bptree_rank)(const int* keys, int n, int key) = bptree_rank_resolve;
+
+const char* bptree_rank_name() {
+    if (bptree_rank == bptree_rank_resolve) bptree_rank_resolve(NULL, 0, 0);
+#if BPTREE_HAVE_X86_SIMD
+    if (bptree_rank == bptree_rank_avx2) return "avx2";
+    if (bptree_rank == bptree_rank_sse2) return "sse2";
+#endif
+    if (bptree_rank == bptree_rank_binary) return "binary";
+    return "scalar";
+}
+
+// Releases the exclusive latches on stack[from..to).
+void bptree_unlatch_path(BPTreeNode** stack, int from, int to) {
+    for (int i = from; i < to; i++)
+        unlatch_exclusive(&stack[i]->latch);
 }
 
+// Turns a full root into an internal node over `left` (a copy of its old
+// contents) and `right`. The root node keeps its address, so *root never
+// changes once set and concurrent writers need no latch on the root pointer.
+void bptree_grow_root(BPTreeNode* root, int up_key, BPTreeNode* right) {
+    BPTreeNode* left = create_node_meta(root->meta, root->is_leaf);
+    int num_ptrs = root->num_keys + !root->is_leaf;
+    memcpy(left->keys, root->keys, root->num_keys * sizeof(int));
+    memcpy(left->ptr, root->ptr, num_ptrs * sizeof(void*));
+    left->num_keys = root->num_keys;
+    left->next = root->next;
+
+    root->is_leaf = 0;
+    root->next = NULL;
+    root->keys[0] = up_key;
+    root->ptr[0] = left;
+    root->ptr[1] = right;
+    root->num_keys = 1;
+}
+
+// Thread-safe against other inserts, deletes and searches on the same tree.
+// Latches are taken top-down and every ancestor is released as soon as the
+// child below it has room, so only the part of the path a split can reach
+// stays latched.
 void bptree_insert(BPTreeNode** root, int key, void* data) {
-    if (!(*root)) {
-        *root = create_node(1);
-        (*root)->keys[0] = key;
-        (*root)->ptr[0] = data;
-        (*root)->num_keys = 1;
-        return;
+    BPTreeNode* node = __atomic_load_n(root, __ATOMIC_ACQUIRE);
+    if (!node) {
+        BPTreeNode* leaf = create_node(1);
+        leaf->keys[0] = key;
+        leaf->ptr[0] = data;
+        leaf->num_keys = 1;
+        if (__atomic_compare_exchange_n(root, &node, leaf, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            return;
+        bptree_free_node(leaf);     // another thread planted the root first
     }
 
-    BPTreeNode* node = *root;
-    BPTreeNode* parent_stack[10];  // Up to 10 levels deep
-    int index_stack[10];
+    BPTreeMeta* meta = node->meta;
+    int order = meta->order;
+    BPTreeNode* parent_stack[BPTREE_MAX_HEIGHT];
+    int index_stack[BPTREE_MAX_HEIGHT];
     int height = 0;
+    int latched = 0;    // parent_stack[latched..height) are still latched
 
     // Traverse to the correct leaf
+    latch_exclusive(&node->latch);
     while (!node->is_leaf) {
         parent_stack[height] = node;
-        int i;
-        for (i = 0; i < node->num_keys && key >= node->keys[i]; i++);
+        int i = bptree_rank(node->keys, node->num_keys, key);
         index_stack[height++] = i;
         node = (BPTreeNode*)node->ptr[i];
+        latch_exclusive(&node->latch);
+        if (node->num_keys < order) {
+            bptree_unlatch_path(parent_stack, latched, height);
+            latched = height;
+        }
+    }
+
+    // A tombstone left by bptree_delete_lazy is reused in place
+    int i = bptree_rank(node->keys, node->num_keys, key);
+    if (i > 0 && node->keys[i - 1] == key && !node->ptr[i - 1]) {
+        node->ptr[i - 1] = data;
+        unlatch_exclusive(&node->latch);
+        bptree_unlatch_path(parent_stack, latched, height);
+        return;
     }
 
     // Insert into leaf node
-    int i;
     for (i = node->num_keys - 1; i >= 0 && node->keys[i] > key; i--) {
         node->keys[i + 1] = node->keys[i];
         node->ptr[i + 1] = node->ptr[i];
@@ -69,11 +269,14 @@ void bptree_insert(BPTreeNode** root, int key, void* data) {
     node->num_keys++;
 
     // If no overflow, done
-    if (node->num_keys <= MAX) return;
+    if (node->num_keys <= order) {
+        unlatch_exclusive(&node->latch);
+        return;
+    }
 
     // Leaf split
-    BPTreeNode* new_leaf = create_node(1);
-    int mid = (MAX + 1) / 2;
+    BPTreeNode* new_leaf = create_node_meta(meta, 1);
+    int mid = (order + 1) / 2;
 
     new_leaf->num_keys = node->num_keys - mid;
     node->num_keys = mid;
@@ -88,8 +291,10 @@ void bptree_insert(BPTreeNode** root, int key, void* data) {
     node->next = new_leaf;
 
     int up_key = new_leaf->keys[0];
+    if (height > 0) unlatch_exclusive(&node->latch);
 
-    // Now propagate up
+    // Now propagate up; everything from here to the root end of the stack
+    // is still latched because none of it had room
     while (height > 0) {
         node = parent_stack[--height];
         int pos = index_stack[height];
@@ -103,11 +308,14 @@ void bptree_insert(BPTreeNode** root, int key, void* data) {
         node->ptr[pos + 1] = new_leaf;
         node->num_keys++;
 
-        if (node->num_keys <= MAX) return;
+        if (node->num_keys <= order) {
+            bptree_unlatch_path(parent_stack, latched, height + 1);
+            return;
+        }
 
         // Internal node split
-        BPTreeNode* new_internal = create_node(0);
-        mid = (MAX + 1) / 2;
+        BPTreeNode* new_internal = create_node_meta(meta, 0);
+        mid = (order + 1) / 2;
 
         up_key = node->keys[mid];
 
@@ -120,674 +328,1419 @@ void bptree_insert(BPTreeNode** root, int key, void* data) {
 
         node->num_keys = mid;
         new_leaf = new_internal;
+        if (height > 0) unlatch_exclusive(&node->latch);
+    }
+
+    // The root itself split (it is still latched): grow the tree in place
+    bptree_grow_root(node, up_key, new_leaf);
+    unlatch_exclusive(&node->latch);
+}
+
+// Optimistic lock coupling: walks down without writing to any node. Each
+// node's version is checked after reading from it, and before and after
+// the child's version is taken, so a step that raced with a writer is
+// detected and the walk restarts from the root. Returns the slot holding
+// key (NULL if absent) and the data read from it; 0 means restart.
+int bptree_search_optimistic(BPTreeNode* root, int key, void*** slot_out, void** data_out) {
+    int max_keys = root->meta->order + 1;
+    BPTreeNode* node = root;
+    unsigned long v = latch_optimistic(&node->latch);
+
+    while (1) {
+        int n = node->num_keys;
+        if (n < 0 || n > max_keys) n = 0;    // torn read, caught by the validate below
+        int i = bptree_rank(node->keys, n, key);
+
+        if (node->is_leaf) {
+            void** slot = i > 0 && node->keys[i - 1] == key ? &node->ptr[i - 1] : NULL;
+            void* data = slot ? *slot : NULL;
+            if (!data) slot = NULL;     // tombstone
+            if (!latch_validate(&node->latch, v)) return 0;
+            *slot_out = slot;
+            *data_out = data;
+            return 1;
+        }
+
+        BPTreeNode* child = (BPTreeNode*)node->ptr[i];
+        if (!latch_validate(&node->latch, v)) return 0;
+        unsigned long child_v = latch_optimistic(&child->latch);
+        if ((child_v & LATCH_OBSOLETE) || !latch_validate(&node->latch, v)) return 0;
+        node = child;
+        v = child_v;
     }
+}
 
-    // New root creation
-    BPTreeNode* new_root = create_node(0);
-    new_root->keys[0] = up_key;
-    new_root->ptr[0] = *root;
-    new_root->ptr[1] = new_leaf;
-    new_root->num_keys = 1;
-    *root = new_root;
+// Like bptree_search, but returns the slot holding the data so it can be replaced.
+// The slot moves when the leaf changes, so only use it while no other thread
+// writes to this tree.
+void** bptree_search_ref(BPTreeNode* root, int key) {
+    if (root == NULL) return NULL;
+    void** slot;
+    void* data;
+    epoch_enter();
+    while (!bptree_search_optimistic(root, key, &slot, &data))
+        ;
+    epoch_exit();
+    return slot;
 }
 
+// Lock-free: never blocks concurrent inserts and deletes, and nodes they
+// unlink stay readable until the lookup has left its epoch.
 void* bptree_search(BPTreeNode* root, int key) {
+    if (root == NULL) return NULL;
+    void** slot;
+    void* data;
+    epoch_enter();
+    while (!bptree_search_optimistic(root, key, &slot, &data))
+        ;
+    epoch_exit();
+    return data;
+}
+
+BPTreeNode* bptree_first_leaf(BPTreeNode* root) {
+    BPTreeNode* node = root;
+    while (node && !node->is_leaf) node = (BPTreeNode*)node->ptr[0];
+    return node;
+}
+
+// Number of keys < key
+int bptree_rank_lower(const int* keys, int n, int key) {
+    return key == INT_MIN ? 0 : bptree_rank(keys, n, key - 1);
+}
+
+// Leaf and position of the first key >= key (NULL once past the last key).
+BPTreeNode* bptree_seek_leaf(BPTreeNode* root, int key, int* pos) {
     if (root == NULL) return NULL;
     BPTreeNode* node = root;
 
     while (!node->is_leaf) {
-        int i;
-        for (i = 0; i < node->num_keys && key >= node->keys[i]; i++);
+        int i = bptree_rank_lower(node->keys, node->num_keys, key);
         node = (BPTreeNode*)node->ptr[i];
     }
 
-    for (int i = 0; i < node->num_keys; i++) {
-        if (node->keys[i] == key) return node->ptr[i];
+    int i = bptree_rank_lower(node->keys, node->num_keys, key);
+    while (node && i >= node->num_keys) {
+        node = node->next;
+        i = 0;
     }
-    return NULL;
+    *pos = i;
+    return node;
 }
 
-void bptree_traverse(BPTreeNode* root, int is_car) {
-    if (!root) return;
-    BPTreeNode* node = root;
-    while (!node->is_leaf) node = (BPTreeNode*)node->ptr[0];
-
-    while (node) {
-        for (int i = 0; i < node->num_keys; i++) {
-            if (is_car)
-                display_car((Car*)node->ptr[i]);
-            else
-                display_salesperson((Salesperson*)node->ptr[i]);
+// Leaf cursor: walks entries in key order along the leaf chain, optionally
+// stopping after an inclusive upper bound. Entering a leaf prefetches the
+// next one so long scans overlap the pointer chase with the work on the
+// current leaf.
+void bptree_cursor_enter(BPTreeCursor* c, BPTreeNode* leaf, int pos) {
+    c->leaf = leaf;
+    c->pos = pos;
+#ifdef __GNUC__
+    if (leaf && leaf->next) {
+        __builtin_prefetch(leaf->next);
+        __builtin_prefetch(leaf->next->keys);
+    }
+#endif
+}
+
+void bptree_cursor_first(BPTreeCursor* c, BPTreeNode* root) {
+    c->has_hi = 0;
+    c->hi = 0;
+    bptree_cursor_enter(c, bptree_first_leaf(root), 0);
+}
+
+void bptree_cursor_seek(BPTreeCursor* c, BPTreeNode* root, int key) {
+    int pos = 0;
+    BPTreeNode* leaf = bptree_seek_leaf(root, key, &pos);
+    c->has_hi = 0;
+    c->hi = 0;
+    bptree_cursor_enter(c, leaf, pos);
+}
+
+// Entries with lo <= key <= hi
+void bptree_cursor_range(BPTreeCursor* c, BPTreeNode* root, int lo, int hi) {
+    bptree_cursor_seek(c, root, lo);
+    c->has_hi = 1;
+    c->hi = hi;
+}
+
+// Returns 0 once the scan is done; key and data may be NULL. Tombstones
+// (entries with NULL data) are skipped.
+int bptree_cursor_next(BPTreeCursor* c, int* key, void** data) {
+    while (1) {
+        while (c->leaf && c->pos >= c->leaf->num_keys)
+            bptree_cursor_enter(c, c->leaf->next, 0);
+        if (!c->leaf) return 0;
+
+        int k = c->leaf->keys[c->pos];
+        if (c->has_hi && k > c->hi) {
+            c->leaf = NULL;
+            return 0;
         }
-        node = node->next;
+        void* d = c->leaf->ptr[c->pos++];
+        if (!d) continue;
+        if (key) *key = k;
+        if (data) *data = d;
+        return 1;
     }
 }
 
-void display_car(Car* c) {
-    
-    int current_day = c->d_o_prchse / 1000000;
-    int current_month = (c->d_o_prchse / 10000) % 100;
-    int current_year = c->d_o_prchse % 10000;
-    printf("    VIN: %d | Name: %s | Color: %s | Price: %.2f | Fuel: %s | Type: %s\n", c->vin, c->name, c->color, c->price, c->fuel, c->type);
-    if (strcmp(c->cust_name, "N/A") != 0) {
-        printf("        Sold To: %s | Mobile: %s | Address: %s | Reg No: %s | Payment: %s | Payment date: %d-%d-%d\n\n",
-               c->cust_name, c->cust_mobile, c->cust_address, c->reg_no, c->payment_method, current_day, current_month, current_year);
+void bptree_traverse(BPTreeNode* root, int is_car) {
+    BPTreeCursor cur;
+    void* data;
+    bptree_cursor_first(&cur, root);
+    while (bptree_cursor_next(&cur, NULL, &data)) {
+        if (is_car)
+            display_car((Car*)data);
+        else
+            display_salesperson((Salesperson*)data);
+    }
+}
+
+const char* car_name(const Car* c) { return dict_name(&car_models, c->model); }
+const char* car_color(const Car* c) { return dict_name(&car_colors, c->color); }
+const char* car_fuel(const Car* c) { return dict_name(&car_fuels, c->fuel); }
+const char* car_type(const Car* c) { return dict_name(&car_types, c->type); }
+
+// One car as a record; a sold car carries its sale on a second table line.
+// showroom_id 0 leaves the showroom out.
+void report_car(Report* r, const Car* c, int showroom_id) {
+    report_begin(r, 4);
+    if (showroom_id) report_int(r, NULL, "showroom", showroom_id);
+    report_int(r, "VIN", "vin", c->vin);
+    report_str(r, "Name", "name", car_name(c));
+    report_str(r, "Color", "color", car_color(c));
+    report_money(r, "Price", "price", c->price);
+    report_str(r, "Fuel", "fuel", car_fuel(c));
+    report_str(r, "Type", "type", car_type(c));
+    if (c->sale) {
+        Sale* sale = c->sale;
+        report_break(r, 8);
+        report_str(r, "Sold To", "sold_to", sale->cust_name);
+        report_str(r, "Mobile", "mobile", sale->cust_mobile);
+        report_str(r, "Address", "address", sale->cust_address);
+        report_str(r, "Reg No", "reg_no", sale->reg_no);
+        report_str(r, "Payment", "payment", sale->payment_method);
+        report_date(r, "Payment date", "date", sale->d_o_prchse);
+        report_break(r, 0);
     }
+    report_end(r);
+}
+
+// In the table a salesperson is followed by the cars they sold; CSV and
+// JSON give the count instead, the cars are in the sold-cars listing.
+void report_salesperson(Report* r, Salesperson* s, int showroom_id) {
+    report_begin(r, 0);
+    if (showroom_id) report_int(r, "Showroom", "showroom", showroom_id);
+    report_int(r, "Salesperson ID", "id", s->id);
+    report_str(r, "Name", "name", s->name);
+    report_money(r, "Target", "target", s->target);
+    report_money(r, "Achieved", "achieved", s->achieved);
+    report_money(r, "Commission", "commission", s->commission);
+    if (r->format != REPORT_TABLE) {
+        BPTreeStats st;
+        bptree_stats(s->soldCarsRoot, &st);
+        report_int(r, NULL, "cars_sold", st.keys - st.tombstones);
+    }
+    report_end(r);
+}
+
+void display_car(Car* c) {
+    report_car(&report, c, 0);
 }
 
 void display_salesperson(Salesperson* s) {
-    printf("Salesperson ID: %d | Name: %s | Target: %.2f | Achieved: %.2f | Commission: %.2f\n",
-           s->id, s->name, s->target, s->achieved, s->commission);
-    printf("  Cars Sold:\n");
-    bptree_traverse(s->soldCarsRoot, 1);
+    report_salesperson(&report, s, 0);
+    report_text(&report, "  Cars Sold:\n");
+    if (report.format == REPORT_TABLE) bptree_traverse(s->soldCarsRoot, 1);
 }
 
 Salesperson* get_salesperson(BPTreeNode* root, int id) {
     return (Salesperson*)bptree_search(root, id);
 }
 
-void sell_car(Showroom* showroom, int vin, Salesperson* sp, Car* cust) {
-    Car* c = (Car*)bptree_search(showroom->available_stock, vin);
-    if (!c) {
-        printf("Car with VIN %d not found in showroom %d\n", vin, showroom->showroom_id);
-        return;
+// Adds a sale worth `price` to the salesperson's totals without a lock.
+// achieved is bumped with a compare-and-swap loop; commission is rewritten
+// until it was derived from the achieved value still current afterwards,
+// so once the terminals go quiet it always equals 2% of achieved.
+void salesperson_credit(Salesperson* sp, float price) {
+    salesperson_credit_all(sp, &price, 1);
+}
+
+// Credits n sales in the given order, rounding exactly as n calls to
+// salesperson_credit would, with a single leaderboard update.
+void salesperson_credit_all(Salesperson* sp, const float* prices, int n) {
+    float old, achieved;
+    __atomic_load(&sp->achieved, &old, __ATOMIC_RELAXED);
+    do {
+        achieved = old;
+        for (int i = 0; i < n; i++)
+            achieved += prices[i] / 100000.0f;
+    } while (!__atomic_compare_exchange(&sp->achieved, &old, &achieved, 1, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+
+    while (1) {
+        float commission = 0.02 * achieved;
+        float now;
+        __atomic_store(&sp->commission, &commission, __ATOMIC_SEQ_CST);
+        __atomic_load(&sp->achieved, &now, __ATOMIC_SEQ_CST);
+        if (now == achieved) break;
+        achieved = now;
     }
+    if (sp->rank_node) leaderboard_update(&leaderboard, sp);
+}
 
-    strcpy(c->cust_name, cust->cust_name);
-    strcpy(c->cust_mobile, cust->cust_mobile);
-    strcpy(c->cust_address, cust->cust_address);
-    strcpy(c->reg_no, cust->reg_no);
-    c->d_o_prchse = cust->d_o_prchse;
-    strcpy(c->payment_method, cust->payment_method);
-    c->payment_code = cust->payment_code;
+// Sells one car; safe to call from any number of threads on the same
+// showroom. Claiming car->sale is the commit point: exactly one caller
+// wins a given VIN, and the car leaves available_stock before it enters
+// sold_stock, so it is never listed as both. With a log attached the sale
+// is durable before this returns.
+SaleStatus showroom_sell_car(Showroom* showroom, int vin, Salesperson* sp, const Sale* cust) {
+    Car* c = (Car*)bptree_search(showroom->available_stock, vin);
+    if (!c) return SALE_NOT_FOUND;
+
+    Sale* sale = (Sale*)arena_alloc(showroom->arena, sizeof(Sale));
+    *sale = *cust;
+    Sale* unsold = NULL;
+    if (!__atomic_compare_exchange_n(&c->sale, &unsold, sale, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        arena_free(showroom->arena, sale, sizeof(Sale));
+        return SALE_ALREADY_SOLD;
+    }
 
-    bptree_delete(&(showroom->available_stock), vin);
+    if (showroom->lazy_delete) bptree_delete_lazy(&(showroom->available_stock), vin);
+    else bptree_delete(&(showroom->available_stock), vin);
     bptree_insert(&(showroom->sold_stock), vin, c);
-    printf("Inserted car with VIN: %d\n", c->vin);
     bptree_insert(&(sp->soldCarsRoot), vin, c);
-    printf("Inserted car with VIN: %d\n", c->vin);
+    if (showroom->indexes) {
+        pthread_mutex_lock(&showroom->index_lock);
+        showroom_index_sale(showroom, c);
+        pthread_mutex_unlock(&showroom->index_lock);
+    }
+    timeseries_add(showroom->series, sale->d_o_prchse, c->model, c->price);
 
-    sp->achieved += c->price / 100000.0f;
-    sp->commission = 0.02 * sp->achieved;
+    salesperson_credit(sp, c->price);
+    if (showroom->wal) wal_log_sale(showroom->wal, showroom, sp->id, vin, sale);
+    return SALE_OK;
 }
 
-void bptree_delete(BPTreeNode** root, int key) {
-    if (!(*root)) return;
+void print_sale_status(Report* r, Showroom* showroom, int vin, SaleStatus status) {
+    if (status == SALE_NOT_FOUND) {
+        report_message(r, "Car with VIN %d not found in showroom %d\n", vin, showroom->showroom_id);
+        return;
+    }
+    if (status == SALE_ALREADY_SOLD) {
+        report_message(r, "Car with VIN %d was just sold by another terminal in showroom %d\n", vin, showroom->showroom_id);
+        return;
+    }
+    report_text(r, "Inserted car with VIN: %d\n", vin);
+    report_text(r, "Inserted car with VIN: %d\n", vin);
+}
 
-    BPTreeNode* node = *root;
-    BPTreeNode* parent = NULL;
-    int parent_index = -1;
+void sell_car(Showroom* showroom, int vin, Salesperson* sp, Sale* cust) {
+    print_sale_status(&report, showroom, vin, showroom_sell_car(showroom, vin, sp, cust));
+}
 
-    // Traverse to the leaf node
-    while (!node->is_leaf) {
-        parent = node;
-        int i;
-        for (i = 0; i < node->num_keys && key >= node->keys[i]; i++);
-        parent_index = i;
-        node = (BPTreeNode*)node->ptr[i];
-    }
+// Requests by VIN, then in batch order, so the first sale of a VIN wins
+int compare_sale_requests(const void* a, const void* b) {
+    const SaleRequest* ra = *(const SaleRequest* const*)a;
+    const SaleRequest* rb = *(const SaleRequest* const*)b;
+    if (ra->vin != rb->vin) return (ra->vin > rb->vin) - (ra->vin < rb->vin);
+    return (ra > rb) - (ra < rb);
+}
 
-    // Find the key in the leaf
-    int found = 0, i;
-    for (i = 0; i < node->num_keys; i++) {
-        if (node->keys[i] == key) {
-            found = 1;
-            break;
+// Completed sales by salesperson, in batch order within each
+int compare_sales_by_salesperson(const void* a, const void* b) {
+    const SaleRequest* ra = *(const SaleRequest* const*)a;
+    const SaleRequest* rb = *(const SaleRequest* const*)b;
+    if (ra->sp != rb->sp) return (ra->sp > rb->sp) - (ra->sp < rb->sp);
+    return (ra > rb) - (ra < rb);
+}
+
+// Applies many sales at once, with the same outcome as calling
+// showroom_sell_car for each in order (a VIN sold twice goes to its first
+// request). The batch is sorted by VIN, so available_stock, sold_stock and
+// each salesperson's soldCarsRoot are updated in one sorted sweep apiece
+// instead of three descents per sale, every salesperson is credited once,
+// and the log is committed once. Sets each request's status and returns how
+// many sold. Lock-free lookups may run meanwhile, but nothing else may
+// write to the showroom.
+int sell_cars_batch(Showroom* showroom, SaleRequest* reqs, int n) {
+    if (n <= 0) return 0;
+    SaleRequest** order = (SaleRequest**)malloc(n * sizeof(SaleRequest*));
+    int* vins = (int*)malloc(n * sizeof(int));
+    void** cars = (void**)malloc(n * sizeof(void*));
+    if (!order || !vins || !cars) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (int i = 0; i < n; i++)
+        order[i] = &reqs[i];
+    qsort(order, n, sizeof(SaleRequest*), compare_sale_requests);
+    for (int i = 0; i < n; i++)
+        vins[i] = order[i]->vin;
+
+    bptree_delete_sorted(&showroom->available_stock, vins, n, showroom->lazy_delete, cars);
+
+    // Keep only the sales that happened, still in VIN order
+    int sold = 0;
+    for (int i = 0; i < n; i++) {
+        SaleRequest* r = order[i];
+        Car* c = (Car*)cars[i];
+        r->car = c;
+        if (!c) {
+            r->status = SALE_NOT_FOUND;
+            continue;
         }
+        Sale* sale = (Sale*)arena_alloc(showroom->arena, sizeof(Sale));
+        *sale = *r->sale;
+        __atomic_store_n(&c->sale, sale, __ATOMIC_RELEASE);
+        r->status = SALE_OK;
+        order[sold] = r;
+        vins[sold] = r->vin;
+        cars[sold++] = c;
     }
+    bptree_insert_sorted(&showroom->sold_stock, vins, cars, sold);
 
-    if (!found) {
-        printf("Key %d not found.\n", key);
-        return;
+    if (showroom->indexes) {
+        pthread_mutex_lock(&showroom->index_lock);
+        for (int i = 0; i < sold; i++)
+            showroom_index_sale(showroom, (Car*)cars[i]);
+        pthread_mutex_unlock(&showroom->index_lock);
     }
-
-    // Remove the key and data
-    for (int j = i; j < node->num_keys - 1; j++) {
-        node->keys[j] = node->keys[j + 1];
-        node->ptr[j] = node->ptr[j + 1];
+    for (int i = 0; i < sold; i++) {
+        Car* c = (Car*)cars[i];
+        timeseries_add(showroom->series, c->sale->d_o_prchse, c->model, c->price);
     }
-    node->num_keys--;
+    if (showroom->wal) wal_log_sales(showroom->wal, showroom, order, sold);
 
-    // Root with no keys left
-    if (node == *root && node->num_keys == 0) {
-        free(node);
-        *root = NULL;
-        return;
+    // One credit (in batch order, so totals round as before) and one sweep
+    // per salesperson
+    float* prices = (float*)malloc((sold ? sold : 1) * sizeof(float));
+    if (!prices) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    qsort(order, sold, sizeof(SaleRequest*), compare_sales_by_salesperson);
+    for (int i = 0, j; i < sold; i = j) {
+        Salesperson* sp = order[i]->sp;
+        for (j = i; j < sold && order[j]->sp == sp; j++)
+            prices[j - i] = order[j]->car->price;
+        salesperson_credit_all(sp, prices, j - i);
+
+        qsort(order + i, j - i, sizeof(SaleRequest*), compare_sale_requests);
+        for (int k = i; k < j; k++) {
+            vins[k - i] = order[k]->vin;
+            cars[k - i] = order[k]->car;
+        }
+        bptree_insert_sorted(&sp->soldCarsRoot, vins, cars, j - i);
     }
 
-    // If enough keys remain or it's root, nothing else needed
-    if (node->num_keys >= (MAX + 1) / 2 || node == *root) return;
+    free(prices);
+    free(order);
+    free(vins);
+    free(cars);
+    return sold;
+}
 
-    // Handle underflow: borrow or merge
-    BPTreeNode* left_sibling = NULL;
-    BPTreeNode* right_sibling = NULL;
-    int left_index = parent_index - 1;
-    int right_index = parent_index + 1;
+void bptree_reclaim_node(void* node) {
+    bptree_free_node((BPTreeNode*)node);
+}
 
-    if (parent_index > 0)
-        left_sibling = (BPTreeNode*)parent->ptr[left_index];
-    if (parent_index < parent->num_keys)
-        right_sibling = (BPTreeNode*)parent->ptr[right_index];
+// Frees a node unlinked by a writer (which still holds its latch) once no
+// optimistic reader can be on it any more.
+void bptree_retire_node(BPTreeNode* node) {
+    unlatch_obsolete(&node->latch);
+    epoch_retire(node, bptree_reclaim_node);
+}
 
-    // Try to borrow from left
-    if (left_sibling && left_sibling->num_keys > (MAX + 1) / 2) {
-        // Shift node to right
-        for (int j = node->num_keys; j > 0; j--) {
-            node->keys[j] = node->keys[j - 1];
-            node->ptr[j] = node->ptr[j - 1];
-        }
-        node->keys[0] = left_sibling->keys[left_sibling->num_keys - 1];
-        node->ptr[0] = left_sibling->ptr[left_sibling->num_keys - 1];
-        left_sibling->num_keys--;
-        node->num_keys++;
+// Copies the only child of an emptied root into the root and retires it, the
+// in-place mirror of bptree_grow_root. Both nodes are latched by the caller.
+void bptree_shrink_root(BPTreeNode* root, BPTreeNode* child) {
+    int num_ptrs = child->num_keys + !child->is_leaf;
+    memcpy(root->keys, child->keys, child->num_keys * sizeof(int));
+    memcpy(root->ptr, child->ptr, num_ptrs * sizeof(void*));
+    root->num_keys = child->num_keys;
+    root->is_leaf = child->is_leaf;
+    root->next = child->next;
+    bptree_retire_node(child);
+}
 
-        parent->keys[parent_index - 1] = node->keys[0];
+// Fewest keys a node other than the root may keep. A leaf split leaves
+// (order + 1) / 2 keys on each side; an internal split also pushes one key
+// up, so internal nodes are allowed one less.
+int bptree_min_keys(const BPTreeNode* node) {
+    int order = node->meta->order;
+    return node->is_leaf ? (order + 1) / 2 : order / 2;
+}
+
+// Entries of a leaf that are not tombstones
+int bptree_live_keys(const BPTreeNode* leaf) {
+    int live = 0;
+    for (int i = 0; i < leaf->num_keys; i++)
+        live += leaf->ptr[i] != NULL;
+    return live;
+}
+
+// Drops the tombstones of a latched leaf. Its first key can only grow, so
+// the separator above it stays valid.
+void bptree_purge_leaf(BPTreeNode* leaf) {
+    int n = 0;
+    for (int i = 0; i < leaf->num_keys; i++) {
+        if (!leaf->ptr[i]) continue;
+        leaf->keys[n] = leaf->keys[i];
+        leaf->ptr[n++] = leaf->ptr[i];
     }
-    // Try to borrow from right
-    else if (right_sibling && right_sibling->num_keys > (MAX + 1) / 2) {
-        node->keys[node->num_keys] = right_sibling->keys[0];
-        node->ptr[node->num_keys] = right_sibling->ptr[0];
-        node->num_keys++;
+    leaf->num_keys = n;
+}
 
-        // Shift right sibling
-        for (int j = 0; j < right_sibling->num_keys - 1; j++) {
-            right_sibling->keys[j] = right_sibling->keys[j + 1];
-            right_sibling->ptr[j] = right_sibling->ptr[j + 1];
-        }
-        right_sibling->num_keys--;
+// Removes separator k and the child pointer right of it.
+void bptree_remove_separator(BPTreeNode* parent, int k) {
+    for (int j = k; j < parent->num_keys - 1; j++) {
+        parent->keys[j] = parent->keys[j + 1];
+        parent->ptr[j + 1] = parent->ptr[j + 2];
+    }
+    parent->num_keys--;
+}
 
-        parent->keys[parent_index] = right_sibling->keys[0];
+// Moves the last entry of left to the front of node, its right neighbour.
+// Internal nodes rotate through separator k of the parent.
+void bptree_borrow_left(BPTreeNode* parent, int k, BPTreeNode* left, BPTreeNode* node) {
+    int n = node->num_keys;
+    if (node->is_leaf) {
+        memmove(node->keys + 1, node->keys, n * sizeof(int));
+        memmove(node->ptr + 1, node->ptr, n * sizeof(void*));
+        node->keys[0] = left->keys[left->num_keys - 1];
+        node->ptr[0] = left->ptr[left->num_keys - 1];
+        parent->keys[k] = node->keys[0];
+    } else {
+        memmove(node->keys + 1, node->keys, n * sizeof(int));
+        memmove(node->ptr + 1, node->ptr, (n + 1) * sizeof(void*));
+        node->keys[0] = parent->keys[k];
+        node->ptr[0] = left->ptr[left->num_keys];
+        parent->keys[k] = left->keys[left->num_keys - 1];
     }
-    // Merge with left or right
-    else if (left_sibling) {
-        int idx = left_sibling->num_keys;
-        for (int j = 0; j < node->num_keys; j++) {
-            left_sibling->keys[idx + j] = node->keys[j];
-            left_sibling->ptr[idx + j] = node->ptr[j];
-        }
-        left_sibling->num_keys += node->num_keys;
-        left_sibling->next = node->next;
-        free(node);
-
-        // Remove key from parent
-        for (int j = parent_index - 1; j < parent->num_keys - 1; j++) {
-            parent->keys[j] = parent->keys[j + 1];
-            parent->ptr[j + 1] = parent->ptr[j + 2];
-        }
-        parent->num_keys--;
+    left->num_keys--;
+    node->num_keys++;
+}
 
-        // If parent becomes empty and is root
-        if (parent == *root && parent->num_keys == 0) {
-            *root = left_sibling;
-            free(parent);
+// Moves the first entry of right to the end of node, its left neighbour.
+void bptree_borrow_right(BPTreeNode* parent, int k, BPTreeNode* node, BPTreeNode* right) {
+    int n = node->num_keys;
+    int rn = right->num_keys;
+    if (node->is_leaf) {
+        node->keys[n] = right->keys[0];
+        node->ptr[n] = right->ptr[0];
+        memmove(right->keys, right->keys + 1, (rn - 1) * sizeof(int));
+        memmove(right->ptr, right->ptr + 1, (rn - 1) * sizeof(void*));
+        parent->keys[k] = right->keys[0];
+    } else {
+        node->keys[n] = parent->keys[k];
+        node->ptr[n + 1] = right->ptr[0];
+        parent->keys[k] = right->keys[0];
+        memmove(right->keys, right->keys + 1, (rn - 1) * sizeof(int));
+        memmove(right->ptr, right->ptr + 1, rn * sizeof(void*));
+    }
+    right->num_keys--;
+    node->num_keys++;
+}
+
+// Appends right to left (separator k of the parent comes down between them
+// for internal nodes), unlinks right and retires it.
+void bptree_merge(BPTreeNode* parent, int k, BPTreeNode* left, BPTreeNode* right) {
+    int n = left->num_keys;
+    if (left->is_leaf) {
+        memcpy(left->keys + n, right->keys, right->num_keys * sizeof(int));
+        memcpy(left->ptr + n, right->ptr, right->num_keys * sizeof(void*));
+        left->num_keys += right->num_keys;
+        left->next = right->next;
+    } else {
+        left->keys[n] = parent->keys[k];
+        memcpy(left->keys + n + 1, right->keys, right->num_keys * sizeof(int));
+        memcpy(left->ptr + n + 1, right->ptr, (right->num_keys + 1) * sizeof(void*));
+        left->num_keys += right->num_keys + 1;
+    }
+    bptree_remove_separator(parent, k);
+    bptree_retire_node(right);
+}
+
+// Fixes an underflowed node, child `index` of parent: borrows entries from
+// a sibling that can spare them, and merges with a sibling if that is not
+// enough. A node can be short by more than one key (a purged leaf, or a
+// small bulk-loaded one), so borrowing repeats until it is full enough. The
+// caller holds node and parent; siblings are latched here, and every node
+// of this level is released or retired on return. Returns 1 if the parent
+// lost a key. A root left without keys takes over its only child.
+int bptree_rebalance(BPTreeNode* top, BPTreeNode* parent, int index, BPTreeNode* node) {
+    BPTreeNode* left = index > 0 ? (BPTreeNode*)parent->ptr[index - 1] : NULL;
+    BPTreeNode* right = index < parent->num_keys ? (BPTreeNode*)parent->ptr[index + 1] : NULL;
+    int min_keys = bptree_min_keys(node);
+    int merged = 0;
+
+    if (left) latch_exclusive(&left->latch);
+    if (right) latch_exclusive(&right->latch);
+
+    if (left && left->num_keys > min_keys) {
+        while (node->num_keys < min_keys && left->num_keys > min_keys)
+            bptree_borrow_left(parent, index - 1, left, node);
+    } else if (right) {
+        while (node->num_keys < min_keys && right->num_keys > min_keys)
+            bptree_borrow_right(parent, index, node, right);
+    }
+
+    // Whatever sibling is left to merge with holds at most min_keys, so
+    // the two fit in one node
+    if (node->num_keys < min_keys) {
+        merged = 1;
+        if (left) {
+            bptree_merge(parent, index - 1, left, node);
+            node = left;
+            left = NULL;
+        } else {
+            bptree_merge(parent, index, node, right);
+            right = NULL;
         }
-    } else if (right_sibling) {
-        int idx = node->num_keys;
-        for (int j = 0; j < right_sibling->num_keys; j++) {
-            node->keys[idx + j] = right_sibling->keys[j];
-            node->ptr[idx + j] = right_sibling->ptr[j];
+        if (parent == top && parent->num_keys == 0) {
+            bptree_shrink_root(top, node);
+            node = NULL;
         }
-        node->num_keys += right_sibling->num_keys;
-        node->next = right_sibling->next;
-        free(right_sibling);
+    }
 
-        for (int j = parent_index; j < parent->num_keys - 1; j++) {
-            parent->keys[j] = parent->keys[j + 1];
-            parent->ptr[j + 1] = parent->ptr[j + 2];
-        }
-        parent->num_keys--;
+    if (left) unlatch_exclusive(&left->latch);
+    if (right) unlatch_exclusive(&right->latch);
+    if (node) unlatch_exclusive(&node->latch);
+    return merged;
+}
 
-        if (parent == *root && parent->num_keys == 0) {
-            *root = node;
-            free(parent);
+// Shared by bptree_delete and bptree_delete_lazy; returns 1 if a tombstone
+// was left behind.
+int bptree_delete_key(BPTreeNode** root, int key, int lazy) {
+    BPTreeNode* node = __atomic_load_n(root, __ATOMIC_ACQUIRE);
+    if (!node) return 0;
+
+    BPTreeNode* top = node;
+    BPTreeNode* parent_stack[BPTREE_MAX_HEIGHT];
+    int index_stack[BPTREE_MAX_HEIGHT];
+    int height = 0;
+    int latched = 0;    // parent_stack[latched..height) are still latched
+
+    // Traverse to the leaf node. A node is safe once removing a key cannot
+    // underflow it; for a lazy delete that counts only the live entries of
+    // the leaf, since running low on them purges its tombstones.
+    latch_exclusive(&node->latch);
+    while (!node->is_leaf) {
+        parent_stack[height] = node;
+        int i = bptree_rank(node->keys, node->num_keys, key);
+        index_stack[height++] = i;
+        node = (BPTreeNode*)node->ptr[i];
+        latch_exclusive(&node->latch);
+        int spare = lazy && node->is_leaf ? bptree_live_keys(node) : node->num_keys;
+        if (spare > bptree_min_keys(node)) {
+            bptree_unlatch_path(parent_stack, latched, height);
+            latched = height;
         }
     }
-}
 
-void load_showroom_data(Showroom* showroom, const char* filename) {
-    FILE* f = fopen(filename, "r");
-    if (!f) return;
+    // Find the key in the leaf
+    int i = bptree_rank(node->keys, node->num_keys, key) - 1;
 
-    while (!feof(f)) {
-        Car* car = (Car*)malloc(sizeof(Car));
-        if (fscanf(f, "%d %s %s %s %s %f", &car->vin, car->name, car->color, car->fuel, car->type, &car->price) != 6)
-            break;
-        strcpy(car->cust_name, "N/A");
-        strcpy(car->cust_mobile, "N/A");
-        strcpy(car->cust_address, "N/A");
-        strcpy(car->reg_no, "N/A");
-        car->d_o_prchse = 0;
-        car->payment_code = 0;
-        strcpy(car->payment_method, "N/A");
+    if (i < 0 || node->keys[i] != key || !node->ptr[i]) {
+        unlatch_exclusive(&node->latch);
+        bptree_unlatch_path(parent_stack, latched, height);
+        printf("Key %d not found.\n", key);
+        return 0;
+    }
+
+    // Lazy: mark the entry dead while the leaf keeps enough live ones, else
+    // purge all of its tombstones and rebalance like an eager delete
+    int tombstone = 0;
+    if (lazy) {
+        node->ptr[i] = NULL;
+        if (node != top && bptree_live_keys(node) >= bptree_min_keys(node)) tombstone = 1;
+        else bptree_purge_leaf(node);
+    } else {
+        memmove(node->keys + i, node->keys + i + 1, (node->num_keys - i - 1) * sizeof(int));
+        memmove(node->ptr + i, node->ptr + i + 1, (node->num_keys - i - 1) * sizeof(void*));
+        node->num_keys--;
+    }
 
-        bptree_insert(&showroom->available_stock, car->vin, car);
+    // Walk back up while merges leave the parent short of keys. Every node
+    // reached this way was unsafe on the way down, so it is still latched.
+    // The root has no minimum; an emptied leaf root is kept so the tree
+    // keeps its meta.
+    int depth = height;
+    while (node != top && node->num_keys < bptree_min_keys(node)) {
+        BPTreeNode* parent = parent_stack[depth - 1];
+        if (!bptree_rebalance(top, parent, index_stack[depth - 1], node)) {
+            node = NULL;
+            break;
+        }
+        node = parent;
+        depth--;
     }
 
-    fclose(f);
+    if (node) unlatch_exclusive(&node->latch);
+    bptree_unlatch_path(parent_stack, latched, depth);
+    return tombstone;
 }
 
-void load_salespersons(Showroom* showroom, const char* filename) {
-    FILE* f = fopen(filename, "r");
-    if (!f) return;
+// Thread-safe like bptree_insert: an ancestor stays latched only while the
+// node below it could underflow, and siblings are latched before they are
+// borrowed from or merged. Underflow is repaired on every level it reaches.
+void bptree_delete(BPTreeNode** root, int key) {
+    bptree_delete_key(root, key, 0);
+}
 
-    while (!feof(f)) {
-        int srid;
-        Salesperson* s = (Salesperson*)malloc(sizeof(Salesperson));
-        if (fscanf(f, "%d %s %f %f %f", &s->id, s->name, &s->target, &s->achieved, &s->commission) != 5)
-            break;
+// Deletes by leaving a tombstone (NULL data) in the leaf: no entries move
+// and only the leaf stays latched. Searches and cursors skip tombstones and
+// an insert of the same key reuses one. A leaf whose live entries drop
+// below half is purged and rebalanced on the spot, so scans never see more
+// than half of a leaf dead; bptree_compact removes the rest. Returns 1 if a
+// tombstone was left.
+int bptree_delete_lazy(BPTreeNode** root, int key) {
+    return bptree_delete_key(root, key, 1);
+}
 
-        s->soldCarsRoot = NULL;
+// Leaf a key belongs in, found without latches, along with the tightest
+// separator above it on the right: keys >= *upper belong to later leaves.
+// For the sorted sweeps below, which need the tree to themselves.
+BPTreeNode* bptree_fenced_leaf(BPTreeNode* root, int key, int* has_upper, int* upper) {
+    BPTreeNode* node = root;
+    *has_upper = 0;
+    while (!node->is_leaf) {
+        int i = bptree_rank(node->keys, node->num_keys, key);
+        if (i < node->num_keys) {
+            *has_upper = 1;
+            *upper = node->keys[i];
+        }
+        node = (BPTreeNode*)node->ptr[i];
+    }
+    return node;
+}
 
-        printf("Inserted salesperson car with id: %d\n", s->id);
-        bptree_insert(&showroom->salespersons, s->id, s);
+// Deletes keys[0..n), sorted ascending, in one pass: consecutive keys in
+// the same leaf share one descent and the leaf is compacted once. Keys
+// whose removal would underflow their leaf are deleted afterwards through
+// bptree_delete (or bptree_delete_lazy with lazy set, which otherwise only
+// leaves tombstones). removed[i] gets the data that was stored under
+// keys[i], NULL if it was absent. Lock-free searches may run meanwhile, but
+// no other thread may write to the tree.
+void bptree_delete_sorted(BPTreeNode** root, int* keys, int n, int lazy, void** removed) {
+    BPTreeNode* top = *root;
+    int* deferred = (int*)malloc((n ? n : 1) * sizeof(int));
+    if (!deferred) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    int num_deferred = 0;
+    BPTreeNode* leaf = NULL;
+    int has_upper = 0, upper = 0, live = 0, changed = 0;
+
+    for (int k = 0; k < n; k++) {
+        int key = keys[k];
+        removed[k] = NULL;
+        if (!top || (k > 0 && key == keys[k - 1])) continue;
+        if (!leaf || (has_upper && key >= upper)) {
+            if (leaf) {
+                if (changed && (!lazy || leaf == top)) bptree_purge_leaf(leaf);
+                unlatch_exclusive(&leaf->latch);
+            }
+            leaf = bptree_fenced_leaf(top, key, &has_upper, &upper);
+            latch_exclusive(&leaf->latch);
+            live = bptree_live_keys(leaf);
+            changed = 0;
+        }
+
+        int i = bptree_rank(leaf->keys, leaf->num_keys, key) - 1;
+        if (i < 0 || leaf->keys[i] != key || !leaf->ptr[i]) continue;
+        removed[k] = leaf->ptr[i];
+        if (leaf == top || live > bptree_min_keys(leaf)) {
+            leaf->ptr[i] = NULL;
+            live--;
+            changed = 1;
+        } else {
+            deferred[num_deferred++] = key;
+        }
+    }
+    if (leaf) {
+        if (changed && (!lazy || leaf == top)) bptree_purge_leaf(leaf);
+        unlatch_exclusive(&leaf->latch);
     }
 
-    fclose(f);
+    for (int k = 0; k < num_deferred; k++) {
+        if (lazy) bptree_delete_lazy(root, deferred[k]);
+        else bptree_delete(root, deferred[k]);
+    }
+    free(deferred);
 }
 
-void process_customer_purchases(Showroom* showroom, const char* filename) {
-    FILE* f = fopen(filename, "r");
-    if (!f) return;
-
-    while (!feof(f)) {
-        int spid, vin;
-        Car* c = (Car*)malloc(sizeof(Car));
-        if (fscanf(f, "%d %s %s %s %d %s %d %s %d", &spid, c->cust_name, c->cust_mobile, c->cust_address, &vin, c->reg_no, &c->d_o_prchse, c->payment_method, &c->payment_code) != 9)
-            break;
+// Inserts n (key, data) pairs, sorted by key, in one pass: consecutive
+// keys that land in the same leaf share one descent, and only a leaf that
+// fills up goes through bptree_insert to split. An empty tree is bulk
+// loaded instead. Same rules for other threads as bptree_delete_sorted.
+void bptree_insert_sorted(BPTreeNode** root, int* keys, void** data, int n) {
+    if (n <= 0) return;
+    if (!*root || (*root)->num_keys == 0) {
+        bptree_bulk_load(root, keys, data, n, bptree_bulk_fill);
+        return;
+    }
 
-        // Convert d_o_prchse to correct format
-        int day = c->d_o_prchse / 1000000;
-        int month = (c->d_o_prchse / 10000) % 100;
-        int year = c->d_o_prchse % 10000;
-        c->d_o_prchse = day * 1000000 + month * 10000 + year;
+    BPTreeNode* top = *root;
+    int order = top->meta->order;
+    BPTreeNode* leaf = NULL;
+    int has_upper = 0, upper = 0;
+    for (int k = 0; k < n; k++) {
+        int key = keys[k];
+        if (!leaf || (has_upper && key >= upper)) {
+            if (leaf) unlatch_exclusive(&leaf->latch);
+            leaf = bptree_fenced_leaf(top, key, &has_upper, &upper);
+            latch_exclusive(&leaf->latch);
+        }
 
-        Salesperson* sp = get_salesperson(showroom->salespersons, spid);
-        if (sp){
-            printf("Getting customers too :) ");
-            sell_car(showroom, vin, sp, c);
+        int i = bptree_rank(leaf->keys, leaf->num_keys, key);
+        if (i > 0 && leaf->keys[i - 1] == key && !leaf->ptr[i - 1]) {
+            leaf->ptr[i - 1] = data[k];
+            continue;
         }
-        
+        if (leaf->num_keys >= order) {
+            unlatch_exclusive(&leaf->latch);
+            leaf = NULL;
+            bptree_insert(root, key, data[k]);
+            continue;
+        }
+        memmove(leaf->keys + i + 1, leaf->keys + i, (leaf->num_keys - i) * sizeof(int));
+        memmove(leaf->ptr + i + 1, leaf->ptr + i, (leaf->num_keys - i) * sizeof(void*));
+        leaf->keys[i] = key;
+        leaf->ptr[i] = data[k];
+        leaf->num_keys++;
     }
+    if (leaf) unlatch_exclusive(&leaf->latch);
+}
 
-    fclose(f);
+// Latches and retires every node below node, and node itself.
+void bptree_retire_tree(BPTreeNode* node) {
+    latch_exclusive(&node->latch);
+    if (!node->is_leaf) {
+        for (int i = 0; i <= node->num_keys; i++)
+            bptree_retire_tree((BPTreeNode*)node->ptr[i]);
+    }
+    bptree_retire_node(node);
 }
 
-void add_new_salesperson(Showroom* showroom) {
-    Salesperson* s = (Salesperson*)malloc(sizeof(Salesperson));
-    printf("Enter Salesperson ID: ");
-    scanf("%d", &s->id);
-    printf("Enter Name: ");
-    scanf("%s", s->name);
-    s->target = 50.0;
-    s->achieved = 0.0;
-    s->commission = 0.0;
-    s->soldCarsRoot = NULL;
-    bptree_insert(&showroom->salespersons, s->id, s);
-    printf("Inserted car with VIN: %d\n", s->id);
-    printf("Salesperson added.\n");
+// Gives the root the contents of fresh, a node no other thread has seen,
+// so the root keeps its address. The root's old subtrees are retired
+// through the epoch and fresh is freed.
+void bptree_adopt_root(BPTreeNode* top, BPTreeNode* fresh) {
+    latch_exclusive(&top->latch);
+    if (!top->is_leaf) {
+        for (int i = 0; i <= top->num_keys; i++)
+            bptree_retire_tree((BPTreeNode*)top->ptr[i]);
+    }
+    int num_ptrs = fresh->num_keys + !fresh->is_leaf;
+    memcpy(top->keys, fresh->keys, fresh->num_keys * sizeof(int));
+    memcpy(top->ptr, fresh->ptr, num_ptrs * sizeof(void*));
+    top->num_keys = fresh->num_keys;
+    top->is_leaf = fresh->is_leaf;
+    top->next = NULL;
+    bptree_free_node(fresh);
+    unlatch_exclusive(&top->latch);
 }
 
-void add_new_customer(Showroom* showroom) {
-    Car* cust = (Car*)malloc(sizeof(Car));
-    int spid, vin;
-    printf("Enter Customer Name, Mobile, Address:\n");
-    scanf("%s %s %s", cust->cust_name, cust->cust_mobile, cust->cust_address);
-    printf("Enter VIN of car, Registration No.,date of purchase, Payment Method and payment code(0 for Cash, 1 for 9.00% rate of interest for 84 months EMI,/n 2 for 8.75% rate of interest for 60 months EMI,/n 3 for 8.50% rate of interest for 36 months EMI.):\n");
-    scanf("%d %s %d %s %d", &vin, cust->reg_no,&cust->d_o_prchse, cust->payment_method,&cust->payment_code);
-    printf("Enter Salesperson ID:\n");
-    scanf("%d", &spid);
+// Rebuilds the tree without its tombstones, packed like a bulk load. The
+// root keeps its address. Lock-free searches may run meanwhile, but no
+// other thread may write to the tree.
+void bptree_compact(BPTreeNode** root) {
+    BPTreeNode* top = *root;
+    if (!top) return;
+
+    BPTreeCursor cur;
+    long n = 0;
+    bptree_cursor_first(&cur, top);
+    while (bptree_cursor_next(&cur, NULL, NULL)) n++;
+
+    int* keys = (int*)malloc((n ? n : 1) * sizeof(int));
+    void** data = (void**)malloc((n ? n : 1) * sizeof(void*));
+    if (!keys || !data) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    n = 0;
+    bptree_cursor_first(&cur, top);
+    while (bptree_cursor_next(&cur, &keys[n], &data[n])) n++;
+
+    BPTreeNode* fresh = create_bptree_meta(top->meta);
+    bptree_bulk_load(&fresh, keys, data, (int)n, bptree_bulk_fill);
+    free(keys);
+    free(data);
+    bptree_adopt_root(top, fresh);
+}
 
-    Salesperson* sp = get_salesperson(showroom->salespersons, spid);
-    if (!sp) {
-        printf("Salesperson not found.\n");
+void bptree_stats_node(BPTreeNode* node, BPTreeStats* st) {
+    st->nodes++;
+    if (node->is_leaf) {
+        st->leaves++;
+        st->keys += node->num_keys;
+        st->tombstones += node->num_keys - bptree_live_keys(node);
         return;
     }
+    st->internal_keys += node->num_keys;
+    for (int i = 0; i <= node->num_keys; i++)
+        bptree_stats_node((BPTreeNode*)node->ptr[i], st);
+}
 
-    sell_car(showroom, vin, sp, cust);
+// Walks the whole tree; no other thread may write to it meanwhile.
+void bptree_stats(BPTreeNode* root, BPTreeStats* st) {
+    memset(st, 0, sizeof(BPTreeStats));
+    if (!root) return;
+    st->height = bptree_height(root);
+    bptree_stats_node(root, st);
+    int order = root->meta->order;
+    st->leaf_fill = (double)st->keys / ((double)st->leaves * order);
+    long internal = st->nodes - st->leaves;
+    st->internal_fill = internal ? (double)st->internal_keys / ((double)internal * order) : 0;
 }
 
-void find_most_popular_car(Showroom* showrooms) {
-    char most_popular_car[100] = "";
-    int max_sales = 0;
-
-    // Iterate through each showroom
-    for (int i = 0; i < 3; i++) {
-        // Iterate through the sold stock of the current showroom
-        BPTreeNode* node = showrooms[i].sold_stock;
-        while (node) {
-            // Iterate through each car in the current node
-            for (int j = 0; j < node->num_keys; j++) {
-                // Get the car's brand and sales data
-                Car* car = (Car*)node->ptr[j];
-                char car_name[100];
-                strcpy(car_name, car->name);
-
-                // Check if the car's brand has higher sales than the current max sales
-                int car_sales = 0;
-                BPTreeNode* temp_node = showrooms[i].sold_stock;
-                while (temp_node) {
-                    for (int k = 0; k < temp_node->num_keys; k++) {
-                        Car* temp_car = (Car*)temp_node->ptr[k];
-                        char temp_car_name[100];
-                        strcpy(temp_car_name, temp_car->name);
-                        if (strcmp(temp_car_name, car_name) == 0) {
-                            car_sales += temp_car->price;
-                        }
-                    }
-                    temp_node = temp_node->next;
-                }
+typedef struct BPTreeEntry {
+    int key;
+    void* data;
+} BPTreeEntry;
 
-                if (car_sales > max_sales) {
-                    max_sales = car_sales;
-                    strcpy(most_popular_car, car_name);
-                }
-            }
-            node = node->next;
+int compare_entries(const void* a, const void* b) {
+    int ka = ((const BPTreeEntry*)a)->key, kb = ((const BPTreeEntry*)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+double bptree_bulk_fill = BPTREE_DEFAULT_FILL;
+
+// Builds a tree bottom-up from n (key, data) pairs in O(n) when keys arrive
+// sorted; otherwise sorts a copy first. Leaves are packed to `fill` of the
+// order and chained left to right, then each internal level is packed the
+// same way over the level below. Where an even spread at `fill` would leave
+// nodes below bptree_min_keys, fewer (fuller) nodes are used, so the delete
+// path finds every non-root node at or above its minimum.
+// Only an empty tree is rebuilt; a non-empty one just takes inserts. An
+// existing root keeps its address (see bptree_adopt_root), so lock-free
+// searches may run meanwhile.
+void bptree_bulk_load(BPTreeNode** root, int* keys, void** data, int n, double fill) {
+    if (n <= 0) return;
+    if (*root && (*root)->num_keys > 0) {
+        for (int i = 0; i < n; i++)
+            bptree_insert(root, keys[i], data[i]);
+        return;
+    }
+
+    BPTreeMeta* meta = *root ? (*root)->meta : bptree_default_meta;
+    int order = meta->order;
+
+    int sorted = 1;
+    for (int i = 1; i < n && sorted; i++)
+        sorted = keys[i - 1] <= keys[i];
+
+    BPTreeEntry* entries = NULL;
+    if (!sorted) {
+        entries = (BPTreeEntry*)malloc(n * sizeof(BPTreeEntry));
+        if (!entries) {
+            printf("Memory allocation failed!\n");
+            exit(1);
+        }
+        for (int i = 0; i < n; i++) {
+            entries[i].key = keys[i];
+            entries[i].data = data[i];
         }
+        qsort(entries, n, sizeof(BPTreeEntry), compare_entries);
     }
 
-    // Print the most popular car's details
-    printf("Most popular car: %s\n", most_popular_car);
-    for (int i = 0; i < 3; i++) {
-        BPTreeNode* node = showrooms[i].sold_stock;
-        while (node) {
-            for (int j = 0; j < node->num_keys; j++) {
-                Car* car = (Car*)node->ptr[j];
-                char car_name[100];
-                strcpy(car_name, car->name);
-                if (strcmp(car_name, most_popular_car) == 0) {
-                    display_car(car);
-                }
+    // Keys per node for this fill factor, clamped to [half, order]
+    int cap = (int)(order * fill + 0.5);
+    if (cap < (order + 1) / 2) cap = (order + 1) / 2;
+    if (cap > order) cap = order;
+    if (cap < 1) cap = 1;
+
+    // Leaf level: spread n keys evenly over ceil(n / cap) leaves, but no
+    // more leaves than can each get the minimum of (order + 1) / 2
+    int count = (n + cap - 1) / cap;
+    int most = n / ((order + 1) / 2);
+    if (count > most) count = most > 1 ? most : 1;
+    BPTreeNode** level = (BPTreeNode**)malloc(count * sizeof(BPTreeNode*));
+    int* low_keys = (int*)malloc(count * sizeof(int));
+    if (!level || !low_keys) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+
+    int pos = 0;
+    BPTreeNode* prev = NULL;
+    for (int l = 0; l < count; l++) {
+        int take = n / count + (l < n % count);
+        BPTreeNode* leaf = create_node_meta(meta, 1);
+        for (int j = 0; j < take; j++, pos++) {
+            leaf->keys[j] = entries ? entries[pos].key : keys[pos];
+            leaf->ptr[j] = entries ? entries[pos].data : data[pos];
+        }
+        leaf->num_keys = take;
+        if (prev) prev->next = leaf;
+        prev = leaf;
+        level[l] = leaf;
+        low_keys[l] = leaf->keys[0];
+    }
+    free(entries);
+
+    // Internal levels: each node takes up to cap + 1 children, and at
+    // least the minimum of order / 2 + 1
+    while (count > 1) {
+        int parents = (count + cap) / (cap + 1);
+        most = count / (order / 2 + 1);
+        if (parents > most) parents = most > 1 ? most : 1;
+        int child = 0;
+        for (int p = 0; p < parents; p++) {
+            int take = count / parents + (p < count % parents);
+            BPTreeNode* node = create_node_meta(meta, 0);
+            for (int j = 0; j < take; j++, child++) {
+                node->ptr[j] = level[child];
+                if (j > 0) node->keys[j - 1] = low_keys[child];
             }
-            node = node->next;
+            node->num_keys = take - 1;
+            low_keys[p] = low_keys[child - take];
+            level[p] = node;
         }
+        count = parents;
     }
+
+    if (*root) bptree_adopt_root(*root, level[0]);
+    else *root = level[0];
+    free(level);
+    free(low_keys);
 }
 
-void find_most_successful_sales_person(Showroom* showrooms) {
-    int max_sales = 0;
-    Salesperson* most_successful_sales_person = NULL;
+void showroom_init(Showroom* s, int id, int use_arena) {
+    s->showroom_id = id;
+    s->arena = use_arena ? arena_create() : NULL;
+    s->meta = bptree_new_meta(BPTREE_DEFAULT_ORDER, s->arena);
+    s->available_stock = create_bptree_meta(s->meta);
+    s->sold_stock = create_bptree_meta(s->meta);
+    s->salespersons = create_bptree_meta(s->meta);
+    s->indexes = 0;
+    s->price_index = NULL;
+    s->model_index = NULL;
+    s->date_index = NULL;
+    s->payment_index = NULL;
+    pthread_mutex_init(&s->index_lock, NULL);
+    s->series = timeseries_create();
+    s->wal = NULL;
+    s->lazy_delete = 0;
+}
 
-    // Iterate through each showroom
-    for (int i = 0; i < 3; i++) {
-        // Iterate through the sales persons of the current showroom
-        BPTreeNode* node = showrooms[i].salespersons;
-        while (node) {
-            // Get the sales person's sales data
-            Salesperson* sales_person = (Salesperson*)node->ptr[0];
+// Clears the tombstones lazy sales left in available_stock. Call it between
+// batches of sales; no other thread may be selling from the showroom.
+void showroom_compact(Showroom* s) {
+    bptree_compact(&s->available_stock);
+}
 
-            // Check if the sales person's sales are higher than the current max sales
-            if (sales_person->achieved > max_sales) {
-                max_sales = sales_person->achieved;
-                most_successful_sales_person = sales_person;
-            }
+void free_leaf_records(BPTreeNode* root) {
+    BPTreeCursor cur;
+    void* data;
+    bptree_cursor_first(&cur, root);
+    while (bptree_cursor_next(&cur, NULL, &data))
+        arena_free(NULL, data, 0);
+}
 
-            node = node->next;
-        }
+// With an arena this is one arena_destroy; the malloc path has to visit
+// every node and record. No other thread may still be using the showroom.
+void showroom_destroy(Showroom* s) {
+    epoch_drain();      // nodes retired by deletes may still point into s
+    vindir_remove_showroom(&vin_directory, s);
+    BPTreeCursor cur;
+    void* data;
+    bptree_cursor_first(&cur, s->salespersons);
+    while (bptree_cursor_next(&cur, NULL, &data))
+        leaderboard_remove(&leaderboard, (Salesperson*)data);
+    if (s->arena) {
+        arena_destroy(s->arena);
+    } else {
+        bptree_cursor_first(&cur, s->salespersons);
+        while (bptree_cursor_next(&cur, NULL, &data))
+            bptree_destroy(((Salesperson*)data)->soldCarsRoot);
+        bptree_cursor_first(&cur, s->sold_stock);
+        while (bptree_cursor_next(&cur, NULL, &data))
+            arena_free(NULL, ((Car*)data)->sale, sizeof(Sale));
+        free_leaf_records(s->salespersons);
+        free_leaf_records(s->sold_stock);
+        free_leaf_records(s->available_stock);
+        bptree_destroy(s->salespersons);
+        bptree_destroy(s->sold_stock);
+        bptree_destroy(s->available_stock);
+        index_destroy(s->price_index);
+        index_destroy(s->model_index);
+        index_destroy(s->date_index);
+        index_destroy(s->payment_index);
+        arena_free(NULL, s->meta, sizeof(BPTreeMeta));
     }
+    s->arena = NULL;
+    s->meta = NULL;
+    s->available_stock = NULL;
+    s->sold_stock = NULL;
+    s->salespersons = NULL;
+    s->indexes = 0;
+    s->price_index = NULL;
+    s->model_index = NULL;
+    s->date_index = NULL;
+    s->payment_index = NULL;
+    pthread_mutex_destroy(&s->index_lock);
+    timeseries_free(s->series);
+    s->series = NULL;
+}
 
-    // Print the most successful sales person's details
-    if (most_successful_sales_person != NULL) {
-        printf("Most successful sales person: %s\n", most_successful_sales_person->name);
-        printf("Sales achieved: %.2f\n", most_successful_sales_person->achieved);
-        printf("Commission: %.2f\n", most_successful_sales_person->commission);
+// Showroom line: VIN Name Color Fuel Type Price
+int parse_car_line(LineScanner* sc, Car* car) {
+    Token f[PARSE_MAX_FIELDS];
+    int n = scanner_fields(sc, f, 6);
+    if (n != 6) {
+        scanner_error(sc, "expected 6 fields (VIN Name Color Fuel Type Price), found %s", n > 6 ? "more" : "fewer");
+        return 0;
+    }
+    if (!parse_int(f[0], &car->vin)) {
+        scanner_error(sc, "bad VIN '%.*s'", f[0].len, f[0].s);
+        return 0;
+    }
+    if (!parse_float(f[5], &car->price)) {
+        scanner_error(sc, "bad price '%.*s'", f[5].len, f[5].s);
+        return 0;
+    }
+    int model = dict_intern(&car_models, f[1].s, f[1].len);
+    int color = dict_intern(&car_colors, f[2].s, f[2].len);
+    int fuel = dict_intern(&car_fuels, f[3].s, f[3].len);
+    int type = dict_intern(&car_types, f[4].s, f[4].len);
+    if (model > CAR_MAX_DICT_ID || color > CAR_MAX_DICT_ID || fuel > CAR_MAX_DICT_ID || type > CAR_MAX_DICT_ID) {
+        scanner_error(sc, "too many distinct car attributes");
+        return 0;
+    }
+    car->model = (unsigned short)model;
+    car->color = (unsigned short)color;
+    car->fuel = (unsigned short)fuel;
+    car->type = (unsigned short)type;
+    car->sale = NULL;
+    return 1;
+}
 
-        // Award 1% extra incentives
-        float extra_incentives = most_successful_sales_person->achieved * 0.01;
-        most_successful_sales_person->commission += extra_incentives;
-        printf("Extra incentives: %.2f\n", extra_incentives);
-        printf("New commission: %.2f\n", most_successful_sales_person->commission);
-    } else {
-        printf("No sales person found.\n");
+// Salesperson line: ID Name Target Achieved Commission
+int parse_salesperson_line(LineScanner* sc, Salesperson* s) {
+    Token f[PARSE_MAX_FIELDS];
+    int n = scanner_fields(sc, f, 5);
+    if (n != 5) {
+        scanner_error(sc, "expected 5 fields (ID Name Target Achieved Commission), found %s", n > 5 ? "more" : "fewer");
+        return 0;
     }
+    if (!parse_int(f[0], &s->id) || !parse_float(f[2], &s->target) ||
+        !parse_float(f[3], &s->achieved) || !parse_float(f[4], &s->commission)) {
+        scanner_error(sc, "bad number in salesperson record");
+        return 0;
+    }
+    copy_token(sc, f[1], s->name, NAME_LEN, "name");
+    return 1;
 }
 
-void display_car_info(Showroom* showrooms, int vin) {
-    // Read the showrooms text files
-    char* srfiles[3] = { "showroom1.txt", "showroom2.txt", "showroom3.txt" };
-    for (int i = 0; i < 3; i++) {
-        FILE* file = fopen(srfiles[i], "r");
-        if (file == NULL) {
-            printf("Error opening file!\n");
-            return;
-        }
+// Customer line: SalespersonID Name Mobile Address VIN RegNo Date PaymentMethod PaymentCode
+int parse_purchase_line(LineScanner* sc, int* spid, int* vin, Sale* c) {
+    Token f[PARSE_MAX_FIELDS];
+    int n = scanner_fields(sc, f, 9);
+    if (n != 9) {
+        scanner_error(sc, "expected 9 fields (SalespersonID Name Mobile Address VIN RegNo Date Payment Code), found %s",
+                      n > 9 ? "more" : "fewer");
+        return 0;
+    }
+    if (!parse_int(f[0], spid) || !parse_int(f[4], vin) ||
+        !parse_int(f[6], &c->d_o_prchse) || !parse_int(f[8], &c->payment_code)) {
+        scanner_error(sc, "bad number in customer record");
+        return 0;
+    }
+    copy_token(sc, f[1], c->cust_name, NAME_LEN, "customer name");
+    copy_token(sc, f[2], c->cust_mobile, NAME_LEN, "mobile");
+    copy_token(sc, f[3], c->cust_address, ADDRESS_LEN, "address");
+    copy_token(sc, f[5], c->reg_no, NAME_LEN, "registration number");
+    copy_token(sc, f[7], c->payment_method, NAME_LEN, "payment method");
+    return 1;
+}
 
-        // Read the file line by line
-        char line[256];
-        while (fgets(line, sizeof(line), file)) {
-            // Parse the line
-            int vin_num;
-            char name[256];
-            char color[256];
-            char fuel[256];
-            char type[256];
-            float price;
-            sscanf(line, "%d %s %s %s %s %f", &vin_num, name, color, fuel, type, &price);
-
-            // Check if the VIN number matches
-            if (vin_num == vin) {
-                // Print the car information
-                printf("VIN: %d\n", vin_num);
-                printf("Name: %s\n", name);
-                printf("Color: %s\n", color);
-                printf("Fuel: %s\n", fuel);
-                printf("Type: %s\n", type);
-                printf("Price: %.2f\n", price);
-                return;
+// Parses every car line left in sc into records allocated from arena.
+// The VINs and records come back in file order; returns how many.
+int parse_car_lines(LineScanner* sc, Arena* arena, int** vins_out, void*** cars_out) {
+    int n = 0, capacity = 1024;
+    int* vins = (int*)malloc(capacity * sizeof(int));
+    void** cars = (void**)malloc(capacity * sizeof(void*));
+    if (!vins || !cars) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+
+    while (scanner_next_line(sc)) {
+        Car tmp;
+        if (!parse_car_line(sc, &tmp))
+            continue;
+
+        Car* car = (Car*)arena_alloc(arena, sizeof(Car));
+        *car = tmp;
+
+        if (n == capacity) {
+            capacity *= 2;
+            vins = (int*)realloc(vins, capacity * sizeof(int));
+            cars = (void**)realloc(cars, capacity * sizeof(void*));
+            if (!vins || !cars) {
+                printf("Memory allocation failed!\n");
+                exit(1);
             }
         }
-
-        // Close the file
-        fclose(file);
+        vins[n] = car->vin;
+        cars[n++] = car;
     }
 
-    // If the car is not found, print a message
-    printf("Car with VIN %d not found.\n", vin);
+    *vins_out = vins;
+    *cars_out = cars;
+    return n;
 }
 
-void search_sales_person_by_sales_range(Showroom* showrooms, float min_sales, float max_sales) {
-    // Iterate through each showroom
-    for (int i = 0; i < 3; i++) {
-        // Iterate through the sales persons of the current showroom
-        BPTreeNode* node = showrooms[i].salespersons;
-        while (node) {
-            // Iterate through each sales person in the current node
-            for (int j = 0; j < node->num_keys; j++) {
-                // Get the sales person's sales data
-                Salesperson* sales_person = (Salesperson*)node->ptr[j];
+void load_showroom_data(Showroom* showroom, const char* filename) {
+    TextFile tf;
+    if (!text_file_open(&tf, filename)) return;
+    LineScanner sc;
+    scanner_init(&sc, filename, tf.data, tf.size);
+
+    int* vins;
+    void** cars;
+    int n = parse_car_lines(&sc, showroom->arena, &vins, &cars);
+    text_file_close(&tf);
+
+    // Inventory files are sorted by VIN, so this is a linear bottom-up build
+    bptree_bulk_load(&showroom->available_stock, vins, cars, n, bptree_bulk_fill);
+    free(vins);
+    free(cars);
+    vindir_add_showroom(&vin_directory, showroom);
+    if (report_log_level == LOG_SUMMARY) log_inventory_summary(showroom, n, filename);
+}
 
-                // Check if the sales person's sales fall within the specified range
-                if (sales_person->achieved >= min_sales && sales_person->achieved <= max_sales) {
-                    printf("Showroom: %d | Salesperson ID: %d | Name: %s | Target: %.2f | Achieved: %.2f | Commission: %.2f\n",
-                           i+1,sales_person->id, sales_person->name, sales_person->target, sales_person->achieved, sales_person->commission);
-                }
-            }
-            node = node->next;
-        }
-    }
+// The inventory file's LOG_SUMMARY line; cars have no per-record lines.
+void log_inventory_summary(Showroom* showroom, int cars, const char* filename) {
+    Report log;
+    report_init(&log, NULL, REPORT_TABLE);
+    report_text(&log, "Showroom %d: %d car(s) from %s\n", showroom->showroom_id, cars, filename);
+    report_free(&log);
 }
 
-void merge_and_sort_database(Showroom* showrooms) {
-    FILE* merge_file = fopen("merge.txt", "w");
-    if (merge_file == NULL) {
-        printf("Error opening file!\n");
-        return;
+void load_salespersons(Showroom* showroom, const char* filename) {
+    TextFile tf;
+    if (!text_file_open(&tf, filename)) return;
+    LineScanner sc;
+    scanner_init(&sc, filename, tf.data, tf.size);
+    Report log;
+    report_init(&log, NULL, REPORT_TABLE);
+    int loaded = 0;
+
+    while (scanner_next_line(&sc)) {
+        Salesperson tmp;
+        if (!parse_salesperson_line(&sc, &tmp))
+            continue;
+
+        Salesperson* s = (Salesperson*)arena_alloc(showroom->arena, sizeof(Salesperson));
+        *s = tmp;
+        s->soldCarsRoot = create_bptree_meta(showroom->meta);
+
+        if (report_log_level == LOG_ROWS) report_text(&log, "Inserted salesperson car with id: %d\n", s->id);
+        bptree_insert(&showroom->salespersons, s->id, s);
+        leaderboard_add(&leaderboard, showroom->showroom_id, s);
+        loaded++;
     }
 
-    for (int i = 0; i < 3; i++) {
-        BPTreeNode* node = showrooms[i].available_stock;
+    if (report_log_level == LOG_SUMMARY)
+        report_text(&log, "Showroom %d: %d salesperson(s) from %s\n", showroom->showroom_id, loaded, filename);
+    report_free(&log);
+    text_file_close(&tf);
+}
 
-        // Move to the leftmost leaf node
-        while (node != NULL && !node->is_leaf) {
-            node = (BPTreeNode*)node->ptr[0];
+// Applies the purchases SALE_BATCH lines at a time through sell_cars_batch
+// and logs them in file order (see report_log_level).
+void process_customer_purchases(Showroom* showroom, const char* filename) {
+    TextFile tf;
+    if (!text_file_open(&tf, filename)) return;
+    LineScanner sc;
+    scanner_init(&sc, filename, tf.data, tf.size);
+
+    Sale* sales = (Sale*)malloc(SALE_BATCH * sizeof(Sale));
+    SaleRequest* reqs = (SaleRequest*)malloc(SALE_BATCH * sizeof(SaleRequest));
+    if (!sales || !reqs) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    Report log;
+    report_init(&log, NULL, REPORT_TABLE);
+    int n = 0, lines = 0, sold = 0;
+    int more = 1;
+    while (more) {
+        more = scanner_next_line(&sc);
+        if (more) {
+            int spid, vin;
+            Sale* c = &sales[n];
+            if (!parse_purchase_line(&sc, &spid, &vin, c))
+                continue;
+
+            Salesperson* sp = get_salesperson(showroom->salespersons, spid);
+            if (!sp) continue;
+            reqs[n].vin = vin;
+            reqs[n].sp = sp;
+            reqs[n].sale = c;
+            if (++n < SALE_BATCH) continue;
         }
 
-        // Now traverse all leaf nodes using linked list
-        while (node != NULL) {
-            for (int j = 0; j < node->num_keys; j++) {
-                Car* car = (Car*)node->ptr[j];
-                fprintf(merge_file, "%d %s %s %s %s %.2f\n", car->vin, car->name, car->color, car->fuel, car->type, car->price);
-            }
-            node = node->next;
+        sold += sell_cars_batch(showroom, reqs, n);
+        lines += n;
+        for (int i = 0; i < n && report_log_level == LOG_ROWS; i++) {
+            report_text(&log, "Getting customers too :) ");
+            print_sale_status(&log, showroom, reqs[i].vin, reqs[i].status);
         }
+        n = 0;
     }
 
-    fclose(merge_file);
+    if (report_log_level == LOG_SUMMARY)
+        report_text(&log, "Showroom %d: %d of %d purchase(s) from %s applied\n", showroom->showroom_id, sold, lines,
+                    filename);
+    report_free(&log);
+    free(sales);
+    free(reqs);
+    text_file_close(&tf);
 }
 
+Salesperson* showroom_add_salesperson(Showroom* showroom, int id, const char* name, float target) {
+    Salesperson* s = (Salesperson*)arena_alloc(showroom->arena, sizeof(Salesperson));
+    s->id = id;
+    snprintf(s->name, NAME_LEN, "%s", name);
+    s->target = target;
+    s->achieved = 0.0;
+    s->commission = 0.0;
+    s->soldCarsRoot = create_bptree_meta(showroom->meta);
+    bptree_insert(&showroom->salespersons, s->id, s);
+    leaderboard_add(&leaderboard, showroom->showroom_id, s);
+    return s;
+}
 
-void predict_next_month_sales_helper(BPTreeNode* node, int previous_month, int current_month, int current_year, int* previous_month_sales, int* current_month_sales) {
-    if (node->is_leaf) {
-        for (int j = 0; j < node->num_keys; j++) {
-            Car* car = (Car*)node->ptr[j];
-            int purchase_day = car->d_o_prchse / 1000000;
-            int purchase_month = (car->d_o_prchse / 10000) % 100;
-            int purchase_year = car->d_o_prchse % 10000;
-
-            // Check if the purchase month is the previous month
-            if (purchase_month == previous_month && purchase_year == current_year) {
-                (*previous_month_sales)++;
-            }
+void add_new_salesperson(Showroom* showroom) {
+    int id;
+    char name[NAME_LEN];
+    printf("Enter Salesperson ID: ");
+    scanf("%d", &id);
+    printf("Enter Name: ");
+    scanf("%49s", name);
+    Salesperson* s = showroom_add_salesperson(showroom, id, name, 50.0);
+    if (showroom->wal) wal_log_salesperson(showroom->wal, showroom, s);
+    printf("Inserted car with VIN: %d\n", s->id);
+    printf("Salesperson added.\n");
+}
 
-            // Check if the purchase month is the current month
-            if (purchase_month == current_month && purchase_year == current_year) {
-                (*current_month_sales)++;
-            }
-        }
-    } else {
-        // Traverse the child nodes
-        for (int j = 0; j <= node->num_keys; j++) {
-            BPTreeNode* child_node = (BPTreeNode*)node->ptr[j];
-            if (child_node != NULL) {
-                predict_next_month_sales_helper(child_node, previous_month, current_month, current_year, previous_month_sales, current_month_sales);
-            }
-        }
+void add_new_customer(Showroom* showroom) {
+    Sale details;
+    Sale* cust = &details;
+    int spid, vin;
+    printf("Enter Customer Name, Mobile, Address:\n");
+    scanf("%s %s %s", cust->cust_name, cust->cust_mobile, cust->cust_address);
+    printf("Enter VIN of car, Registration No.,date of purchase, Payment Method and payment code(0 for Cash, 1 for 9.00% rate of interest for 84 months EMI,/n 2 for 8.75% rate of interest for 60 months EMI,/n 3 for 8.50% rate of interest for 36 months EMI.):\n");
+    scanf("%d %s %d %s %d", &vin, cust->reg_no,&cust->d_o_prchse, cust->payment_method,&cust->payment_code);
+    printf("Enter Salesperson ID:\n");
+    scanf("%d", &spid);
+
+    Salesperson* sp = get_salesperson(showroom->salespersons, spid);
+    if (!sp) {
+        printf("Salesperson not found.\n");
+        return;
     }
+
+    sell_car(showroom, vin, sp, cust);
 }
 
+// The leaderboard keeps everyone in order, so this is its first entry.
+void find_most_successful_sales_person(Showroom* showrooms, int count) {
+    LeaderEntry top;
+    if (leaderboard_top(&leaderboard, 1, &top) == 1 && top.achieved > 0) {
+        Salesperson* most_successful_sales_person = top.sp;
+        float commission = most_successful_sales_person->commission;
 
-void predict_next_month_sales(Showroom* showrooms, int today_date) {
-    int current_day = today_date / 1000000;
-    int current_month = (today_date / 10000) % 100;
-    int current_year = today_date % 10000;
+        // Award 1% extra incentives
+        float extra_incentives = most_successful_sales_person->achieved * 0.01;
+        most_successful_sales_person->commission += extra_incentives;
 
-    int previous_month = current_month - 1;
-    if (previous_month == 0) {
-        previous_month = 12;
-        current_year--;
+        report_begin(&report, 0);
+        report_str(&report, "Most successful sales person", "name", most_successful_sales_person->name);
+        report_break(&report, 0);
+        report_money(&report, "Sales achieved", "achieved", most_successful_sales_person->achieved);
+        report_break(&report, 0);
+        report_money(&report, "Commission", "commission", commission);
+        report_break(&report, 0);
+        report_money(&report, "Extra incentives", "extra_incentives", extra_incentives);
+        report_break(&report, 0);
+        report_money(&report, "New commission", "new_commission", most_successful_sales_person->commission);
+        report_end(&report);
+    } else {
+        report_message(&report, "No sales person found.\n");
     }
+}
 
-    int previous_month_sales = 0;
-    int current_month_sales = 0;
-
-    // Traverse all three showrooms
-    for (int i = 0; i < 3; i++) {
-        // Traverse the sold cars tree
-        BPTreeNode* sold_cars_node = showrooms[i].sold_stock;
-        while (sold_cars_node != NULL) {
-            // Traverse the leaf nodes
-            if (sold_cars_node->is_leaf) {
-                for (int j = 0; j < sold_cars_node->num_keys; j++) {
-                    Car* car = (Car*)sold_cars_node->ptr[j];
-                    int purchase_day = car->d_o_prchse / 1000000;
-                    int purchase_month = (car->d_o_prchse / 10000) % 100;
-                    int purchase_year = car->d_o_prchse % 10000;
+// Answers from the VIN directory instead of rereading the text files.
+void display_car_info(Showroom* showrooms, int count, int vin) {
+    VinLookup r;
+    vindir_lookup(&vin_directory, vin, &r);
+    report_vin_lookup(&report, vin, &r);
+}
 
-                    // Check if the purchase month is the previous month
-                    if (purchase_month == previous_month && purchase_year == current_year) {
-                        previous_month_sales++;
-                    }
+int compare_entries_by_showroom(const void* a, const void* b) {
+    const LeaderEntry* x = (const LeaderEntry*)a;
+    const LeaderEntry* y = (const LeaderEntry*)b;
+    if (x->showroom_id != y->showroom_id) return x->showroom_id - y->showroom_id;
+    return (x->sp->id > y->sp->id) - (x->sp->id < y->sp->id);
+}
 
-                    // Check if the purchase month is the current month
-                    if (purchase_month == current_month && purchase_year == current_year) {
-                        current_month_sales++;
-                    }
-                }
-            } else {
-                // Traverse the child nodes
-                for (int j = 0; j <= sold_cars_node->num_keys; j++) {
-                    BPTreeNode* child_node = (BPTreeNode*)sold_cars_node->ptr[j];
-                    if (child_node != NULL) {
-                        predict_next_month_sales_helper(child_node, previous_month, current_month, current_year, &previous_month_sales, &current_month_sales);
-                    }
-                }
-            }
+// Range query on the leaderboard; listed by showroom and ID as before.
+void search_sales_person_by_sales_range(Showroom* showrooms, int count, float min_sales, float max_sales) {
+    LeaderEntry* found;
+    long n = leaderboard_range(&leaderboard, min_sales, max_sales, &found);
+    qsort(found, n, sizeof(LeaderEntry), compare_entries_by_showroom);
+    for (long i = 0; i < n; i++)
+        report_salesperson(&report, found[i].sp, found[i].showroom_id);
+    free(found);
+}
 
-            sold_cars_node = sold_cars_node->next;
-        }
+// Simple average of this month's and last month's sales, overall and per
+// model, read from the sales time series instead of walking sold_stock.
+void predict_next_month_sales(Showroom* showrooms, int count, int today_date) {
+    int current_month = ts_month_number(today_date);
+    if (current_month < 0) {
+        report_message(&report, "Invalid date.\n");
+        return;
     }
 
-    // Predict the next month's sales using a simple average algorithm
-    float next_month_sales = (previous_month_sales + current_month_sales) / 2;
-
-    printf("Predicted sales for next month: %.2f\n", next_month_sales);
-}
-
-void print_customers_with_36_months_emi_loan(Showroom* showrooms) {
-    // Traverse all three showrooms
-    for (int i = 0; i < 3; i++) {
-        BPTreeNode* sold_cars_node = showrooms[i].sold_stock;
-        while (sold_cars_node != NULL) {
-            if (sold_cars_node->is_leaf) {
-                for (int j = 0; j < sold_cars_node->num_keys; j++) {
-                    Car* car = (Car*)sold_cars_node->ptr[j];
-                    if (car->payment_code == 4) {
-                        printf("Customer Name: %s\n", car->cust_name);
-                        printf("Customer Mobile: %s\n", car->cust_mobile);
-                        printf("Customer Address: %s\n", car->cust_address);
-                        printf("Registration Number: %s\n", car->reg_no);
-                        printf("Payment Method: %s\n", car->payment_method);
-                        printf("Payment Code: %d\n", car->payment_code);
-                        printf("\n");
-                    }
-                }
-            } else {
-                for (int j = 0; j <= sold_cars_node->num_keys; j++) {
-                    BPTreeNode* child_node = (BPTreeNode*)sold_cars_node->ptr[j];
-                    if (child_node != NULL) {
-                        if (child_node->is_leaf) {
-                            for (int k = 0; k < child_node->num_keys; k++) {
-                                Car* car = (Car*)child_node->ptr[k];
-                                if (car->payment_code == 4) {
-                                    printf("Customer Name: %s\n", car->cust_name);
-                                    printf("Customer Mobile: %s\n", car->cust_mobile);
-                                    printf("Customer Address: %s\n", car->cust_address);
-                                    printf("Registration Number: %s\n", car->reg_no);
-                                    printf("Payment Method: %s\n", car->payment_method);
-                                    printf("Payment Code: %d\n", car->payment_code);
-                                    printf("\n");
-                                }
-                            }
-                        } else {
-                            for (int k = 0; k <= child_node->num_keys; k++) {
-                                BPTreeNode* grandchild_node = (BPTreeNode*)child_node->ptr[k];
-                                if (grandchild_node != NULL) {
-                                    for (int l = 0; l < grandchild_node->num_keys; l++) {
-                                        Car* car = (Car*)grandchild_node->ptr[l];
-                                        if (car->payment_code == 4) {
-                                            printf("Customer Name: %s\n", car->cust_name);
-                                            printf("Customer Mobile: %s\n", car->cust_mobile);
-                                            printf("Customer Address: %s\n", car->cust_address);
-                                            printf("Registration Number: %s\n", car->reg_no);
-                                            printf("Payment Method: %s\n", car->payment_method);
-                                            printf("Payment Code: %d\n", car->payment_code);
-                                            printf("\n");
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-
-            sold_cars_node = sold_cars_node->next;
-        }
+    SalesBucket b[2];
+    timeseries_months(showrooms, count, current_month, 2, b);
+    report_begin(&report, 0);
+    report_str(&report, NULL, "model", "all");
+    report_money(&report, "Predicted sales for next month", "predicted", timeseries_moving_average(b, 2, 2));
+    report_end(&report);
+
+    int models = car_models.count;
+    for (int m = 0; m < models; m++) {
+        timeseries_model_months(showrooms, count, m, current_month, 2, b);
+        if (b[0].count + b[1].count == 0) continue;
+        report_begin(&report, 4);
+        report_str(&report, "Model", "model", dict_name(&car_models, m));
+        report_money(&report, "Predicted", "predicted", timeseries_moving_average(b, 2, 2));
+        report_end(&report);
     }
 }
 
+// Prompts for a showroom ID; returns 0 if it is out of range.
+int read_showroom_id(int count) {
+    int id = 0;
+    printf("Enter Showroom ID (1-%d): ", count);
+    scanf("%d", &id);
+    if (id < 1 || id > count) {
+        printf("Invalid showroom ID.\n");
+        return 0;
+    }
+    return id;
+}
 
-void menu(Showroom* showrooms) {
+void menu(Showroom* showrooms, int count) {
     int opt;
     while (1) {
         printf("\nMenu:\n");
@@ -803,6 +1756,13 @@ void menu(Showroom* showrooms) {
         printf("10. View the information of a car based on VIN.\n");
         printf("11. View the sales persons who has achieved the sales target within a range of vales.\n");
         printf("12. View list of customers having EMI plan for less than 48 month but greater than 36 months.\n");
+        printf("14. View cars in stock within a price range.\n");
+        printf("15. View cars sold between two dates.\n");
+        printf("16. View sales breakdown by model, color, fuel or type.\n");
+        printf("17. Save a binary snapshot of all showrooms.\n");
+        printf("18. View the top sales persons among all the showrooms.\n");
+        printf("19. View the monthly sales trend.\n");
+        printf("20. View the loan portfolio as of a date.\n");
         printf("13. Exit\n");
         printf("Enter choice: ");
         scanf("%d", &opt);
@@ -811,58 +1771,94 @@ void menu(Showroom* showrooms) {
         int today_date;
         int vin;
         int mins,maxs;
+        float min_price, max_price;
+        int from_date, to_date;
+        int field;
         switch (opt) {
             case 1:
-                printf("Enter Showroom ID (1-3): ");
-                scanf("%d", &id);
+                if ((id = read_showroom_id(count)) == 0) break;
                 bptree_traverse(showrooms[id - 1].available_stock, 1);
                 break;
             case 2:
-                printf("Enter Showroom ID (1-3): ");
-                scanf("%d", &id);
+                if ((id = read_showroom_id(count)) == 0) break;
                 bptree_traverse(showrooms[id - 1].sold_stock, 1);
                 break;
             case 3:
-                printf("Enter Showroom ID (1-3): ");
-                scanf("%d", &id);
+                if ((id = read_showroom_id(count)) == 0) break;
                 bptree_traverse(showrooms[id - 1].salespersons, 0);
                 break;
             case 4:
-                printf("Enter Showroom ID (1-3): ");
-                scanf("%d", &id);
+                if ((id = read_showroom_id(count)) == 0) break;
                 add_new_salesperson(&showrooms[id - 1]);
                 break;
             case 5:
-                printf("Enter Showroom ID (1-3): ");
-                scanf("%d", &id);
+                if ((id = read_showroom_id(count)) == 0) break;
                 add_new_customer(&showrooms[id - 1]);
                 break;
             case 6:
-                merge_and_sort_database(showrooms);
+                merge_and_sort_database(showrooms, count);
                 break;
             case 7:
-                find_most_popular_car(showrooms);
+                find_most_popular_car(showrooms, count);
                 break;
             case 8:
-                find_most_successful_sales_person(showrooms); 
+                find_most_successful_sales_person(showrooms, count); 
                 break;  
             case 9:
                 printf("Enter the date to predict the slaes for next month: ");
                 scanf("%d", &today_date);
-                predict_next_month_sales(showrooms, today_date);
+                predict_next_month_sales(showrooms, count, today_date);
                 break;
             case 10:
                 printf("Enter the VIN of a car to view its details: ");
                 scanf("%d", &vin);
-                display_car_info(showrooms, vin);
+                display_car_info(showrooms, count, vin);
                 break;
             case 11:
                 printf("Enter the range of the sales person's target to view: ");
                 scanf("%d %d",&mins,&maxs);
-                search_sales_person_by_sales_range(showrooms, mins, maxs);
+                search_sales_person_by_sales_range(showrooms, count, mins, maxs);
                 break;
             case 12:
-                print_customers_with_36_months_emi_loan(showrooms);
+                print_customers_with_36_months_emi_loan(showrooms, count);
+                break;
+            case 14:
+                printf("Enter the minimum and maximum price: ");
+                scanf("%f %f", &min_price, &max_price);
+                list_cars_in_price_range(showrooms, count, min_price, max_price);
+                break;
+            case 15:
+                printf("Enter the start and end dates (ddmmyyyy): ");
+                scanf("%d %d", &from_date, &to_date);
+                list_sales_between_dates(showrooms, count, from_date, to_date);
+                break;
+            case 16:
+                printf("Group by (1 Model, 2 Color, 3 Fuel, 4 Type): ");
+                scanf("%d", &field);
+                if (field < 1 || field > 4) {
+                    printf("Invalid option.\n");
+                    break;
+                }
+                print_sales_breakdown(showrooms, count, (GroupField)(field - 1));
+                break;
+            case 17:
+                if (snapshot_write(SNAPSHOT_DEFAULT_PATH, showrooms, count))
+                    printf("Saved snapshot to %s\n", SNAPSHOT_DEFAULT_PATH);
+                break;
+            case 18:
+                printf("How many sales persons to show: ");
+                scanf("%d", &field);
+                print_leaderboard(field);
+                break;
+            case 19:
+                printf("Enter today's date (ddmmyyyy) and the number of months: ");
+                scanf("%d %d", &today_date, &field);
+                print_sales_trend(showrooms, count, today_date, field);
+                break;
+            case 20:
+                printf("Enter the date (ddmmyyyy): ");
+                scanf("%d", &today_date);
+                print_loan_portfolio(showrooms, count, today_date);
                 break;
             case 13:
                 printf("Exiting the car Showroom Management 2.");
@@ -871,5 +1867,6 @@ void menu(Showroom* showrooms) {
                 printf("Invalid option.\n");
                 break;
         }
+        report_flush(&report);
     }
 }
@@ -1,19 +1,28 @@
 #ifndef SHOWROOM_H
 #define SHOWROOM_H
 
-#define MAX 4   // B+ Tree Order
+#include "arena.h"
+#include "parse.h"
+#include "epoch.h"
+#include "report.h"
+
+#define BPTREE_DEFAULT_ORDER 31   // B+ Tree Order: 32 key slots = two 64-byte cache lines
+#define BPTREE_MIN_ORDER 3
+#define BPTREE_DEFAULT_FILL 0.9   // leaf fill factor for bulk loads
+#define BPTREE_MAX_HEIGHT 64      // fanout >= 2, so 64 levels outgrow any key count
+#define SALE_BATCH 65536          // purchase lines applied per sell_cars_batch
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BPTREE_HAVE_X86_SIMD 1
+#else
+#define BPTREE_HAVE_X86_SIMD 0
+#endif
 #define NAME_LEN 50
 #define ADDRESS_LEN 100
 
-//  Car Structure 
-typedef struct Car {
-    int vin;
-    char name[NAME_LEN];
-    char color[NAME_LEN];
-    float price;
-    char fuel[NAME_LEN];
-    char type[NAME_LEN]; // Hatchback, Sedan, SUV
-    // Customer Details (added after sale)
+//  Sale Record (cold): customer and payment details, attached to a Car
+//  only once it is sold
+typedef struct Sale {
     char cust_name[NAME_LEN];
     char cust_mobile[NAME_LEN];
     char cust_address[ADDRESS_LEN];
@@ -21,18 +30,62 @@ typedef struct Car {
     int d_o_prchse;
     char payment_method[NAME_LEN]; // Cash or Loan
     int payment_code;
+} Sale;
+
+//  Car Structure (hot): what inventory scans touch, 24 bytes
+typedef struct Car {
+    int vin;
+    float price;
+    unsigned short model;   // id in car_models
+    unsigned short color;   // id in car_colors
+    unsigned short fuel;    // id in car_fuels
+    unsigned short type;    // id in car_types: Hatchback, Sedan, SUV
+    Sale* sale;             // NULL while the car is in stock
 } Car;
 
+#define CAR_MAX_DICT_ID 65535
+
+//  Per-tree settings, shared by every node of one tree
+typedef struct BPTreeMeta {
+    int order;          // max keys per node
+    size_t node_size;   // header + key and pointer slots
+    Arena* arena;       // where nodes come from, NULL = malloc
+} BPTreeMeta;
+
 //  B+ Tree Node
+//  keys and ptr point into the same allocation, right after the node header,
+//  so a node of any order is still a single block.
 typedef struct BPTreeNode {
     int is_leaf;
     int num_keys;
-    int keys[MAX + 1];
-    void* ptr[MAX + 2]; // can be Car*, Salesperson*, or node
+    VersionLatch latch; // writers crab down with it; readers only validate it
+    int* keys;          // order + 1 slots
+    void** ptr;         // order + 2 slots, can be Car*, Salesperson*, or node
+    BPTreeMeta* meta;
     struct BPTreeNode* parent;
     struct BPTreeNode* next; // Used in leaf nodes
 } BPTreeNode;
 
+//  Leaf cursor for full and range scans
+typedef struct BPTreeCursor {
+    BPTreeNode* leaf;
+    int pos;
+    int has_hi;         // stop after hi
+    int hi;
+} BPTreeCursor;
+
+//  Shape of a tree, see bptree_stats
+typedef struct BPTreeStats {
+    int height;
+    long nodes;
+    long leaves;
+    long keys;              // leaf entries, tombstones included
+    long tombstones;        // left by bptree_delete_lazy
+    long internal_keys;
+    double leaf_fill;       // keys per leaf slot
+    double internal_fill;   // keys per internal slot
+} BPTreeStats;
+
 //  Salesperson Structure 
 typedef struct Salesperson {
     int id;
@@ -42,30 +95,119 @@ typedef struct Salesperson {
     float commission;
 
     BPTreeNode* soldCarsRoot; // B+ tree of sold cars (Car nodes)
+    struct LeaderNode* rank_node; // position in the leaderboard, NULL if unranked
 } Salesperson;
 
 //  Showroom Structure
 typedef struct Showroom {
     int showroom_id;
+    Arena* arena;                  // owns cars, salespersons and tree nodes, NULL = malloc
+    BPTreeMeta* meta;              // shared by all trees of this showroom
     BPTreeNode* available_stock;   // VIN-based car tree
     BPTreeNode* sold_stock;        // VIN-based sold cars tree
     BPTreeNode* salespersons;      // Salesperson tree (ID-based)
+
+    // Optional secondary indexes (see index.h), NULL until enabled
+    int indexes;                   // IDX_* flags
+    BPTreeNode* price_index;       // available cars by price
+    BPTreeNode* model_index;       // sold cars by model id
+    BPTreeNode* date_index;        // sold cars by yyyymmdd
+    BPTreeNode* payment_index;     // sold cars by payment code
+    pthread_mutex_t index_lock;    // serializes index upkeep by concurrent sales
+    struct SalesSeries* series;    // daily and monthly sales (see timeseries.h)
+    struct Wal* wal;               // write-ahead log for terminal changes, NULL = off
+    int lazy_delete;               // sales leave tombstones in available_stock
 } Showroom;
 
+//  Outcome of showroom_sell_car
+typedef enum SaleStatus {
+    SALE_OK,
+    SALE_NOT_FOUND,         // VIN not in available_stock
+    SALE_ALREADY_SOLD       // another terminal claimed the car first
+} SaleStatus;
+
+//  One sale of a batch for sell_cars_batch
+typedef struct SaleRequest {
+    int vin;
+    Salesperson* sp;
+    const Sale* sale;       // customer details, copied when the car sells
+    SaleStatus status;      // set by the batch
+    Car* car;               // set by the batch, NULL unless SALE_OK
+} SaleRequest;
+
 // Function Declarations 
 BPTreeNode* create_bptree();
+BPTreeNode* create_bptree_order(int order);
+BPTreeNode* create_bptree_meta(BPTreeMeta* meta);
+BPTreeMeta* bptree_new_meta(int order, Arena* arena);
+void bptree_free_node(BPTreeNode* node);
+void bptree_destroy(BPTreeNode* root);
+void bptree_set_default_order(int order);
+int bptree_height(BPTreeNode* root);
+
+// In-node rank (number of keys <= key); selected at runtime for the CPU
+extern int (*bptree_rank)(const int* keys, int n, int key);
+int bptree_rank_scalar(const int* keys, int n, int key);
+int bptree_rank_binary(const int* keys, int n, int key);
+#if BPTREE_HAVE_X86_SIMD
+int bptree_rank_sse2(const int* keys, int n, int key);
+int bptree_rank_avx2(const int* keys, int n, int key);
+#endif
+const char* bptree_rank_name();
 void bptree_insert(BPTreeNode** root, int key, void* data);
 void* bptree_search(BPTreeNode* root, int key);
+void** bptree_search_ref(BPTreeNode* root, int key);
+BPTreeNode* bptree_first_leaf(BPTreeNode* root);
+BPTreeNode* bptree_seek_leaf(BPTreeNode* root, int key, int* pos);
+void bptree_cursor_first(BPTreeCursor* c, BPTreeNode* root);
+void bptree_cursor_seek(BPTreeCursor* c, BPTreeNode* root, int key);
+void bptree_cursor_range(BPTreeCursor* c, BPTreeNode* root, int lo, int hi);
+int bptree_cursor_next(BPTreeCursor* c, int* key, void** data);
 void bptree_delete(BPTreeNode** root, int key);
+int bptree_delete_lazy(BPTreeNode** root, int key);
+void bptree_compact(BPTreeNode** root);
+void bptree_delete_sorted(BPTreeNode** root, int* keys, int n, int lazy, void** removed);
+void bptree_insert_sorted(BPTreeNode** root, int* keys, void** data, int n);
+void bptree_stats(BPTreeNode* root, BPTreeStats* st);
 void bptree_traverse(BPTreeNode* root, int is_car);
+void bptree_bulk_load(BPTreeNode** root, int* keys, void** data, int n, double fill);
+extern double bptree_bulk_fill;
 
+void showroom_init(Showroom* s, int id, int use_arena);
+void showroom_destroy(Showroom* s);
+void showroom_compact(Showroom* s);
+
+int parse_car_line(LineScanner* sc, Car* car);
+int parse_salesperson_line(LineScanner* sc, Salesperson* s);
+int parse_purchase_line(LineScanner* sc, int* spid, int* vin, Sale* cust);
+
+int parse_car_lines(LineScanner* sc, Arena* arena, int** vins, void*** cars);
 void load_showroom_data(Showroom* s, const char* filename);
+void log_inventory_summary(Showroom* s, int cars, const char* filename);
 void load_salespersons(Showroom* s, const char* filename);
-void load_customers(Showroom* s, const char* filename);
+void process_customer_purchases(Showroom* s, const char* filename);
 
-void sell_car(Showroom* showroom, int vin, Salesperson* sp, Car* customer_details);
+SaleStatus showroom_sell_car(Showroom* showroom, int vin, Salesperson* sp, const Sale* customer_details);
+void sell_car(Showroom* showroom, int vin, Salesperson* sp, Sale* customer_details);
+void print_sale_status(Report* r, Showroom* showroom, int vin, SaleStatus status);
+int sell_cars_batch(Showroom* showroom, SaleRequest* reqs, int n);
+void salesperson_credit(Salesperson* sp, float price);
+void salesperson_credit_all(Salesperson* sp, const float* prices, int n);
+Salesperson* showroom_add_salesperson(Showroom* showroom, int id, const char* name, float target);
 Salesperson* get_salesperson(BPTreeNode* root, int id);
 void display_car(Car* c);
+const char* car_name(const Car* c);
+const char* car_color(const Car* c);
+const char* car_fuel(const Car* c);
+const char* car_type(const Car* c);
 void display_salesperson(Salesperson* s);
+void report_car(Report* r, const Car* c, int showroom_id);
+void report_salesperson(Report* r, Salesperson* s, int showroom_id);
+
+void find_most_successful_sales_person(Showroom* showrooms, int count);
+void display_car_info(Showroom* showrooms, int count, int vin);
+void search_sales_person_by_sales_range(Showroom* showrooms, int count, float min_sales, float max_sales);
+void predict_next_month_sales(Showroom* showrooms, int count, int today_date);
+void menu(Showroom* showrooms, int count);
 
 #endif
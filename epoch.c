@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "epoch.h"
+
+// Epoch-based reclamation for the lock-free read path. A reader announces
+// the global epoch on entry; an object retired in epoch e is freed once the
+// global epoch reaches e + 2, because by then every reader still inside
+// entered after the object was unlinked.
+
+unsigned long epoch_global = 0;
+EpochThread* epoch_threads = NULL;     // every thread that ever entered, newest first
+__thread EpochThread* epoch_self = NULL;
+
+SpinLock epoch_retired_lock = SPIN_LOCK_INIT;
+EpochRetired* epoch_retired = NULL;    // newest first, so epochs never increase along the list
+long epoch_num_retired = 0;
+
+EpochThread* epoch_register() {
+    EpochThread* t = (EpochThread*)calloc(1, sizeof(EpochThread));
+    if (!t) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    t->next = __atomic_load_n(&epoch_threads, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&epoch_threads, &t->next, t, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+    epoch_self = t;
+    return t;
+}
+
+// Nests: only the outermost call announces.
+void epoch_enter() {
+    EpochThread* t = epoch_self ? epoch_self : epoch_register();
+    if (t->depth++ > 0) return;
+    // Until local is refreshed it may hold an old epoch, which only holds
+    // reclamation back for a moment
+    __atomic_store_n(&t->active, 1, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&t->local, __atomic_load_n(&epoch_global, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+}
+
+void epoch_exit() {
+    EpochThread* t = epoch_self;
+    if (--t->depth > 0) return;
+    __atomic_store_n(&t->active, 0, __ATOMIC_RELEASE);
+}
+
+// Moves the global epoch on if no reader is still announced in an older one.
+unsigned long epoch_try_advance() {
+    unsigned long global = __atomic_load_n(&epoch_global, __ATOMIC_SEQ_CST);
+    for (EpochThread* t = __atomic_load_n(&epoch_threads, __ATOMIC_ACQUIRE); t; t = t->next) {
+        if (__atomic_load_n(&t->active, __ATOMIC_SEQ_CST) &&
+            __atomic_load_n(&t->local, __ATOMIC_SEQ_CST) != global)
+            return global;
+    }
+    __atomic_compare_exchange_n(&epoch_global, &global, global + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&epoch_global, __ATOMIC_SEQ_CST);
+}
+
+// Frees the retired objects whose epoch is at most `upto`. Caller holds
+// epoch_retired_lock.
+void epoch_free_upto(unsigned long upto, int all) {
+    EpochRetired** link = &epoch_retired;
+    while (*link && !all && (*link)->epoch > upto) link = &(*link)->next;
+    EpochRetired* r = *link;
+    *link = NULL;
+    while (r) {
+        EpochRetired* next = r->next;
+        r->free_fn(r->p);
+        free(r);
+        epoch_num_retired--;
+        r = next;
+    }
+}
+
+// Hands p to free_fn once no reader can still be looking at it. The caller
+// must already have unlinked p from every shared structure.
+void epoch_retire(void* p, EpochFreeFn free_fn) {
+    EpochRetired* r = (EpochRetired*)malloc(sizeof(EpochRetired));
+    if (!r) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    r->p = p;
+    r->free_fn = free_fn;
+
+    spin_lock(&epoch_retired_lock);
+    r->epoch = __atomic_load_n(&epoch_global, __ATOMIC_SEQ_CST);
+    r->next = epoch_retired;
+    epoch_retired = r;
+    if (++epoch_num_retired % EPOCH_RECLAIM_EVERY == 0) {
+        unsigned long global = epoch_try_advance();
+        if (global >= 2) epoch_free_upto(global - 2, 0);
+    }
+    spin_unlock(&epoch_retired_lock);
+}
+
+// Frees everything still retired. Only call it while no thread is reading,
+// e.g. before the arena the objects came from is destroyed.
+void epoch_drain() {
+    spin_lock(&epoch_retired_lock);
+    epoch_free_upto(0, 1);
+    spin_unlock(&epoch_retired_lock);
+}
@@ -0,0 +1,31 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include "latch.h"
+
+#define EPOCH_RECLAIM_EVERY 64      // retirements between reclamation passes
+
+typedef void (*EpochFreeFn)(void* p);
+
+//  Per-thread announcement: the epoch a reader entered in, if it is inside one
+typedef struct EpochThread {
+    unsigned long local;
+    int active;
+    int depth;                      // nesting of epoch_enter calls
+    struct EpochThread* next;
+} EpochThread;
+
+//  Object unlinked by a writer, waiting for readers that may still see it
+typedef struct EpochRetired {
+    void* p;
+    EpochFreeFn free_fn;
+    unsigned long epoch;
+    struct EpochRetired* next;
+} EpochRetired;
+
+void epoch_enter();
+void epoch_exit();
+void epoch_retire(void* p, EpochFreeFn free_fn);
+void epoch_drain();
+
+#endif
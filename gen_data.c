@@ -0,0 +1,216 @@
+// Synthetic dataset generator: writes showroomN.txt, SalespersonN.txt and
+// CustomersN.txt in the formats the loader reads, at any size. Model
+// popularity and salesperson activity follow a Zipf law (-z 0 is uniform).
+// Build: gcc -O2 -o gen_data gen_data.c -lm
+// Run:   ./gen_data [-d dir] [-s showrooms] [-c cars] [-p salespersons] [-u sales]
+//                   [-z skew] [-y first_year] [-Y last_year] [-r seed]
+//        (defaults: . 3 1000 20 cars/4 1.0 2020 2024 1; counts are per showroom;
+//        dir is created if missing)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <sys/stat.h>
+
+#define GEN_PATH_LEN 512
+
+//  Car model with its body type and base price
+typedef struct GenModel {
+    const char* name;
+    const char* type;
+    int price;
+} GenModel;
+
+const GenModel gen_models[] = {
+    { "Swift", "Hatchback", 650000 },   { "Baleno", "Hatchback", 750000 },
+    { "Creta", "SUV", 1200000 },        { "Thar", "SUV", 1500000 },
+    { "City", "Sedan", 1150000 },       { "Verna", "Sedan", 1100000 },
+    { "Nexon", "SUV", 900000 },         { "Fortuner", "SUV", 3500000 },
+    { "XUV500", "SUV", 1700000 },       { "i20", "Hatchback", 800000 },
+    { "Ciaz", "Sedan", 950000 },        { "Innova", "MPV", 2000000 },
+};
+const char* gen_colors[] = { "White", "Black", "Red", "Blue", "Grey", "Silver" };
+const char* gen_fuels[] = { "Petrol", "Diesel", "CNG", "Electric" };
+const char* gen_first_names[] = { "Ashish", "Bhupesh", "Chitra", "Deepak", "Esha", "Farhan",
+                                  "Gauri", "Harsh", "Isha", "Jatin", "Kavya", "Lokesh" };
+const char* gen_cities[] = { "Hyderabad", "Pune", "Agra", "Nagpur", "Kurnool", "Varanasi", "Indore", "Mysore" };
+
+#define GEN_COUNT(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+//  Generator settings
+typedef struct GenConfig {
+    const char* dir;
+    int showrooms;
+    int cars;                   // per showroom
+    int salespersons;           // per showroom
+    int sales;                  // per showroom, at most cars
+    double skew;                // Zipf exponent
+    int first_year, last_year;
+    unsigned long long seed;
+} GenConfig;
+
+//  Cumulative Zipf weights over n ranks
+typedef struct Zipf {
+    double* cdf;
+    int n;
+} Zipf;
+
+unsigned long long gen_state;
+
+// splitmix64
+unsigned long long gen_next() {
+    unsigned long long z = (gen_state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+int gen_below(int bound) {
+    return (int)(gen_next() % (unsigned long long)bound);
+}
+
+double gen_unit() {
+    return (gen_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void zipf_init(Zipf* z, int n, double skew) {
+    z->n = n;
+    z->cdf = (double*)malloc(n * sizeof(double));
+    if (!z->cdf) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    double sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += 1.0 / pow(i + 1, skew);
+        z->cdf[i] = sum;
+    }
+    for (int i = 0; i < n; i++)
+        z->cdf[i] /= sum;
+}
+
+// Rank 0 is the most popular.
+int zipf_pick(const Zipf* z) {
+    double u = gen_unit();
+    int lo = 0, hi = z->n - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (z->cdf[mid] < u) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+FILE* gen_open(const GenConfig* cfg, const char* prefix, int id) {
+    char path[GEN_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/%s%d.txt", cfg->dir, prefix, id);
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    setvbuf(f, NULL, _IOFBF, 1 << 20);
+    return f;
+}
+
+void gen_close(FILE* f) {
+    if (ferror(f) || fclose(f) != 0) {
+        perror("write");
+        exit(1);
+    }
+}
+
+// Showroom id owns VINs (id - 1) * cars + 1 .. id * cars, written sorted.
+void gen_showroom(const GenConfig* cfg, int id, const Zipf* models, const Zipf* sellers, int* vins) {
+    FILE* f = gen_open(cfg, "showroom", id);
+    int first_vin = (id - 1) * cfg->cars + 1;
+    for (int i = 0; i < cfg->cars; i++) {
+        const GenModel* m = &gen_models[zipf_pick(models)];
+        int price = m->price + gen_below(21) * 10000 - 100000;
+        fprintf(f, "%d %s %s %s %s %d\n", first_vin + i, m->name, gen_colors[gen_below(GEN_COUNT(gen_colors))],
+                gen_fuels[gen_below(GEN_COUNT(gen_fuels))], m->type, price);
+        vins[i] = first_vin + i;
+    }
+    gen_close(f);
+
+    f = gen_open(cfg, "Salesperson", id);
+    for (int i = 1; i <= cfg->salespersons; i++)
+        fprintf(f, "%d %s%d %d 0 0\n", i, gen_first_names[i % GEN_COUNT(gen_first_names)], i,
+                500000 + gen_below(16) * 100000);
+    gen_close(f);
+
+    // Partial Fisher-Yates: the first `sales` slots become distinct sold VINs
+    f = gen_open(cfg, "Customers", id);
+    int years = cfg->last_year - cfg->first_year + 1;
+    for (int i = 0; i < cfg->sales; i++) {
+        int j = i + gen_below(cfg->cars - i);
+        int vin = vins[j];
+        vins[j] = vins[i];
+        vins[i] = vin;
+        int code = gen_below(4);
+        fprintf(f, "%d %s%d %d %s %d %d %02d%02d%04d %s %d\n", 1 + zipf_pick(sellers),
+                gen_first_names[gen_below(GEN_COUNT(gen_first_names))], i, 900000000 + gen_below(99999999),
+                gen_cities[gen_below(GEN_COUNT(gen_cities))], vin, 1000 + i, 1 + gen_below(28), 1 + gen_below(12),
+                cfg->first_year + gen_below(years), code ? "Loan" : "Cash", code);
+    }
+    gen_close(f);
+}
+
+int main(int argc, char** argv) {
+    GenConfig cfg = { ".", 3, 1000, 20, -1, 1.0, 2020, 2024, 1 };
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc || argv[i][0] != '-' || strlen(argv[i]) != 2) {
+            fprintf(stderr, "usage: %s [-d dir] [-s showrooms] [-c cars] [-p salespersons] [-u sales] "
+                            "[-z skew] [-y first_year] [-Y last_year] [-r seed]\n", argv[0]);
+            return 1;
+        }
+        const char* v = argv[++i];
+        switch (argv[i - 1][1]) {
+            case 'd': cfg.dir = v; break;
+            case 's': cfg.showrooms = atoi(v); break;
+            case 'c': cfg.cars = atoi(v); break;
+            case 'p': cfg.salespersons = atoi(v); break;
+            case 'u': cfg.sales = atoi(v); break;
+            case 'z': cfg.skew = atof(v); break;
+            case 'y': cfg.first_year = atoi(v); break;
+            case 'Y': cfg.last_year = atoi(v); break;
+            case 'r': cfg.seed = strtoull(v, NULL, 10); break;
+            default:
+                fprintf(stderr, "unknown option %s\n", argv[i - 1]);
+                return 1;
+        }
+    }
+    if (cfg.sales < 0) cfg.sales = cfg.cars / 4;
+    if (cfg.showrooms < 1 || cfg.cars < 1 || cfg.salespersons < 1 || cfg.sales > cfg.cars ||
+        cfg.first_year > cfg.last_year || cfg.first_year < 1000 || cfg.last_year > 9999) {
+        fprintf(stderr, "invalid sizes or years\n");
+        return 1;
+    }
+    if ((long long)cfg.showrooms * cfg.cars > 2000000000LL) {
+        fprintf(stderr, "too many cars for int VINs\n");
+        return 1;
+    }
+    if (mkdir(cfg.dir, 0755) != 0 && errno != EEXIST) {
+        perror(cfg.dir);
+        return 1;
+    }
+
+    gen_state = cfg.seed;
+    Zipf models, sellers;
+    zipf_init(&models, GEN_COUNT(gen_models), cfg.skew);
+    zipf_init(&sellers, cfg.salespersons, cfg.skew);
+    int* vins = (int*)malloc(cfg.cars * sizeof(int));
+    if (!vins) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (int id = 1; id <= cfg.showrooms; id++)
+        gen_showroom(&cfg, id, &models, &sellers, vins);
+    printf("Wrote %d showroom(s) to %s: %d cars, %d salespersons, %d sales each (skew %.2f, %d-%d)\n",
+           cfg.showrooms, cfg.dir, cfg.cars, cfg.salespersons, cfg.sales, cfg.skew, cfg.first_year, cfg.last_year);
+    free(vins);
+    free(models.cdf);
+    free(sellers.cdf);
+    return 0;
+}
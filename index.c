@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "index.h"
+
+// A secondary index is a B+ tree keyed on the secondary value. Keys in
+// the tree stay unique: a value held by one car points straight at the
+// Car, a value shared by several cars points at a small VIN-keyed tree of
+// them (tagged in the low pointer bit; records are at least 16-aligned).
+#define POSTING_TAG 1
+#define IS_POSTING(p) (((size_t)(p)) & POSTING_TAG)
+#define POSTING_ROOT(p) ((BPTreeNode*)((size_t)(p) & ~(size_t)POSTING_TAG))
+#define AS_POSTING(root) ((void*)((size_t)(root) | POSTING_TAG))
+
+// d_o_prchse is stored as ddmmyyyy; this orders dates chronologically.
+int date_key(int ddmmyyyy) {
+    int day = ddmmyyyy / 1000000;
+    int month = (ddmmyyyy / 10000) % 100;
+    int year = ddmmyyyy % 10000;
+    return year * 10000 + month * 100 + day;
+}
+
+int price_key(float price) {
+    return (int)(price + 0.5f);
+}
+
+void index_add(BPTreeNode** index, BPTreeMeta* meta, int key, Car* car) {
+    if (!*index) *index = create_bptree_meta(meta);
+
+    void** slot = bptree_search_ref(*index, key);
+    if (!slot) {
+        bptree_insert(index, key, car);
+        return;
+    }
+
+    if (IS_POSTING(*slot)) {
+        BPTreeNode* posting = POSTING_ROOT(*slot);
+        bptree_insert(&posting, car->vin, car);
+        return;
+    }
+    // A second car under the key: the slot becomes a posting tree of both
+    Car* first = (Car*)*slot;
+    BPTreeNode* posting = create_bptree_meta(meta);
+    bptree_insert(&posting, first->vin, first);
+    bptree_insert(&posting, car->vin, car);
+    *slot = AS_POSTING(posting);
+}
+
+void index_remove(BPTreeNode** index, int key, Car* car) {
+    if (!*index) return;
+    void** slot = bptree_search_ref(*index, key);
+    if (!slot) return;
+
+    if (!IS_POSTING(*slot)) {
+        if (*slot == car) bptree_delete(index, key);
+        return;
+    }
+
+    BPTreeNode* posting = POSTING_ROOT(*slot);
+    bptree_delete(&posting, car->vin);
+    if (posting->num_keys == 0 && posting->is_leaf) {
+        bptree_destroy(posting);
+        bptree_delete(index, key);
+    } else {
+        *slot = AS_POSTING(posting);
+    }
+}
+
+// Visits every car with lo <= key <= hi in key order; returns how many.
+long index_range(BPTreeNode* index, int lo, int hi, IndexVisitor visit, void* ctx) {
+    long count = 0;
+    BPTreeCursor cur, posting;
+    void* p;
+
+    bptree_cursor_range(&cur, index, lo, hi);
+    while (bptree_cursor_next(&cur, NULL, &p)) {
+        if (!IS_POSTING(p)) {
+            visit((Car*)p, ctx);
+            count++;
+            continue;
+        }
+        void* car;
+        bptree_cursor_first(&posting, POSTING_ROOT(p));
+        while (bptree_cursor_next(&posting, NULL, &car)) {
+            visit((Car*)car, ctx);
+            count++;
+        }
+    }
+    return count;
+}
+
+// Frees the index and its posting trees; the cars belong to the showroom.
+void index_destroy(BPTreeNode* index) {
+    BPTreeCursor cur;
+    void* p;
+    bptree_cursor_first(&cur, index);
+    while (bptree_cursor_next(&cur, NULL, &p)) {
+        if (IS_POSTING(p)) bptree_destroy(POSTING_ROOT(p));
+    }
+    bptree_destroy(index);
+}
+
+// Builds the requested indexes from the current trees; from then on
+// sell_car keeps them up to date.
+void showroom_enable_indexes(Showroom* s, int flags) {
+    BPTreeCursor cur;
+    void* data;
+    int added = flags & ~s->indexes;
+
+    if (added & IDX_PRICE) {
+        bptree_cursor_first(&cur, s->available_stock);
+        while (bptree_cursor_next(&cur, NULL, &data)) {
+            Car* car = (Car*)data;
+            index_add(&s->price_index, s->meta, price_key(car->price), car);
+        }
+    }
+    if (added & (IDX_MODEL | IDX_DATE | IDX_PAYMENT)) {
+        bptree_cursor_first(&cur, s->sold_stock);
+        while (bptree_cursor_next(&cur, NULL, &data)) {
+            Car* car = (Car*)data;
+            if (added & IDX_MODEL) index_add(&s->model_index, s->meta, car->model, car);
+            if (added & IDX_DATE) index_add(&s->date_index, s->meta, date_key(car->sale->d_o_prchse), car);
+            if (added & IDX_PAYMENT) index_add(&s->payment_index, s->meta, car->sale->payment_code, car);
+        }
+    }
+    s->indexes |= flags;
+}
+
+// Moves a car that has just been sold from the stock indexes to the sales indexes.
+void showroom_index_sale(Showroom* s, Car* car) {
+    if (s->indexes & IDX_PRICE) index_remove(&s->price_index, price_key(car->price), car);
+    if (s->indexes & IDX_MODEL) index_add(&s->model_index, s->meta, car->model, car);
+    if (s->indexes & IDX_DATE) index_add(&s->date_index, s->meta, date_key(car->sale->d_o_prchse), car);
+    if (s->indexes & IDX_PAYMENT) index_add(&s->payment_index, s->meta, car->sale->payment_code, car);
+}
+
+void print_indexed_car(Car* car, void* ctx) {
+    report_car(&report, car, ((Showroom*)ctx)->showroom_id);
+}
+
+void list_cars_in_price_range(Showroom* showrooms, int count, float min_price, float max_price) {
+    long total = 0;
+    for (int i = 0; i < count; i++) {
+        if (!(showrooms[i].indexes & IDX_PRICE)) showroom_enable_indexes(&showrooms[i], IDX_PRICE);
+        report_text(&report, "Showroom %d:\n", showrooms[i].showroom_id);
+        total += index_range(showrooms[i].price_index, price_key(min_price), price_key(max_price),
+                             print_indexed_car, &showrooms[i]);
+    }
+    report_text(&report, "%ld car(s) in stock priced between %.2f and %.2f\n", total, min_price, max_price);
+}
+
+// Dates are entered as ddmmyyyy like everywhere else in the menu.
+void list_sales_between_dates(Showroom* showrooms, int count, int from_date, int to_date) {
+    long total = 0;
+    for (int i = 0; i < count; i++) {
+        if (!(showrooms[i].indexes & IDX_DATE)) showroom_enable_indexes(&showrooms[i], IDX_DATE);
+        report_text(&report, "Showroom %d:\n", showrooms[i].showroom_id);
+        total += index_range(showrooms[i].date_index, date_key(from_date), date_key(to_date),
+                             print_indexed_car, &showrooms[i]);
+    }
+    report_text(&report, "%ld car(s) sold in that period\n", total);
+}
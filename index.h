@@ -0,0 +1,29 @@
+#ifndef INDEX_H
+#define INDEX_H
+
+#include "bptree.h"
+
+// Secondary index selection for Showroom.indexes
+#define IDX_PRICE 1     // available cars by price in rupees
+#define IDX_MODEL 2     // sold cars by model id
+#define IDX_DATE  4     // sold cars by purchase date (yyyymmdd)
+#define IDX_PAYMENT 8   // sold cars by payment code
+#define IDX_ALL   (IDX_PRICE | IDX_MODEL | IDX_DATE | IDX_PAYMENT)
+
+typedef void (*IndexVisitor)(Car* car, void* ctx);
+
+int date_key(int ddmmyyyy);
+int price_key(float price);
+
+void index_add(BPTreeNode** index, BPTreeMeta* meta, int key, Car* car);
+void index_remove(BPTreeNode** index, int key, Car* car);
+void index_destroy(BPTreeNode* index);
+long index_range(BPTreeNode* index, int lo, int hi, IndexVisitor visit, void* ctx);
+
+void showroom_enable_indexes(Showroom* s, int flags);
+void showroom_index_sale(Showroom* s, Car* car);
+
+void list_cars_in_price_range(Showroom* showrooms, int count, float min_price, float max_price);
+void list_sales_between_dates(Showroom* showrooms, int count, int from_date, int to_date);
+
+#endif
@@ -0,0 +1,69 @@
+#include <sched.h>
+#include "latch.h"
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define LATCH_CPU_RELAX() _mm_pause()
+#else
+#define LATCH_CPU_RELAX() ((void)0)
+#endif
+
+// Spins briefly, then yields so a preempted holder can run (this matters
+// most when there are more threads than cores).
+void latch_pause(int* spins) {
+    if (++*spins < LATCH_SPINS) {
+        LATCH_CPU_RELAX();
+    } else {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+void spin_lock(SpinLock* l) {
+    int spins = 0;
+    while (__atomic_exchange_n(&l->held, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&l->held, __ATOMIC_RELAXED))
+            latch_pause(&spins);
+    }
+}
+
+void spin_unlock(SpinLock* l) {
+    __atomic_store_n(&l->held, 0, __ATOMIC_RELEASE);
+}
+
+// Waits out a writer and returns the version to validate against later.
+// The result has LATCH_OBSOLETE set if the node is no longer in the tree.
+unsigned long latch_optimistic(VersionLatch* l) {
+    int spins = 0;
+    unsigned long v;
+    while ((v = __atomic_load_n(l, __ATOMIC_ACQUIRE)) & LATCH_LOCKED)
+        latch_pause(&spins);
+    return v;
+}
+
+// True if nothing was written since latch_optimistic returned version.
+int latch_validate(VersionLatch* l, unsigned long version) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(l, __ATOMIC_RELAXED) == version;
+}
+
+void latch_exclusive(VersionLatch* l) {
+    int spins = 0;
+    while (1) {
+        unsigned long v = __atomic_load_n(l, __ATOMIC_RELAXED);
+        if (!(v & LATCH_LOCKED) &&
+            __atomic_compare_exchange_n(l, &v, v | LATCH_LOCKED, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return;
+        latch_pause(&spins);
+    }
+}
+
+// Clears the lock bit and bumps the version in one add.
+void unlatch_exclusive(VersionLatch* l) {
+    __atomic_fetch_add(l, LATCH_STEP - LATCH_LOCKED, __ATOMIC_RELEASE);
+}
+
+// Releases a node that has just been unlinked; optimistic readers that
+// reach it see LATCH_OBSOLETE and restart from the root.
+void unlatch_obsolete(VersionLatch* l) {
+    __atomic_fetch_add(l, LATCH_OBSOLETE - LATCH_LOCKED + LATCH_STEP, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,33 @@
+#ifndef LATCH_H
+#define LATCH_H
+
+#define LATCH_SPINS 64          // busy-wait rounds before yielding the CPU
+
+//  Test-and-set lock for critical sections of a few instructions
+typedef struct SpinLock {
+    int held;
+} SpinLock;
+
+#define SPIN_LOCK_INIT { 0 }
+
+//  Version latch for optimistic lock coupling. Writers lock it exclusively;
+//  readers take nothing and instead check that the version did not move
+//  while they looked. Bit 0 = locked, bit 1 = obsolete (node unlinked).
+typedef unsigned long VersionLatch;
+
+#define LATCH_LOCKED 1ul
+#define LATCH_OBSOLETE 2ul
+#define LATCH_STEP 4ul          // version increment per write
+
+void latch_pause(int* spins);
+
+void spin_lock(SpinLock* l);
+void spin_unlock(SpinLock* l);
+
+unsigned long latch_optimistic(VersionLatch* l);
+int latch_validate(VersionLatch* l, unsigned long version);
+void latch_exclusive(VersionLatch* l);
+void unlatch_exclusive(VersionLatch* l);
+void unlatch_obsolete(VersionLatch* l);
+
+#endif
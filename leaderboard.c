@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "leaderboard.h"
+
+Leaderboard leaderboard = LEADERBOARD_INIT;
+
+long leader_size(const LeaderNode* t) {
+    return t ? t->size : 0;
+}
+
+void leader_pull(LeaderNode* t) {
+    t->size = 1 + leader_size(t->left) + leader_size(t->right);
+}
+
+// 1 if a ranks before b. The Salesperson address only separates duplicate
+// ids, so every node has a distinct position.
+int leader_before(const LeaderNode* a, const LeaderNode* b) {
+    if (a->achieved != b->achieved) return a->achieved > b->achieved;
+    if (a->showroom_id != b->showroom_id) return a->showroom_id < b->showroom_id;
+    if (a->id != b->id) return a->id < b->id;
+    return (uintptr_t)a->sp < (uintptr_t)b->sp;
+}
+
+// Splits t into the nodes ranking before k and the rest.
+void leader_split(LeaderNode* t, const LeaderNode* k, LeaderNode** before, LeaderNode** after) {
+    if (!t) {
+        *before = *after = NULL;
+        return;
+    }
+    if (leader_before(t, k)) {
+        leader_split(t->right, k, &t->right, after);
+        *before = t;
+    } else {
+        leader_split(t->left, k, before, &t->left);
+        *after = t;
+    }
+    leader_pull(t);
+}
+
+// Joins two treaps where every node of a ranks before every node of b.
+LeaderNode* leader_merge(LeaderNode* a, LeaderNode* b) {
+    if (!a) return b;
+    if (!b) return a;
+    if (a->priority > b->priority) {
+        a->right = leader_merge(a->right, b);
+        leader_pull(a);
+        return a;
+    }
+    b->left = leader_merge(a, b->left);
+    leader_pull(b);
+    return b;
+}
+
+// Caller holds lb->lock.
+void leader_insert(Leaderboard* lb, LeaderNode* node) {
+    lb->seed ^= lb->seed << 13;
+    lb->seed ^= lb->seed >> 17;
+    lb->seed ^= lb->seed << 5;
+    node->priority = lb->seed;
+    node->left = node->right = NULL;
+    node->size = 1;
+    LeaderNode *before, *after;
+    leader_split(lb->root, node, &before, &after);
+    lb->root = leader_merge(leader_merge(before, node), after);
+}
+
+// Unlinks node, found by its own key, from t.
+LeaderNode* leader_erase(LeaderNode* t, const LeaderNode* node) {
+    if (!t) return NULL;
+    if (t == node) return leader_merge(t->left, t->right);
+    if (leader_before(node, t)) t->left = leader_erase(t->left, node);
+    else t->right = leader_erase(t->right, node);
+    leader_pull(t);
+    return t;
+}
+
+// Starts ranking a salesperson; call once, when it joins a showroom.
+void leaderboard_add(Leaderboard* lb, int showroom_id, Salesperson* sp) {
+    LeaderNode* node = (LeaderNode*)malloc(sizeof(LeaderNode));
+    if (!node) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    node->showroom_id = showroom_id;
+    node->id = sp->id;
+    node->sp = sp;
+    pthread_mutex_lock(&lb->lock);
+    __atomic_load(&sp->achieved, &node->achieved, __ATOMIC_RELAXED);
+    leader_insert(lb, node);
+    sp->rank_node = node;
+    pthread_mutex_unlock(&lb->lock);
+}
+
+// Moves a salesperson to the position of its current achieved value,
+// O(log n). Concurrent sales may credit achieved in a different order than
+// they get here, so the value is re-read under the lock: whichever call
+// comes last leaves the node at the final total.
+void leaderboard_update(Leaderboard* lb, Salesperson* sp) {
+    pthread_mutex_lock(&lb->lock);
+    LeaderNode* node = sp->rank_node;
+    float achieved;
+    __atomic_load(&sp->achieved, &achieved, __ATOMIC_SEQ_CST);
+    if (node && node->achieved != achieved) {
+        lb->root = leader_erase(lb->root, node);
+        node->achieved = achieved;
+        leader_insert(lb, node);
+    }
+    pthread_mutex_unlock(&lb->lock);
+}
+
+void leaderboard_remove(Leaderboard* lb, Salesperson* sp) {
+    pthread_mutex_lock(&lb->lock);
+    LeaderNode* node = sp->rank_node;
+    if (node) {
+        lb->root = leader_erase(lb->root, node);
+        sp->rank_node = NULL;
+        free(node);
+    }
+    pthread_mutex_unlock(&lb->lock);
+}
+
+long leaderboard_size(Leaderboard* lb) {
+    pthread_mutex_lock(&lb->lock);
+    long n = leader_size(lb->root);
+    pthread_mutex_unlock(&lb->lock);
+    return n;
+}
+
+void leader_entry(LeaderEntry* e, const LeaderNode* t, long rank) {
+    e->rank = rank;
+    e->showroom_id = t->showroom_id;
+    e->achieved = t->achieved;
+    e->sp = t->sp;
+}
+
+// In-order walk that stops after k nodes; O(k + log n).
+void leader_collect_top(const LeaderNode* t, int k, LeaderEntry* out, int* n) {
+    if (!t || *n >= k) return;
+    leader_collect_top(t->left, k, out, n);
+    if (*n >= k) return;
+    leader_entry(&out[*n], t, *n + 1);
+    (*n)++;
+    leader_collect_top(t->right, k, out, n);
+}
+
+// Fills out with the k best salespersons; returns how many there were.
+int leaderboard_top(Leaderboard* lb, int k, LeaderEntry* out) {
+    int n = 0;
+    pthread_mutex_lock(&lb->lock);
+    leader_collect_top(lb->root, k, out, &n);
+    pthread_mutex_unlock(&lb->lock);
+    return n;
+}
+
+// 1-based position of a salesperson, 0 if it is not ranked.
+long leaderboard_rank(Leaderboard* lb, Salesperson* sp) {
+    long rank = 0;
+    pthread_mutex_lock(&lb->lock);
+    const LeaderNode* node = sp->rank_node;
+    const LeaderNode* t = lb->root;
+    while (node && t) {
+        if (t == node) {
+            rank += leader_size(t->left) + 1;
+            break;
+        }
+        if (leader_before(node, t)) {
+            t = t->left;
+        } else {
+            rank += leader_size(t->left) + 1;
+            t = t->right;
+        }
+    }
+    pthread_mutex_unlock(&lb->lock);
+    return node && t ? rank : 0;
+}
+
+//  Growing result of a range query
+typedef struct LeaderRange {
+    float lo, hi;
+    LeaderEntry* items;
+    long n, cap;
+} LeaderRange;
+
+// Visits only the subtrees that can hold achieved values in [lo, hi];
+// `before` is the number of nodes ranking before subtree t.
+void leader_collect_range(const LeaderNode* t, long before, LeaderRange* r) {
+    if (!t) return;
+    if (t->achieved > r->hi) {
+        leader_collect_range(t->right, before + leader_size(t->left) + 1, r);
+        return;
+    }
+    if (t->achieved < r->lo) {
+        leader_collect_range(t->left, before, r);
+        return;
+    }
+    leader_collect_range(t->left, before, r);
+    if (r->n == r->cap) {
+        r->cap = r->cap ? r->cap * 2 : 16;
+        r->items = (LeaderEntry*)realloc(r->items, r->cap * sizeof(LeaderEntry));
+        if (!r->items) {
+            printf("Memory allocation failed!\n");
+            exit(1);
+        }
+    }
+    leader_entry(&r->items[r->n++], t, before + leader_size(t->left) + 1);
+    leader_collect_range(t->right, before + leader_size(t->left) + 1, r);
+}
+
+// Salespersons whose achieved lies in [min, max], best first, in a new
+// array for the caller to free. Costs O(log n + matches).
+long leaderboard_range(Leaderboard* lb, float min_achieved, float max_achieved, LeaderEntry** out) {
+    LeaderRange r = { min_achieved, max_achieved, NULL, 0, 0 };
+    pthread_mutex_lock(&lb->lock);
+    leader_collect_range(lb->root, 0, &r);
+    pthread_mutex_unlock(&lb->lock);
+    *out = r.items;
+    return r.n;
+}
+
+void print_leaderboard(int k) {
+    if (k <= 0) {
+        report_message(&report, "Invalid option.\n");
+        return;
+    }
+    LeaderEntry* top = (LeaderEntry*)malloc(k * sizeof(LeaderEntry));
+    if (!top) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    int n = leaderboard_top(&leaderboard, k, top);
+    for (int i = 0; i < n; i++) {
+        report_begin(&report, 0);
+        report_text(&report, "%ld. ", top[i].rank);
+        report_int(&report, NULL, "rank", top[i].rank);
+        report_int(&report, "Showroom", "showroom", top[i].showroom_id);
+        report_int(&report, "Salesperson ID", "id", top[i].sp->id);
+        report_str(&report, "Name", "name", top[i].sp->name);
+        report_money(&report, "Achieved", "achieved", top[i].achieved);
+        report_end(&report);
+    }
+    if (n == 0) report_message(&report, "No sales person found.\n");
+    free(top);
+}
@@ -0,0 +1,51 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <pthread.h>
+#include "bptree.h"
+
+//  Treap node: ordered by key, heap-ordered by priority, and counting its
+//  subtree so ranks and k-th lookups are O(log n)
+typedef struct LeaderNode {
+    float achieved;             // the key, copied: sp->achieved moves under concurrent sales
+    int showroom_id;
+    int id;
+    Salesperson* sp;
+    unsigned priority;
+    long size;                  // nodes in this subtree
+    struct LeaderNode* left;    // ranks before this node
+    struct LeaderNode* right;
+} LeaderNode;
+
+//  Every ranked salesperson of every showroom, best first: highest
+//  achieved, then lowest showroom id, then lowest salesperson id.
+typedef struct Leaderboard {
+    LeaderNode* root;
+    unsigned seed;              // treap priorities
+    pthread_mutex_t lock;
+} Leaderboard;
+
+#define LEADERBOARD_INIT { NULL, 2463534242u, PTHREAD_MUTEX_INITIALIZER }
+
+//  Snapshot of one position, taken under the lock
+typedef struct LeaderEntry {
+    long rank;                  // 1 = best
+    int showroom_id;
+    float achieved;
+    Salesperson* sp;
+} LeaderEntry;
+
+void leaderboard_add(Leaderboard* lb, int showroom_id, Salesperson* sp);
+void leaderboard_update(Leaderboard* lb, Salesperson* sp);
+void leaderboard_remove(Leaderboard* lb, Salesperson* sp);
+
+long leaderboard_size(Leaderboard* lb);
+int leaderboard_top(Leaderboard* lb, int k, LeaderEntry* out);
+long leaderboard_rank(Leaderboard* lb, Salesperson* sp);
+long leaderboard_range(Leaderboard* lb, float min_achieved, float max_achieved, LeaderEntry** out);
+
+void print_leaderboard(int k);
+
+extern Leaderboard leaderboard;
+
+#endif
@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "loader.h"
+
+// Counts showroom1.txt, showroom2.txt, ... up to the first one missing.
+int discover_showrooms() {
+    int count = 0;
+    char name[LOADER_NAME_LEN];
+    while (1) {
+        snprintf(name, sizeof(name), "showroom%d.txt", count + 1);
+        if (access(name, R_OK) != 0) break;
+        count++;
+    }
+    return count;
+}
+
+// Cuts the inventory file into at most max_chunks slices that each end on
+// a line boundary.
+void split_inventory(ShowroomLoad* load, int max_chunks) {
+    size_t size = load->tf.size;
+    int pieces = (int)(size / LOADER_MIN_CHUNK);
+    if (pieces > max_chunks) pieces = max_chunks;
+    if (pieces < 1) pieces = 1;
+
+    load->chunks = (LoadChunk*)calloc(pieces, sizeof(LoadChunk));
+    if (!load->chunks) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+
+    const char* data = load->tf.data;
+    size_t start = 0;
+    load->num_chunks = 0;
+    for (int k = 1; k <= pieces && start < size; k++) {
+        size_t stop = size;
+        if (k < pieces) {
+            stop = size / pieces * k;
+            if (stop < start) stop = start;
+            const char* nl = (const char*)memchr(data + stop, '\n', size - stop);
+            stop = nl ? (size_t)(nl - data) + 1 : size;
+        }
+        LoadChunk* c = &load->chunks[load->num_chunks++];
+        c->name = load->inventory;
+        c->data = data + start;
+        c->size = stop - start;
+        c->arena = load->showroom->arena ? arena_create() : NULL;
+        start = stop;
+    }
+}
+
+// Phase 1: newline count, so phase 2 can report absolute line numbers.
+void count_chunk_lines(void* arg) {
+    LoadChunk* c = (LoadChunk*)arg;
+    const char* p = c->data;
+    const char* end = c->data + c->size;
+    int lines = 0;
+    while ((p = (const char*)memchr(p, '\n', end - p)) != NULL) {
+        lines++;
+        p++;
+    }
+    c->lines = lines;
+}
+
+// Phase 2: parse one slice into its private arena.
+void parse_chunk(void* arg) {
+    LoadChunk* c = (LoadChunk*)arg;
+    LineScanner sc;
+    scanner_init(&sc, c->name, c->data, c->size);
+    sc.line_no = c->first_line;
+    c->count = parse_car_lines(&sc, c->arena, &c->vins, &c->cars);
+}
+
+// Phase 3: stitch the slices together and finish the showroom. Slices are
+// in file order, so a sorted file still bulk loads without a sort.
+void build_showroom(void* arg) {
+    ShowroomLoad* load = (ShowroomLoad*)arg;
+    Showroom* s = load->showroom;
+    int n = 0;
+
+    if (load->num_chunks == 1) {
+        LoadChunk* c = &load->chunks[0];
+        arena_adopt(s->arena, c->arena);
+        n = c->count;
+        bptree_bulk_load(&s->available_stock, c->vins, c->cars, n, bptree_bulk_fill);
+        free(c->vins);
+        free(c->cars);
+    } else if (load->num_chunks > 1) {
+        for (int i = 0; i < load->num_chunks; i++) n += load->chunks[i].count;
+        int* vins = (int*)malloc((n ? n : 1) * sizeof(int));
+        void** cars = (void**)malloc((n ? n : 1) * sizeof(void*));
+        if (!vins || !cars) {
+            printf("Memory allocation failed!\n");
+            exit(1);
+        }
+        n = 0;
+        for (int i = 0; i < load->num_chunks; i++) {
+            LoadChunk* c = &load->chunks[i];
+            memcpy(vins + n, c->vins, c->count * sizeof(int));
+            memcpy(cars + n, c->cars, c->count * sizeof(void*));
+            n += c->count;
+            arena_adopt(s->arena, c->arena);
+            free(c->vins);
+            free(c->cars);
+        }
+        bptree_bulk_load(&s->available_stock, vins, cars, n, bptree_bulk_fill);
+        free(vins);
+        free(cars);
+    }
+    free(load->chunks);
+    if (load->opened) text_file_close(&load->tf);
+    if (report_log_level == LOG_SUMMARY && load->opened) log_inventory_summary(s, n, load->inventory);
+
+    load_salespersons(s, load->salespersons);
+    process_customer_purchases(s, load->customers);
+    if (s->lazy_delete) showroom_compact(s);
+    showroom_enable_indexes(s, IDX_ALL);
+    vindir_add_showroom(&vin_directory, s);
+}
+
+// Loads every showroom on a pool of threads (<= 0 means one per CPU).
+// Showrooms are independent, so each is finished by its own task; large
+// inventory files are additionally parsed in slices. The phases are
+// separated by threadpool_wait rather than nesting waits inside tasks.
+void load_all_showrooms(Showroom* showrooms, int count, int threads) {
+    if (count <= 0) return;
+    ThreadPool* pool = threadpool_create(threads);
+    ShowroomLoad* loads = (ShowroomLoad*)calloc(count, sizeof(ShowroomLoad));
+    if (!loads) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+
+    // Resolve the rank implementation once, before the workers race to do it
+    bptree_rank_name();
+
+    for (int i = 0; i < count; i++) {
+        ShowroomLoad* load = &loads[i];
+        int id = showrooms[i].showroom_id;
+        load->showroom = &showrooms[i];
+        snprintf(load->inventory, LOADER_NAME_LEN, "showroom%d.txt", id);
+        snprintf(load->salespersons, LOADER_NAME_LEN, "Salesperson%d.txt", id);
+        snprintf(load->customers, LOADER_NAME_LEN, "Customers%d.txt", id);
+        load->opened = text_file_open(&load->tf, load->inventory);
+        if (load->opened) split_inventory(load, pool->num_threads);
+    }
+
+    for (int i = 0; i < count; i++)
+        for (int j = 0; j < loads[i].num_chunks; j++)
+            threadpool_submit(pool, count_chunk_lines, &loads[i].chunks[j]);
+    threadpool_wait(pool);
+
+    for (int i = 0; i < count; i++) {
+        int line = 0;
+        for (int j = 0; j < loads[i].num_chunks; j++) {
+            loads[i].chunks[j].first_line = line;
+            line += loads[i].chunks[j].lines;
+            threadpool_submit(pool, parse_chunk, &loads[i].chunks[j]);
+        }
+    }
+    threadpool_wait(pool);
+
+    for (int i = 0; i < count; i++)
+        threadpool_submit(pool, build_showroom, &loads[i]);
+    threadpool_wait(pool);
+
+    threadpool_destroy(pool);
+    free(loads);
+}
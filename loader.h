@@ -0,0 +1,39 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "bptree.h"
+#include "threadpool.h"
+#include "vindir.h"
+
+#define LOADER_MIN_CHUNK (4 << 20)    // inventory files are not split below 4 MB a piece
+#define LOADER_NAME_LEN 64
+
+//  Newline-aligned slice of one inventory file, parsed by a single task
+typedef struct LoadChunk {
+    const char* name;
+    const char* data;
+    size_t size;
+    int lines;              // newlines in the slice
+    int first_line;         // line number just before the slice starts
+    Arena* arena;           // private until adopted by the showroom arena
+    int* vins;
+    void** cars;
+    int count;
+} LoadChunk;
+
+//  Everything the loader tracks for one showroom
+typedef struct ShowroomLoad {
+    Showroom* showroom;
+    char inventory[LOADER_NAME_LEN];
+    char salespersons[LOADER_NAME_LEN];
+    char customers[LOADER_NAME_LEN];
+    TextFile tf;
+    int opened;
+    LoadChunk* chunks;
+    int num_chunks;
+} ShowroomLoad;
+
+int discover_showrooms();
+void load_all_showrooms(Showroom* showrooms, int count, int threads);
+
+#endif
@@ -0,0 +1,273 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "loan.h"
+#include "index.h"
+#include "timeseries.h"
+#if BPTREE_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+// The plans offered by add_new_customer, by payment code 1..3.
+const LoanPlan loan_plans[LOAN_NUM_PLANS] = {
+    { 1, 84, 9.00 },
+    { 2, 60, 8.75 },
+    { 3, 36, 8.50 },
+};
+
+// Plan of a sale, NULL for cash. The inventory files also mark some cash
+// sales with code 1, so the payment method has the last word.
+const LoanPlan* loan_plan(const Sale* sale) {
+    if (sale->payment_code < 1 || sale->payment_code > LOAN_NUM_PLANS) return NULL;
+    if (strcmp(sale->payment_method, "Cash") == 0) return NULL;
+    return &loan_plans[sale->payment_code - 1];
+}
+
+void loan_book_init(LoanBook* b) {
+    memset(b, 0, sizeof(LoanBook));
+}
+
+void loan_book_free(LoanBook* b) {
+    free(b->cars);
+    free(b->showroom_id);
+    free(b->plan);
+    free(b->start);
+    free(b->principal);
+    free(b->rate);
+    free(b->months);
+    free(b->paid);
+    free(b->emi);
+    free(b->outstanding);
+    free(b->interest);
+    loan_book_init(b);
+}
+
+void* loan_grow(void* p, long cap, size_t size) {
+    p = realloc(p, cap * size);
+    if (!p) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    return p;
+}
+
+void loan_book_add(LoanBook* b, int showroom_id, Car* car) {
+    const LoanPlan* plan = loan_plan(car->sale);
+    if (!plan) return;
+    if (b->n == b->cap) {
+        b->cap = b->cap ? b->cap * 2 : 256;
+        b->cars = (Car**)loan_grow(b->cars, b->cap, sizeof(Car*));
+        b->showroom_id = (int*)loan_grow(b->showroom_id, b->cap, sizeof(int));
+        b->plan = (int*)loan_grow(b->plan, b->cap, sizeof(int));
+        b->start = (int*)loan_grow(b->start, b->cap, sizeof(int));
+        b->principal = (double*)loan_grow(b->principal, b->cap, sizeof(double));
+        b->rate = (double*)loan_grow(b->rate, b->cap, sizeof(double));
+        b->months = (int*)loan_grow(b->months, b->cap, sizeof(int));
+        b->paid = (int*)loan_grow(b->paid, b->cap, sizeof(int));
+        b->emi = (double*)loan_grow(b->emi, b->cap, sizeof(double));
+        b->outstanding = (double*)loan_grow(b->outstanding, b->cap, sizeof(double));
+        b->interest = (double*)loan_grow(b->interest, b->cap, sizeof(double));
+    }
+    long i = b->n++;
+    int month = ts_month_number(car->sale->d_o_prchse);
+    b->cars[i] = car;
+    b->showroom_id[i] = showroom_id;
+    b->plan[i] = plan - loan_plans;
+    b->start[i] = month < 0 ? 0 : month;
+    b->principal[i] = car->price;
+    b->rate[i] = plan->annual_rate / 1200.0;
+    b->months[i] = plan->months;
+}
+
+//  index_range visitor context
+typedef struct LoanCollect {
+    LoanBook* book;
+    int showroom_id;
+} LoanCollect;
+
+void loan_collect_car(Car* car, void* ctx) {
+    LoanCollect* c = (LoanCollect*)ctx;
+    loan_book_add(c->book, c->showroom_id, car);
+}
+
+// Every loan of every showroom, read from the payment-code index.
+void loan_book_collect(LoanBook* b, Showroom* showrooms, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!(showrooms[i].indexes & IDX_PAYMENT)) showroom_enable_indexes(&showrooms[i], IDX_PAYMENT);
+        LoanCollect c = { b, showrooms[i].showroom_id };
+        index_range(showrooms[i].payment_index, 1, LOAN_NUM_PLANS, loan_collect_car, &c);
+    }
+}
+
+// q^e for 0 <= e < 128 by squaring. Terms are at most 84 months, so seven
+// steps always suffice; the vector version takes the same steps per lane
+// and gets bit-identical results.
+double loan_pow(double q, int e) {
+    double r = 1.0;
+    for (int bit = 0; bit < 7; bit++) {
+        if ((e >> bit) & 1) r *= q;
+        q *= q;
+    }
+    return r;
+}
+
+// Standard amortization with q = 1 + r, g = q^term and h = q^paid:
+// emi = p r g / (g - 1), outstanding = p (g - h) / (g - 1).
+void loan_amortize_range(LoanBook* b, long from, long to, int as_of_month) {
+    for (long i = from; i < to; i++) {
+        int k = as_of_month - b->start[i];
+        k = k < 0 ? 0 : k > b->months[i] ? b->months[i] : k;
+        double r = b->rate[i], p = b->principal[i];
+        double g = loan_pow(1.0 + r, b->months[i]), h = loan_pow(1.0 + r, k);
+        double emi = p * r * g / (g - 1.0);
+        double left = p * (g - h) / (g - 1.0);
+        b->paid[i] = k;
+        b->emi[i] = emi;
+        b->outstanding[i] = left;
+        b->interest[i] = emi * k - (p - left);
+    }
+}
+
+void loan_amortize_scalar(LoanBook* b, int as_of_month) {
+    loan_amortize_range(b, 0, b->n, as_of_month);
+}
+
+#if BPTREE_HAVE_X86_SIMD
+__attribute__((target("avx2")))
+__m256d loan_pow_avx2(__m256d q, __m128i e) {
+    __m256d r = _mm256_set1_pd(1.0);
+    __m128i bit = _mm_set1_epi32(1);
+    for (int i = 0; i < 7; i++) {
+        __m128i set = _mm_cmpeq_epi32(_mm_and_si128(e, bit), bit);
+        __m256d mask = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(set));
+        r = _mm256_blendv_pd(r, _mm256_mul_pd(r, q), mask);
+        q = _mm256_mul_pd(q, q);
+        bit = _mm_slli_epi32(bit, 1);
+    }
+    return r;
+}
+
+// Four loans per iteration; the tail goes through the scalar loop.
+__attribute__((target("avx2")))
+void loan_amortize_avx2(LoanBook* b, int as_of_month) {
+    __m128i now = _mm_set1_epi32(as_of_month), zero = _mm_setzero_si128();
+    __m256d one = _mm256_set1_pd(1.0);
+    long i = 0;
+    for (; i + 4 <= b->n; i += 4) {
+        __m128i term = _mm_loadu_si128((const __m128i*)(b->months + i));
+        __m128i k = _mm_sub_epi32(now, _mm_loadu_si128((const __m128i*)(b->start + i)));
+        k = _mm_min_epi32(_mm_max_epi32(k, zero), term);
+        __m256d r = _mm256_loadu_pd(b->rate + i), p = _mm256_loadu_pd(b->principal + i);
+        __m256d q = _mm256_add_pd(one, r);
+        __m256d g = loan_pow_avx2(q, term), h = loan_pow_avx2(q, k);
+        __m256d g1 = _mm256_sub_pd(g, one);
+        __m256d emi = _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(p, r), g), g1);
+        __m256d left = _mm256_div_pd(_mm256_mul_pd(p, _mm256_sub_pd(g, h)), g1);
+        __m256d interest = _mm256_sub_pd(_mm256_mul_pd(emi, _mm256_cvtepi32_pd(k)), _mm256_sub_pd(p, left));
+        _mm_storeu_si128((__m128i*)(b->paid + i), k);
+        _mm256_storeu_pd(b->emi + i, emi);
+        _mm256_storeu_pd(b->outstanding + i, left);
+        _mm256_storeu_pd(b->interest + i, interest);
+    }
+    loan_amortize_range(b, i, b->n, as_of_month);
+}
+#endif
+
+// Picks the widest implementation the CPU supports on first use.
+void loan_amortize_resolve(LoanBook* b, int as_of_month) {
+    loan_amortize = loan_amortize_scalar;
+#if BPTREE_HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        loan_amortize = loan_amortize_avx2;
+#endif
+    if (b) loan_amortize(b, as_of_month);
+}
+
+void (*loan_amortize)(LoanBook* b, int as_of_month) = loan_amortize_resolve;
+
+const char* loan_amortize_name() {
+    if (loan_amortize == loan_amortize_resolve) loan_amortize_resolve(NULL, 0);
+#if BPTREE_HAVE_X86_SIMD
+    if (loan_amortize == loan_amortize_avx2) return "avx2";
+#endif
+    return "scalar";
+}
+
+// Month-end finance run: totals per plan as of the date. Loans bought in
+// the date's month have paid nothing yet; finished loans owe no EMI.
+void print_loan_portfolio(Showroom* showrooms, int count, int as_of_date) {
+    int month = ts_month_number(as_of_date);
+    if (month < 0) {
+        report_message(&report, "Invalid date.\n");
+        return;
+    }
+    LoanBook b;
+    loan_book_init(&b);
+    loan_book_collect(&b, showrooms, count);
+    loan_amortize(&b, month);
+
+    long loans[LOAN_NUM_PLANS + 1] = { 0 };
+    double principal[LOAN_NUM_PLANS + 1] = { 0 }, emi[LOAN_NUM_PLANS + 1] = { 0 };
+    double outstanding[LOAN_NUM_PLANS + 1] = { 0 }, interest[LOAN_NUM_PLANS + 1] = { 0 };
+    for (long i = 0; i < b.n; i++) {
+        int p = b.plan[i];
+        loans[p]++;
+        principal[p] += b.principal[i];
+        if (b.paid[i] < b.months[i]) emi[p] += b.emi[i];
+        outstanding[p] += b.outstanding[i];
+        interest[p] += b.interest[i];
+    }
+    char plan[48];
+    for (int p = 0; p <= LOAN_NUM_PLANS; p++) {
+        report_begin(&report, 0);
+        if (p < LOAN_NUM_PLANS) {
+            snprintf(plan, sizeof(plan), "%d months at %.2f%%", loan_plans[p].months, loan_plans[p].annual_rate);
+            report_str(&report, "Plan", "plan", plan);
+        } else {
+            report_text(&report, "Total | ");
+            report_str(&report, NULL, "plan", "Total");
+        }
+        report_int(&report, "Loans", "loans", loans[p]);
+        report_money(&report, "Principal", "principal", principal[p]);
+        report_money(&report, "Monthly EMI", "monthly_emi", emi[p]);
+        report_money(&report, "Outstanding", "outstanding", outstanding[p]);
+        report_money(&report, "Interest paid", "interest_paid", interest[p]);
+        report_end(&report);
+        if (p == LOAN_NUM_PLANS) break;
+
+        loans[LOAN_NUM_PLANS] += loans[p];
+        principal[LOAN_NUM_PLANS] += principal[p];
+        emi[LOAN_NUM_PLANS] += emi[p];
+        outstanding[LOAN_NUM_PLANS] += outstanding[p];
+        interest[LOAN_NUM_PLANS] += interest[p];
+    }
+    loan_book_free(&b);
+}
+
+void print_emi_customer(Car* car, void* ctx) {
+    if (!loan_plan(car->sale)) return;
+    report_begin(&report, 0);
+    report_str(&report, "Customer Name", "name", car->sale->cust_name);
+    report_break(&report, 0);
+    report_str(&report, "Customer Mobile", "mobile", car->sale->cust_mobile);
+    report_break(&report, 0);
+    report_str(&report, "Customer Address", "address", car->sale->cust_address);
+    report_break(&report, 0);
+    report_str(&report, "Registration Number", "reg_no", car->sale->reg_no);
+    report_break(&report, 0);
+    report_str(&report, "Payment Method", "payment", car->sale->payment_method);
+    report_break(&report, 0);
+    report_int(&report, "Payment Code", "payment_code", car->sale->payment_code);
+    report_break(&report, 0);
+    report_end(&report);
+}
+
+// Customers on the 36-month plan (code 3; the old filter looked for a
+// code 4 that add_new_customer never offers).
+void print_customers_with_36_months_emi_loan(Showroom* showrooms, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!(showrooms[i].indexes & IDX_PAYMENT)) showroom_enable_indexes(&showrooms[i], IDX_PAYMENT);
+        index_range(showrooms[i].payment_index, LOAN_36_MONTHS, LOAN_36_MONTHS, print_emi_customer, NULL);
+    }
+}
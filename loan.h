@@ -0,0 +1,51 @@
+#ifndef LOAN_H
+#define LOAN_H
+
+#include "bptree.h"
+
+#define LOAN_NUM_PLANS 3
+#define LOAN_36_MONTHS 3               // payment code of the 36-month EMI plan
+
+//  EMI plan selected by Sale.payment_code (0 is cash)
+typedef struct LoanPlan {
+    int payment_code;
+    int months;
+    double annual_rate;         // percent
+} LoanPlan;
+
+//  Every loan of the portfolio as parallel arrays, so the amortization
+//  kernel streams each field with vector loads
+typedef struct LoanBook {
+    long n;
+    long cap;
+    Car** cars;
+    int* showroom_id;
+    int* plan;                  // index into loan_plans
+    int* start;                 // month number of the purchase
+    double* principal;          // the car price
+    double* rate;               // monthly interest rate
+    int* months;                // term
+    // Filled by loan_amortize
+    int* paid;                  // installments paid as of the run's month
+    double* emi;
+    double* outstanding;        // principal still owed
+    double* interest;           // interest paid so far
+} LoanBook;
+
+extern const LoanPlan loan_plans[LOAN_NUM_PLANS];
+
+const LoanPlan* loan_plan(const Sale* sale);
+
+void loan_book_init(LoanBook* b);
+void loan_book_free(LoanBook* b);
+void loan_book_add(LoanBook* b, int showroom_id, Car* car);
+void loan_book_collect(LoanBook* b, Showroom* showrooms, int count);
+
+extern void (*loan_amortize)(LoanBook* b, int as_of_month);
+const char* loan_amortize_name();
+void loan_amortize_scalar(LoanBook* b, int as_of_month);
+
+void print_loan_portfolio(Showroom* showrooms, int count, int as_of_date);
+void print_customers_with_36_months_emi_loan(Showroom* showrooms, int count);
+
+#endif
@@ -4,24 +4,172 @@
 #include "bptree.c"
 
 
-int main() {
-    Showroom showrooms[3];
-    char* srfiles[3] = { "showroom1.txt", "showroom2.txt", "showroom3.txt" };
-    char* spfiles[3] = { "Salesperson1.txt", "Salesperson2.txt", "Salesperson3.txt" };
-    char* cfiles[3] = { "Customers1.txt", "Customers2.txt", "Customers3.txt" };
-    
+// Usage: showroom [-j threads] [-s snapshot] [-w logfile | -n] [-m catalog | -M catalog] [-l]
+//                 [-q] [-f table|csv|json] [-o file] [-c commands] [-b script] [-t]
+//                 [-S socket | -p port]
+// Loads showroom1.txt .. showroomN.txt with their Salesperson and Customers
+// files; -j sets the loader threads (default: one per CPU). -s starts from a
+// binary snapshot (menu option 17) instead of the text files. Sales and
+// salespersons added at the terminal go to a write-ahead log (default
+// showroom.wal) that is replayed on the next start; -n runs without one.
+// -m / -M write the merged catalog of all showrooms (text / binary) and exit
+// instead of showing the menu. -l makes sales leave tombstones in the stock
+// tree instead of deleting from it (see bptree_delete_lazy); the loaded
+// purchases are compacted away once each showroom is in. -q logs one line
+// per loaded file instead of one per record, -q -q nothing. -f picks the
+// format of the menu's listings and reports, -o sends them to a file while
+// the prompts stay on the terminal. -c runs commands (separated by ';')
+// and -b runs a script of them, one per line ('-' = stdin), instead of the
+// menu; see query.c or run "-c help". -t times each command on stderr. The
+// exit code is 0 if every command succeeded, 1 if one failed, 2 on a
+// syntax error. -S serves the same commands on a Unix socket and -p on a
+// TCP port of 127.0.0.1 until SIGINT or SIGTERM, with -j workers and -f
+// as the response format; see server.h for the protocol.
+int main(int argc, char** argv) {
+    int threads = 0;
+    const char* wal_path = WAL_DEFAULT_PATH;
+    const char* snap_path = NULL;
+    const char* merge_path = NULL;
+    MergeFormat merge_format = MERGE_TEXT;
+    int lazy_delete = 0;
+    const char* report_path = NULL;
+    const char* commands = NULL;
+    const char* script = NULL;
+    int timing = 0;
+    const char* socket_path = NULL;
+    int port = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            snap_path = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            wal_path = argv[++i];
+        } else if ((strcmp(argv[i], "-m") == 0 || strcmp(argv[i], "-M") == 0) && i + 1 < argc) {
+            merge_format = argv[i][1] == 'M' ? MERGE_BINARY : MERGE_TEXT;
+            merge_path = argv[++i];
+        } else if (strcmp(argv[i], "-n") == 0) {
+            wal_path = NULL;
+        } else if (strcmp(argv[i], "-l") == 0) {
+            lazy_delete = 1;
+        } else if (strcmp(argv[i], "-q") == 0) {
+            if (report_log_level > LOG_QUIET) report_log_level = (LogLevel)(report_log_level - 1);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc && report_parse_format(argv[i + 1], &report.format)) {
+            i++;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            report_path = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            commands = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            script = argv[++i];
+        } else if (strcmp(argv[i], "-t") == 0) {
+            timing = 1;
+        } else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc && (port = atoi(argv[i + 1])) > 0 && port < 65536) {
+            i++;
+        } else {
+            fprintf(stderr, "usage: %s [-j threads] [-s snapshot] [-w logfile | -n] [-m catalog | -M catalog] [-l]\n"
+                            "       [-q] [-f table|csv|json] [-o file] [-c commands] [-b script] [-t]\n"
+                            "       [-S socket | -p port]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (report_path && !(report.f = fopen(report_path, "w"))) {
+        perror(report_path);
+        return 1;
+    }
+    int listen_fd = -1;
+    if (socket_path || port) {
+        listen_fd = socket_path ? server_listen_unix(socket_path) : server_listen_tcp(port);
+        if (listen_fd < 0) return 1;
+    }
+
+    Snapshot* snap = NULL;
+    int count;
+    if (snap_path) {
+        if (!(snap = snapshot_open(snap_path, 1))) return 1;
+        count = snap->header->num_showrooms;
+    } else {
+        count = discover_showrooms();
+    }
+    if (count == 0) {
+        printf("No showroom files found.\n");
+        return 1;
+    }
+    Showroom* showrooms = (Showroom*)malloc(count * sizeof(Showroom));
+    if (!showrooms) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+
+    if (snap) {
+        for (int i = 0; i < count; i++) {
+            showroom_init(&showrooms[i], snap->showrooms[i].showroom_id, 1);
+            showrooms[i].lazy_delete = lazy_delete;
+        }
+        snapshot_restore(snap, showrooms, threads);
+        snapshot_close(snap);
+    } else {
+        for (int i = 0; i < count; i++) {
+            showroom_init(&showrooms[i], i + 1, 1);
+            showrooms[i].lazy_delete = lazy_delete;
+        }
+        load_all_showrooms(showrooms, count, threads);
+    }
 
-    for (int i = 0; i < 3; i++) {
-        showrooms[i].showroom_id = i + 1;
-        showrooms[i].available_stock = NULL;
-        showrooms[i].sold_stock = NULL;
-        showrooms[i].salespersons = NULL;
+    Wal* wal = wal_path ? wal_open(wal_path, showrooms, count) : NULL;
+    if (wal) {
+        int recovered = wal_replay(wal);
+        if (recovered > 0) printf("Recovered %d change(s) from %s\n", recovered, wal_path);
+        for (int i = 0; i < count; i++)
+            showrooms[i].wal = wal;
+    }
 
-        load_showroom_data(&showrooms[i], srfiles[i]);
-        load_salespersons(&showrooms[i], spfiles[i]);
-        process_customer_purchases(&showrooms[i], cfiles[i]);
+    int status = 0;
+    if (merge_path) {
+        MergeStats stats;
+        status = !merge_showrooms(showrooms, count, merge_path, merge_format, &stats);
+        report_flush(&report);      // duplicate warnings first
+        if (!status) printf("Merged %ld cars into %s (%ld duplicate VINs skipped)\n", stats.cars, merge_path, stats.duplicates);
+    }
+    if (commands || script) {
+        QuerySession q;
+        query_session_init(&q, showrooms, count, timing);
+        double t0 = query_now();
+        QueryStatus done = commands ? query_run_string(&q, commands) : QUERY_OK;
+        if (script && done != QUERY_EXIT) {
+            FILE* f = strcmp(script, "-") == 0 ? stdin : fopen(script, "r");
+            if (f) {
+                query_run_file(&q, f, script);
+                if (f != stdin) fclose(f);
+            } else {
+                perror(script);
+                q.worst = QUERY_SYNTAX;
+            }
+        }
+        report_flush(&report);
+        if (timing) fprintf(stderr, "%ld command(s), %ld failed, %.3f ms\n", q.commands, q.failed, (query_now() - t0) * 1e3);
+        if (query_exit_code(&q) > status) status = query_exit_code(&q);
+    }
+    if (listen_fd >= 0) {
+        if (socket_path) printf("Serving %d showroom(s) on %s\n", count, socket_path);
+        else printf("Serving %d showroom(s) on 127.0.0.1:%d\n", count, port);
+        fflush(stdout);
+        int served = server_run(showrooms, count, listen_fd, threads, report.format);
+        if (served > status) status = served;
+        close(listen_fd);
+        if (socket_path) unlink(socket_path);
+    } else if (!merge_path && !commands && !script) {
+        menu(showrooms, count);
     }
 
-    menu(showrooms);
-    return 0;
+    report_free(&report);
+    if (report.f) fclose(report.f);
+    wal_close(wal);
+    for (int i = 0; i < count; i++)
+        showroom_destroy(&showrooms[i]);
+    vindir_free(&vin_directory);
+    free(showrooms);
+    return status;
 }
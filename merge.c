@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "merge.h"
+
+int merge_before(const MergeSource* a, const MergeSource* b) {
+    return a->vin < b->vin || (a->vin == b->vin && a->rank < b->rank);
+}
+
+void merge_sift_down(MergeSource** heap, int n, int i) {
+    MergeSource* item = heap[i];
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n && merge_before(heap[child + 1], heap[child])) child++;
+        if (!merge_before(heap[child], item)) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = item;
+}
+
+// Moves the source to its next car; returns 0 once it is exhausted.
+int merge_advance(MergeSource* src) {
+    void* data;
+    if (!bptree_cursor_next(&src->cur, &src->vin, &data)) return 0;
+    src->car = (Car*)data;
+    return 1;
+}
+
+//  Where merged cars go: text through stdio, binary through a SnapWriter
+typedef struct MergeOutput {
+    MergeFormat format;
+    FILE* f;
+    SnapWriter w;
+    MergeRecord batch[MERGE_BATCH];
+    int used;
+} MergeOutput;
+
+void merge_flush(MergeOutput* out) {
+    snap_put(&out->w, out->batch, out->used * sizeof(MergeRecord));
+    out->used = 0;
+}
+
+void merge_emit(MergeOutput* out, const MergeSource* src) {
+    const Car* car = src->car;
+    if (out->format == MERGE_TEXT) {
+        fprintf(out->f, "%d %s %s %s %s %.2f\n", car->vin, car_name(car), car_color(car), car_fuel(car), car_type(car), car->price);
+        return;
+    }
+    MergeRecord* r = &out->batch[out->used++];
+    r->vin = car->vin;
+    r->showroom_id = src->showroom->showroom_id;
+    r->price = car->price;
+    r->model = car->model;
+    r->color = car->color;
+    r->fuel = car->fuel;
+    r->type = car->type;
+    if (out->used == MERGE_BATCH) merge_flush(out);
+}
+
+// Writes the available stock of every showroom to path as one VIN-ordered
+// catalog. Each showroom's tree is already sorted, so this is a k-way merge
+// over leaf cursors with a k-entry heap: memory stays O(k) however many
+// cars there are. When showrooms share a VIN the car from the earliest
+// showroom in the array is kept and the others are counted as duplicates.
+// Returns 0 if the file could not be written.
+int merge_showrooms(Showroom* showrooms, int count, const char* path, MergeFormat format, MergeStats* stats) {
+    MergeOutput* out = (MergeOutput*)calloc(1, sizeof(MergeOutput));
+    MergeSource* sources = (MergeSource*)calloc(count ? count : 1, sizeof(MergeSource));
+    MergeSource** heap = (MergeSource**)malloc((count ? count : 1) * sizeof(MergeSource*));
+    if (!out || !sources || !heap) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    stats->cars = stats->duplicates = 0;
+
+    out->format = format;
+    out->f = fopen(path, format == MERGE_BINARY ? "wb" : "w");
+    if (!out->f) {
+        report_message(&report, "Error opening file!\n");
+        free(out);
+        free(sources);
+        free(heap);
+        return 0;
+    }
+    setvbuf(out->f, NULL, _IOFBF, MERGE_BUFFER_SIZE);
+
+    MergeHeader h;
+    memset(&h, 0, sizeof(h));
+    if (format == MERGE_BINARY) {
+        char blank[MERGE_HEADER_BYTES];
+        memset(blank, 0, sizeof(blank));
+        out->w.f = out->f;
+        out->w.path = path;
+        if (fwrite(blank, 1, sizeof(blank), out->f) != sizeof(blank)) out->w.failed = 1;
+        out->w.pos = sizeof(blank);
+        Dict* dicts[SNAPSHOT_DICTS] = { &car_models, &car_colors, &car_fuels, &car_types };
+        for (int d = 0; d < SNAPSHOT_DICTS; d++)
+            snap_put_dict(&out->w, &h.dicts[d], dicts[d]);
+        snap_align(&out->w);
+        h.cars_off = out->w.pos;
+    }
+
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        MergeSource* src = &sources[i];
+        src->showroom = &showrooms[i];
+        src->rank = i;
+        bptree_cursor_first(&src->cur, showrooms[i].available_stock);
+        if (merge_advance(src)) heap[n++] = src;
+    }
+    for (int i = n / 2 - 1; i >= 0; i--)
+        merge_sift_down(heap, n, i);
+
+    int have_last = 0, last_vin = 0, last_id = 0;
+    while (n > 0) {
+        MergeSource* src = heap[0];
+        if (have_last && src->vin == last_vin) {
+            if (++stats->duplicates <= MERGE_MAX_REPORTED)
+                report_message(&report, "Duplicate VIN %d in showroom %d (kept the one in showroom %d)\n",
+                       src->vin, src->showroom->showroom_id, last_id);
+        } else {
+            merge_emit(out, src);
+            stats->cars++;
+            have_last = 1;
+            last_vin = src->vin;
+            last_id = src->showroom->showroom_id;
+        }
+        if (!merge_advance(src)) heap[0] = heap[--n];
+        if (n > 0) merge_sift_down(heap, n, 0);
+    }
+
+    int ok = 1;
+    if (format == MERGE_BINARY) {
+        merge_flush(out);
+        memcpy(h.magic, MERGE_MAGIC, 8);
+        h.version = MERGE_VERSION;
+        h.body_crc = out->w.crc;
+        h.num_cars = stats->cars;
+        ok = !out->w.failed && fseek(out->f, 0, SEEK_SET) == 0 && fwrite(&h, 1, sizeof(h), out->f) == sizeof(h);
+    }
+    if (ferror(out->f)) ok = 0;
+    if (fclose(out->f) != 0) ok = 0;
+    if (!ok) report_message(&report, "Writing %s failed: %s\n", path, strerror(errno));
+
+    free(out);
+    free(sources);
+    free(heap);
+    return ok;
+}
+
+void merge_and_sort_database(Showroom* showrooms, int count) {
+    MergeStats stats;
+    if (!merge_showrooms(showrooms, count, MERGE_DEFAULT_PATH, MERGE_TEXT, &stats)) return;
+    report_text(&report, "Merged %ld cars from %d showrooms into %s", stats.cars, count, MERGE_DEFAULT_PATH);
+    if (stats.duplicates) report_text(&report, " (%ld duplicate VINs skipped)", stats.duplicates);
+    report_text(&report, "\n");
+}
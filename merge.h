@@ -0,0 +1,57 @@
+#ifndef MERGE_H
+#define MERGE_H
+
+#include "bptree.h"
+#include "snapshot.h"
+
+#define MERGE_DEFAULT_PATH "merge.txt"
+#define MERGE_MAGIC "SRMRG001"          // 8 bytes at the start of a binary catalog
+#define MERGE_VERSION 1
+#define MERGE_BUFFER_SIZE (1 << 20)     // output buffer
+#define MERGE_BATCH 1024                // binary records checksummed per call
+#define MERGE_MAX_REPORTED 10           // duplicate VINs listed individually
+
+typedef enum MergeFormat {
+    MERGE_TEXT,         // "vin model color fuel type price" lines, as before
+    MERGE_BINARY        // MergeHeader, dictionaries, MergeRecord array
+} MergeFormat;
+
+//  Binary catalog record
+typedef struct MergeRecord {
+    int vin;
+    int showroom_id;
+    float price;
+    unsigned short model, color, fuel, type; // ids in the catalog's dictionaries
+} MergeRecord;
+
+//  Binary catalog header; the dictionary sections use the snapshot layout
+typedef struct MergeHeader {
+    char magic[8];
+    unsigned version;
+    unsigned body_crc;           // CRC-32C of every byte after the header
+    unsigned long long num_cars;
+    unsigned long long cars_off; // MergeRecord[num_cars], in VIN order
+    SnapDict dicts[SNAPSHOT_DICTS];
+} MergeHeader;
+
+#define MERGE_HEADER_BYTES ((sizeof(MergeHeader) + SNAPSHOT_ALIGN - 1) & ~(size_t)(SNAPSHOT_ALIGN - 1))
+
+//  One input of the merge: a showroom's stock, read in VIN order
+typedef struct MergeSource {
+    BPTreeCursor cur;
+    const Showroom* showroom;
+    int rank;           // position in the showroom array, breaks VIN ties
+    int vin;
+    Car* car;
+} MergeSource;
+
+//  Outcome of a merge
+typedef struct MergeStats {
+    long cars;          // written
+    long duplicates;    // skipped: VIN already taken by an earlier showroom
+} MergeStats;
+
+int merge_showrooms(Showroom* showrooms, int count, const char* path, MergeFormat format, MergeStats* stats);
+void merge_and_sort_database(Showroom* showrooms, int count);
+
+#endif
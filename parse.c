@@ -0,0 +1,258 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "parse.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+Dict car_models = DICT_INIT, car_colors = DICT_INIT, car_fuels = DICT_INIT, car_types = DICT_INIT;
+
+__thread DictCacheEntry dict_cache[DICT_CACHE_SLOTS];
+
+// Maps the file read-only; falls back to one fread into a malloc'd buffer.
+int text_file_open(TextFile* tf, const char* filename) {
+    tf->name = filename;
+    tf->data = NULL;
+    tf->size = 0;
+    tf->mapped = 0;
+
+#ifndef _WIN32
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+            tf->data = (char*)p;
+            tf->size = st.st_size;
+            tf->mapped = 1;
+            close(fd);
+            return 1;
+        }
+    }
+    close(fd);
+#endif
+
+    FILE* f = fopen(filename, "rb");
+    if (!f) return 0;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    tf->data = (char*)malloc(size > 0 ? size : 1);
+    if (!tf->data) {
+        fclose(f);
+        return 0;
+    }
+    tf->size = size > 0 ? fread(tf->data, 1, size, f) : 0;
+    fclose(f);
+    return 1;
+}
+
+void text_file_close(TextFile* tf) {
+#ifndef _WIN32
+    if (tf->mapped) {
+        munmap(tf->data, tf->size);
+        tf->data = NULL;
+        return;
+    }
+#endif
+    free(tf->data);
+    tf->data = NULL;
+}
+
+void scanner_init(LineScanner* sc, const char* name, const char* data, size_t size) {
+    sc->name = name;
+    sc->p = data;
+    sc->end = data + size;
+    sc->line = sc->line_end = data;
+    sc->line_no = 0;
+    sc->errors = 0;
+}
+
+int is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v';
+}
+
+// Advances to the next non-blank line. Returns 0 at end of input.
+int scanner_next_line(LineScanner* sc) {
+    while (sc->p < sc->end) {
+        const char* start = sc->p;
+        const char* nl = (const char*)memchr(start, '\n', sc->end - start);
+        const char* stop = nl ? nl : sc->end;
+        sc->p = nl ? nl + 1 : sc->end;
+        sc->line_no++;
+
+        const char* q = start;
+        while (q < stop && is_space(*q)) q++;
+        if (q == stop) continue;
+
+        sc->line = start;
+        sc->line_end = stop;
+        return 1;
+    }
+    return 0;
+}
+
+// Splits the current line into at most max fields. Returns the number of
+// fields found, or max + 1 if there were more.
+int scanner_fields(LineScanner* sc, Token* fields, int max) {
+    const char* q = sc->line;
+    int n = 0;
+    while (1) {
+        while (q < sc->line_end && is_space(*q)) q++;
+        if (q == sc->line_end) break;
+        const char* start = q;
+        while (q < sc->line_end && !is_space(*q)) q++;
+        if (n == max) return max + 1;
+        fields[n].s = start;
+        fields[n].len = (int)(q - start);
+        n++;
+    }
+    return n;
+}
+
+void scanner_error(LineScanner* sc, const char* fmt, ...) {
+    va_list ap;
+    fprintf(stderr, "%s:%d: ", sc->name, sc->line_no);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fprintf(stderr, "\n");
+    sc->errors++;
+}
+
+int parse_int(Token t, int* out) {
+    int i = 0, neg = 0;
+    long long v = 0;
+    if (i < t.len && (t.s[i] == '-' || t.s[i] == '+')) neg = t.s[i++] == '-';
+    if (i == t.len) return 0;
+    for (; i < t.len; i++) {
+        unsigned d = (unsigned)(t.s[i] - '0');
+        if (d > 9) return 0;
+        v = v * 10 + d;
+        if (v > 2147483648LL) return 0;
+    }
+    if (neg) v = -v;
+    if (v > 2147483647LL) return 0;
+    *out = (int)v;
+    return 1;
+}
+
+// Decimal numbers only ("700000", "-1.25", "705000.00"); no exponents.
+int parse_float(Token t, float* out) {
+    int i = 0, neg = 0, digits = 0;
+    double v = 0, scale = 1;
+    if (i < t.len && (t.s[i] == '-' || t.s[i] == '+')) neg = t.s[i++] == '-';
+    for (; i < t.len && (unsigned)(t.s[i] - '0') <= 9; i++, digits++)
+        v = v * 10 + (t.s[i] - '0');
+    if (i < t.len && t.s[i] == '.') {
+        for (i++; i < t.len && (unsigned)(t.s[i] - '0') <= 9; i++, digits++) {
+            scale *= 10;
+            v = v * 10 + (t.s[i] - '0');
+        }
+    }
+    if (i != t.len || digits == 0) return 0;
+    *out = (float)((neg ? -v : v) / scale);
+    return 1;
+}
+
+// Bounded copy of a string field; over-long values are reported and cut.
+void copy_token(LineScanner* sc, Token t, char* dst, int cap, const char* what) {
+    int len = t.len;
+    if (len >= cap) {
+        scanner_error(sc, "%s too long (%d chars), truncated to %d", what, t.len, cap - 1);
+        len = cap - 1;
+    }
+    memcpy(dst, t.s, len);
+    dst[len] = '\0';
+}
+
+unsigned hash_bytes(const char* s, int len) {
+    unsigned h = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void dict_grow(Dict* d) {
+    int num_slots = d->num_slots ? d->num_slots * 2 : 64;
+    int* slots = (int*)calloc(num_slots, sizeof(int));
+    if (!slots) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (int id = 0; id < d->count; id++) {
+        unsigned h = hash_bytes(d->names[id], (int)strlen(d->names[id])) & (num_slots - 1);
+        while (slots[h]) h = (h + 1) & (num_slots - 1);
+        slots[h] = id + 1;
+    }
+    free(d->slots);
+    d->slots = slots;
+    d->num_slots = num_slots;
+}
+
+// Returns the id of s[0..len), adding it on first sight. Attribute columns
+// have few distinct values, so nearly every call is answered by the calling
+// thread's cache without touching the shared table. Writers hold the lock;
+// names and count are published with release stores for dict_name.
+int dict_intern(Dict* d, const char* s, int len) {
+    unsigned hash = hash_bytes(s, len);
+    DictCacheEntry* e = &dict_cache[hash & (DICT_CACHE_SLOTS - 1)];
+    if (e->dict == d && strncmp(e->name, s, len) == 0 && e->name[len] == '\0') return e->id;
+
+    pthread_mutex_lock(&d->lock);
+    if (d->count * 2 >= d->num_slots) dict_grow(d);
+
+    int id = -1;
+    unsigned h = hash & (d->num_slots - 1);
+    while (d->slots[h]) {
+        const char* name = d->names[d->slots[h] - 1];
+        if (strncmp(name, s, len) == 0 && name[len] == '\0') {
+            id = d->slots[h] - 1;
+            break;
+        }
+        h = (h + 1) & (d->num_slots - 1);
+    }
+
+    if (id < 0) {
+        if (!d->arena) d->arena = arena_create();
+        if (d->count == d->capacity) {
+            // A reader may still hold the old array, so it is not freed:
+            // both live in the arena, which lasts as long as the dictionary
+            int capacity = d->capacity ? d->capacity * 2 : 16;
+            const char** names = (const char**)arena_alloc(d->arena, capacity * sizeof(const char*));
+            if (d->count) memcpy(names, d->names, d->count * sizeof(const char*));
+            __atomic_store_n(&d->names, names, __ATOMIC_RELEASE);
+            d->capacity = capacity;
+        }
+        char* copy = (char*)arena_alloc(d->arena, len + 1);
+        memcpy(copy, s, len);
+        copy[len] = '\0';
+
+        id = d->count;
+        d->names[id] = copy;
+        __atomic_store_n(&d->count, id + 1, __ATOMIC_RELEASE);
+        d->slots[h] = id + 1;
+    }
+
+    e->dict = d;
+    e->name = d->names[id];
+    e->id = id;
+    pthread_mutex_unlock(&d->lock);
+    return id;
+}
+
+// Lock-free: an id below the published count has its name in whichever
+// names array is current, and a replaced array is never freed.
+const char* dict_name(Dict* d, int id) {
+    if (id < 0 || id >= __atomic_load_n(&d->count, __ATOMIC_ACQUIRE)) return "?";
+    return __atomic_load_n(&d->names, __ATOMIC_ACQUIRE)[id];
+}
@@ -0,0 +1,74 @@
+#ifndef PARSE_H
+#define PARSE_H
+
+#include <stddef.h>
+#include <pthread.h>
+#include "arena.h"
+
+#define PARSE_MAX_FIELDS 16
+#define DICT_CACHE_SLOTS 64     // per-thread intern cache, power of two
+
+//  Whole input file, memory-mapped where the platform allows it
+typedef struct TextFile {
+    const char* name;
+    char* data;
+    size_t size;
+    int mapped;         // 1 = mmap, 0 = malloc'd copy
+} TextFile;
+
+//  One whitespace-separated field; points into the file, not copied
+typedef struct Token {
+    const char* s;
+    int len;
+} Token;
+
+//  Line-by-line view over a TextFile
+typedef struct LineScanner {
+    const char* name;
+    const char* p;          // start of the unread input
+    const char* end;
+    const char* line;       // current line
+    const char* line_end;
+    int line_no;
+    int errors;
+} LineScanner;
+
+//  Interned string dictionary: every distinct string is stored once and
+//  gets a small dense id. Safe to share between loader threads.
+typedef struct Dict {
+    Arena* arena;           // string storage
+    const char** names;     // id -> string; grown copies live in the arena
+    int count;
+    int capacity;
+    int* slots;             // open addressing, id + 1 (0 = empty)
+    int num_slots;
+    pthread_mutex_t lock;
+} Dict;
+
+#define DICT_INIT { NULL, NULL, 0, 0, NULL, 0, PTHREAD_MUTEX_INITIALIZER }
+
+//  Recently interned string, cached per thread so repeated values skip the lock
+typedef struct DictCacheEntry {
+    Dict* dict;
+    const char* name;       // stable: lives in the dictionary's arena
+    int id;
+} DictCacheEntry;
+
+int text_file_open(TextFile* tf, const char* filename);
+void text_file_close(TextFile* tf);
+
+void scanner_init(LineScanner* sc, const char* name, const char* data, size_t size);
+int scanner_next_line(LineScanner* sc);
+int scanner_fields(LineScanner* sc, Token* fields, int max);
+void scanner_error(LineScanner* sc, const char* fmt, ...);
+
+int parse_int(Token t, int* out);
+int parse_float(Token t, float* out);
+void copy_token(LineScanner* sc, Token t, char* dst, int cap, const char* what);
+
+int dict_intern(Dict* d, const char* s, int len);
+const char* dict_name(Dict* d, int id);
+
+extern Dict car_models, car_colors, car_fuels, car_types;
+
+#endif
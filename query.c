@@ -0,0 +1,400 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include "query.h"
+
+int query_parse_int(const char* s, int* out) {
+    char* end;
+    errno = 0;
+    long v = strtol(s, &end, 10);
+    if (end == s || *end || errno || v < INT_MIN || v > INT_MAX) return 0;
+    *out = (int)v;
+    return 1;
+}
+
+int query_parse_float(const char* s, float* out) {
+    char* end;
+    errno = 0;
+    float v = strtof(s, &end);
+    if (end == s || *end || errno) return 0;
+    *out = v;
+    return 1;
+}
+
+// Resolves a showroom ID argument; NULL (and a message) if out of range.
+Showroom* query_showroom(Showroom* showrooms, int count, const char* arg) {
+    int id;
+    if (!query_parse_int(arg, &id) || id < 1 || id > count) {
+        report_message(&report, "Invalid showroom ID.\n");
+        return NULL;
+    }
+    return &showrooms[id - 1];
+}
+
+// Dates as the menu takes them, ddmmyyyy
+int query_parse_date(const char* s, int* out) {
+    if (!query_parse_int(s, out) || ts_month_number(*out) < 0) {
+        report_message(&report, "Invalid date.\n");
+        return 0;
+    }
+    return 1;
+}
+
+QueryStatus query_stock(Showroom* showrooms, int count, char** args, int nargs) {
+    Showroom* s = query_showroom(showrooms, count, args[0]);
+    if (!s) return QUERY_FAILED;
+    bptree_traverse(s->available_stock, 1);
+    return QUERY_OK;
+}
+
+QueryStatus query_sold(Showroom* showrooms, int count, char** args, int nargs) {
+    Showroom* s = query_showroom(showrooms, count, args[0]);
+    if (!s) return QUERY_FAILED;
+    bptree_traverse(s->sold_stock, 1);
+    return QUERY_OK;
+}
+
+QueryStatus query_salespersons(Showroom* showrooms, int count, char** args, int nargs) {
+    Showroom* s = query_showroom(showrooms, count, args[0]);
+    if (!s) return QUERY_FAILED;
+    bptree_traverse(s->salespersons, 0);
+    return QUERY_OK;
+}
+
+// add-salesperson SHOWROOM ID NAME [TARGET]
+QueryStatus query_add_salesperson(Showroom* showrooms, int count, char** args, int nargs) {
+    int id;
+    float target = 50.0;
+    if (!query_parse_int(args[1], &id) || (nargs > 3 && !query_parse_float(args[3], &target))) return QUERY_SYNTAX;
+    Showroom* s = query_showroom(showrooms, count, args[0]);
+    if (!s) return QUERY_FAILED;
+    if (get_salesperson(s->salespersons, id)) {
+        report_message(&report, "Salesperson %d already exists in showroom %d\n", id, s->showroom_id);
+        return QUERY_FAILED;
+    }
+    Salesperson* sp = showroom_add_salesperson(s, id, args[2], target);
+    if (s->wal) wal_log_salesperson(s->wal, s, sp);
+    report_text(&report, "Salesperson added.\n");
+    return QUERY_OK;
+}
+
+// sell SHOWROOM NAME MOBILE ADDRESS VIN REG DATE METHOD CODE SALESPERSON,
+// in the order the menu asks for them
+QueryStatus query_sell(Showroom* showrooms, int count, char** args, int nargs) {
+    Sale cust;
+    int vin, spid;
+    memset(&cust, 0, sizeof(Sale));
+    if (!query_parse_int(args[4], &vin) || !query_parse_int(args[6], &cust.d_o_prchse) ||
+        !query_parse_int(args[8], &cust.payment_code) || !query_parse_int(args[9], &spid))
+        return QUERY_SYNTAX;
+    Showroom* s = query_showroom(showrooms, count, args[0]);
+    if (!s) return QUERY_FAILED;
+    snprintf(cust.cust_name, NAME_LEN, "%s", args[1]);
+    snprintf(cust.cust_mobile, NAME_LEN, "%s", args[2]);
+    snprintf(cust.cust_address, ADDRESS_LEN, "%s", args[3]);
+    snprintf(cust.reg_no, NAME_LEN, "%s", args[5]);
+    snprintf(cust.payment_method, NAME_LEN, "%s", args[7]);
+
+    Salesperson* sp = get_salesperson(s->salespersons, spid);
+    if (!sp) {
+        report_message(&report, "Salesperson not found.\n");
+        return QUERY_FAILED;
+    }
+    SaleStatus status = showroom_sell_car(s, vin, sp, &cust);
+    print_sale_status(&report, s, vin, status);
+    return status == SALE_OK ? QUERY_OK : QUERY_FAILED;
+}
+
+// merge [FILE]
+QueryStatus query_merge(Showroom* showrooms, int count, char** args, int nargs) {
+    const char* path = nargs > 0 ? args[0] : MERGE_DEFAULT_PATH;
+    MergeStats stats;
+    if (!merge_showrooms(showrooms, count, path, MERGE_TEXT, &stats)) return QUERY_FAILED;
+    report_text(&report, "Merged %ld cars from %d showrooms into %s", stats.cars, count, path);
+    if (stats.duplicates) report_text(&report, " (%ld duplicate VINs skipped)", stats.duplicates);
+    report_text(&report, "\n");
+    return QUERY_OK;
+}
+
+QueryStatus query_popular(Showroom* showrooms, int count, char** args, int nargs) {
+    find_most_popular_car(showrooms, count);
+    return QUERY_OK;
+}
+
+QueryStatus query_best_salesperson(Showroom* showrooms, int count, char** args, int nargs) {
+    find_most_successful_sales_person(showrooms, count);
+    return QUERY_OK;
+}
+
+QueryStatus query_predict(Showroom* showrooms, int count, char** args, int nargs) {
+    int date;
+    if (!query_parse_date(args[0], &date)) return QUERY_FAILED;
+    predict_next_month_sales(showrooms, count, date);
+    return QUERY_OK;
+}
+
+QueryStatus query_car(Showroom* showrooms, int count, char** args, int nargs) {
+    int vin;
+    VinLookup r;
+    if (!query_parse_int(args[0], &vin)) return QUERY_SYNTAX;
+    int found = vindir_lookup(&vin_directory, vin, &r);
+    report_vin_lookup(&report, vin, &r);
+    return found ? QUERY_OK : QUERY_FAILED;
+}
+
+QueryStatus query_sales_range(Showroom* showrooms, int count, char** args, int nargs) {
+    float lo, hi;
+    if (!query_parse_float(args[0], &lo) || !query_parse_float(args[1], &hi)) return QUERY_SYNTAX;
+    search_sales_person_by_sales_range(showrooms, count, lo, hi);
+    return QUERY_OK;
+}
+
+QueryStatus query_emi(Showroom* showrooms, int count, char** args, int nargs) {
+    print_customers_with_36_months_emi_loan(showrooms, count);
+    return QUERY_OK;
+}
+
+QueryStatus query_price_range(Showroom* showrooms, int count, char** args, int nargs) {
+    float lo, hi;
+    if (!query_parse_float(args[0], &lo) || !query_parse_float(args[1], &hi)) return QUERY_SYNTAX;
+    list_cars_in_price_range(showrooms, count, lo, hi);
+    return QUERY_OK;
+}
+
+QueryStatus query_sold_between(Showroom* showrooms, int count, char** args, int nargs) {
+    int from, to;
+    if (!query_parse_int(args[0], &from) || !query_parse_int(args[1], &to)) return QUERY_SYNTAX;
+    list_sales_between_dates(showrooms, count, from, to);
+    return QUERY_OK;
+}
+
+// breakdown model|color|fuel|type (or 1-4 as in the menu)
+QueryStatus query_breakdown(Showroom* showrooms, int count, char** args, int nargs) {
+    const char* fields[] = { "model", "color", "fuel", "type" };
+    int field = -1;
+    for (int i = 0; i < 4; i++)
+        if (strcmp(args[0], fields[i]) == 0) field = i;
+    if (field < 0 && query_parse_int(args[0], &field)) field--;
+    if (field < 0 || field > 3) return QUERY_SYNTAX;
+    print_sales_breakdown(showrooms, count, (GroupField)field);
+    return QUERY_OK;
+}
+
+// snapshot [FILE]
+QueryStatus query_snapshot(Showroom* showrooms, int count, char** args, int nargs) {
+    const char* path = nargs > 0 ? args[0] : SNAPSHOT_DEFAULT_PATH;
+    if (!snapshot_write(path, showrooms, count)) return QUERY_FAILED;
+    report_text(&report, "Saved snapshot to %s\n", path);
+    return QUERY_OK;
+}
+
+QueryStatus query_top(Showroom* showrooms, int count, char** args, int nargs) {
+    int k;
+    if (!query_parse_int(args[0], &k)) return QUERY_SYNTAX;
+    print_leaderboard(k);
+    return k > 0 ? QUERY_OK : QUERY_FAILED;
+}
+
+QueryStatus query_trend(Showroom* showrooms, int count, char** args, int nargs) {
+    int date, months;
+    if (!query_parse_int(args[1], &months)) return QUERY_SYNTAX;
+    if (!query_parse_date(args[0], &date)) return QUERY_FAILED;
+    print_sales_trend(showrooms, count, date, months);
+    return months > 0 ? QUERY_OK : QUERY_FAILED;
+}
+
+QueryStatus query_loans(Showroom* showrooms, int count, char** args, int nargs) {
+    int date;
+    if (!query_parse_date(args[0], &date)) return QUERY_FAILED;
+    print_loan_portfolio(showrooms, count, date);
+    return QUERY_OK;
+}
+
+QueryStatus query_exit(Showroom* showrooms, int count, char** args, int nargs) {
+    return QUERY_EXIT;
+}
+
+QueryStatus query_help(Showroom* showrooms, int count, char** args, int nargs);
+
+QueryCommand query_commands[] = {
+    { "stock", 1, 1, 1, "SHOWROOM", query_stock, QUERY_READS },
+    { "sold", 2, 1, 1, "SHOWROOM", query_sold, QUERY_READS },
+    { "salespersons", 3, 1, 1, "SHOWROOM", query_salespersons, QUERY_READS },
+    { "add-salesperson", 4, 3, 4, "SHOWROOM ID NAME [TARGET]", query_add_salesperson, QUERY_WRITES },
+    { "sell", 5, 10, 10, "SHOWROOM NAME MOBILE ADDRESS VIN REG DATE METHOD CODE SALESPERSON", query_sell, QUERY_WRITES },
+    { "merge", 6, 0, 1, "[FILE]", query_merge, QUERY_WRITES, 1 },
+    { "popular", 7, 0, 0, "", query_popular, QUERY_READS },
+    { "best-salesperson", 8, 0, 0, "", query_best_salesperson, QUERY_WRITES },
+    { "predict", 9, 1, 1, "DATE", query_predict, QUERY_READS },
+    { "car", 10, 1, 1, "VIN", query_car, QUERY_LOCKFREE },
+    { "sales-range", 11, 2, 2, "MIN MAX", query_sales_range, QUERY_READS },
+    { "emi", 12, 0, 0, "", query_emi, QUERY_READS },
+    { "exit", 13, 0, 0, "", query_exit, QUERY_LOCKFREE },
+    { "price-range", 14, 2, 2, "MIN MAX", query_price_range, QUERY_READS },
+    { "sold-between", 15, 2, 2, "FROM TO", query_sold_between, QUERY_READS },
+    { "breakdown", 16, 1, 1, "model|color|fuel|type", query_breakdown, QUERY_READS },
+    { "snapshot", 17, 0, 1, "[FILE]", query_snapshot, QUERY_WRITES, 1 },
+    { "top", 18, 1, 1, "K", query_top, QUERY_LOCKFREE },
+    { "trend", 19, 2, 2, "DATE MONTHS", query_trend, QUERY_READS },
+    { "loans", 20, 1, 1, "DATE", query_loans, QUERY_READS },
+    { "help", 0, 0, 0, "", query_help, QUERY_LOCKFREE },
+};
+
+#define QUERY_NUM_COMMANDS ((int)(sizeof(query_commands) / sizeof(query_commands[0])))
+
+QueryStatus query_help(Showroom* showrooms, int count, char** args, int nargs) {
+    for (int i = 0; i < QUERY_NUM_COMMANDS; i++) {
+        QueryCommand* c = &query_commands[i];
+        if (c->option) report_message(&report, "%2d  ", c->option);
+        else report_message(&report, "    ");
+        if (*c->usage) report_message(&report, "%-16s %s\n", c->name, c->usage);
+        else report_message(&report, "%s\n", c->name);
+    }
+    report_message(&report, "Dates are ddmmyyyy; '#' starts a comment, ';' separates commands.\n");
+    return QUERY_OK;
+}
+
+// A command by name or by its menu number.
+QueryCommand* query_find(const char* name) {
+    int option;
+    int numeric = query_parse_int(name, &option);
+    for (int i = 0; i < QUERY_NUM_COMMANDS; i++) {
+        if (numeric ? query_commands[i].option == option && option : strcmp(query_commands[i].name, name) == 0)
+            return &query_commands[i];
+    }
+    return NULL;
+}
+
+void query_session_init(QuerySession* q, Showroom* showrooms, int count, int timing) {
+    memset(q, 0, sizeof(QuerySession));
+    q->showrooms = showrooms;
+    q->count = count;
+    q->timing = timing;
+}
+
+double query_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Problems with a command line go to stderr, or with the output when it
+// is captured as a client's response.
+void query_error(const char* where, const char* fmt, ...) {
+    char msg[QUERY_LINE_LEN];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    if (report.capture) report_message(&report, "%s: %s\n", where, msg);
+    else fprintf(stderr, "%s: %s\n", where, msg);
+}
+
+QueryStatus query_call(QuerySession* q, QueryCommand* c, char** args, int nargs) {
+    if (!q->lock || c->access == QUERY_LOCKFREE) return c->run(q->showrooms, q->count, args, nargs);
+    if (c->access == QUERY_WRITES) pthread_rwlock_wrlock(q->lock);
+    else pthread_rwlock_rdlock(q->lock);
+    QueryStatus status = c->run(q->showrooms, q->count, args, nargs);
+    pthread_rwlock_unlock(q->lock);
+    return status;
+}
+
+// Runs one command line (tokenized in place). where names it in messages.
+// Blank lines and comments are QUERY_OK and not counted.
+QueryStatus query_run(QuerySession* q, char* line, const char* where) {
+    char* hash = strchr(line, '#');
+    if (hash) *hash = '\0';
+    char text[QUERY_LINE_LEN];
+    if (q->timing) snprintf(text, sizeof(text), "%s", line + strspn(line, " \t"));
+
+    char* args[QUERY_MAX_ARGS + 1];
+    int nargs = 0;
+    char* save;
+    for (char* tok = strtok_r(line, " \t\r\n", &save); tok; tok = strtok_r(NULL, " \t\r\n", &save)) {
+        if (nargs == QUERY_MAX_ARGS + 1) {
+            query_error(where, "too many arguments");
+            return QUERY_SYNTAX;
+        }
+        args[nargs++] = tok;
+    }
+    if (nargs == 0) return QUERY_OK;
+
+    QueryStatus status;
+    QueryCommand* c = query_find(args[0]);
+    double t0 = query_now();
+    if (!c) {
+        query_error(where, "unknown command '%s' (try help)", args[0]);
+        status = QUERY_SYNTAX;
+    } else if (nargs - 1 < c->min_args || nargs - 1 > c->max_args) {
+        query_error(where, "usage: %s %s", c->name, c->usage);
+        status = QUERY_SYNTAX;
+    } else if (q->remote && c->writes_file && nargs > 1) {
+        query_error(where, "%s: FILE is not accepted from a client; the default path is used without one", c->name);
+        status = QUERY_FAILED;
+    } else {
+        status = query_call(q, c, args + 1, nargs - 1);
+        if (status == QUERY_SYNTAX) query_error(where, "usage: %s %s", c->name, c->usage);
+    }
+    if (q->timing) {
+        // Time the output too, not just filling the buffer
+        report_flush(&report);
+        text[strcspn(text, "\r\n")] = '\0';
+        fprintf(stderr, "%s: %.3f ms: %s\n", where, (query_now() - t0) * 1e3, text);
+    }
+
+    if (status == QUERY_EXIT) return status;
+    q->commands++;
+    if (status != QUERY_OK) q->failed++;
+    if (status > q->worst) q->worst = status;
+    return status;
+}
+
+// One command per line until the end of the file or "exit".
+QueryStatus query_run_file(QuerySession* q, FILE* f, const char* name) {
+    char line[QUERY_LINE_LEN];
+    char where[QUERY_LINE_LEN];
+    int line_no = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        snprintf(where, sizeof(where), "%s:%d", name, line_no);
+        if (!strchr(line, '\n') && !feof(f)) {
+            fprintf(stderr, "%s: line too long\n", where);
+            int ch;
+            while ((ch = fgetc(f)) != EOF && ch != '\n') {}
+            q->commands++;
+            q->failed++;
+            q->worst = QUERY_SYNTAX;
+            continue;
+        }
+        if (query_run(q, line, where) == QUERY_EXIT) return QUERY_EXIT;
+    }
+    return q->worst;
+}
+
+// Commands separated by ';' or newlines, as given to -c.
+QueryStatus query_run_string(QuerySession* q, const char* commands) {
+    char* copy = strdup(commands);
+    if (!copy) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    char where[32];
+    int n = 0;
+    char* save;
+    QueryStatus status = QUERY_OK;
+    for (char* cmd = strtok_r(copy, ";\n", &save); cmd; cmd = strtok_r(NULL, ";\n", &save)) {
+        snprintf(where, sizeof(where), "-c:%d", ++n);
+        if ((status = query_run(q, cmd, where)) == QUERY_EXIT) break;
+    }
+    free(copy);
+    return status == QUERY_EXIT ? QUERY_EXIT : q->worst;
+}
+
+// 0 if every command succeeded, 1 if any failed, 2 on a syntax error
+int query_exit_code(const QuerySession* q) {
+    return (int)q->worst;
+}
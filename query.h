@@ -0,0 +1,58 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include "bptree.h"
+
+#define QUERY_MAX_ARGS 16
+#define QUERY_LINE_LEN 4096
+
+//  Outcome of one command; a script exits with the worst of them
+typedef enum QueryStatus {
+    QUERY_OK,
+    QUERY_FAILED,       // ran, but found nothing or was refused (unknown VIN, bad date, ...)
+    QUERY_SYNTAX,       // unknown command or wrong arguments
+    QUERY_EXIT          // "exit": stop reading commands
+} QueryStatus;
+
+//  What a command may run alongside, when sessions share the showrooms
+typedef enum QueryAccess {
+    QUERY_LOCKFREE,     // safe with anything: the VIN directory and leaderboard lock themselves
+    QUERY_READS,        // reads the trees; runs alongside other readers
+    QUERY_WRITES        // changes the showrooms (or a shared file); runs alone
+} QueryAccess;
+
+typedef QueryStatus (*QueryFn)(Showroom* showrooms, int count, char** args, int nargs);
+
+//  One command of the query language; option is its number in the menu
+typedef struct QueryCommand {
+    const char* name;
+    int option;
+    int min_args;
+    int max_args;
+    const char* usage;
+    QueryFn run;
+    QueryAccess access;
+    int writes_file;    // its optional argument is a path the command (over)writes
+} QueryCommand;
+
+//  A batch of commands run against the loaded showrooms
+typedef struct QuerySession {
+    Showroom* showrooms;
+    int count;
+    int timing;         // per-command wall time on stderr
+    pthread_rwlock_t* lock;     // shared by concurrent sessions; NULL = this one is alone
+    int remote;         // commands come from a socket client: no file paths from it
+    long commands;
+    long failed;
+    QueryStatus worst;
+} QuerySession;
+
+void query_session_init(QuerySession* q, Showroom* showrooms, int count, int timing);
+QueryStatus query_run(QuerySession* q, char* line, const char* where);
+QueryStatus query_run_file(QuerySession* q, FILE* f, const char* name);
+QueryStatus query_run_string(QuerySession* q, const char* commands);
+int query_exit_code(const QuerySession* q);
+
+#endif
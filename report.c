@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "report.h"
+
+#define REPORT_RECORD_ROOM 4096     // free space wanted before a record starts
+
+__thread Report report = { NULL, NULL, 0, 0, REPORT_TABLE };
+LogLevel report_log_level = LOG_ROWS;
+
+void report_init(Report* r, FILE* f, ReportFormat format) {
+    memset(r, 0, sizeof(Report));
+    r->f = f;
+    r->format = format;
+}
+
+void report_drain(Report* r) {
+    if (r->capture) return;
+    if (r->len) fwrite(r->buf, 1, r->len, r->f ? r->f : stdout);
+    r->len = 0;
+}
+
+void report_flush(Report* r) {
+    report_drain(r);
+    if (!r->capture) fflush(r->f ? r->f : stdout);
+}
+
+void report_free(Report* r) {
+    report_flush(r);
+    free(r->buf);
+    r->buf = NULL;
+    r->cap = 0;
+}
+
+int report_parse_format(const char* name, ReportFormat* format) {
+    if (strcmp(name, "table") == 0) *format = REPORT_TABLE;
+    else if (strcmp(name, "csv") == 0) *format = REPORT_CSV;
+    else if (strcmp(name, "json") == 0) *format = REPORT_JSON;
+    else return 0;
+    return 1;
+}
+
+// Room for n more bytes. Between records a full buffer is written out;
+// inside one it grows instead, so the record stays in one piece.
+char* report_reserve(Report* r, size_t n) {
+    if (r->len + n <= r->cap) return r->buf + r->len;
+    if (!r->in_record && !r->capture) report_drain(r);
+    if (r->len + n > r->cap) {
+        size_t cap = r->cap ? r->cap * 2 : REPORT_BUFFER_SIZE;
+        while (cap < r->len + n) cap *= 2;
+        char* buf = (char*)realloc(r->buf, cap);
+        if (!buf) {
+            printf("Memory allocation failed!\n");
+            exit(1);
+        }
+        r->buf = buf;
+        r->cap = cap;
+    }
+    return r->buf + r->len;
+}
+
+void report_put(Report* r, const char* s, size_t n) {
+    memcpy(report_reserve(r, n), s, n);
+    r->len += n;
+}
+
+void report_putc(Report* r, char c) {
+    *report_reserve(r, 1) = c;
+    r->len++;
+}
+
+void report_put_long(Report* r, long v) {
+    char tmp[24];
+    char* p = tmp + sizeof(tmp);
+    unsigned long u = v < 0 ? 0UL - (unsigned long)v : (unsigned long)v;
+    do {
+        *--p = '0' + u % 10;
+        u /= 10;
+    } while (u);
+    if (v < 0) *--p = '-';
+    report_put(r, p, tmp + sizeof(tmp) - p);
+}
+
+// Same digits as printf("%.2f"). A float times 100 is exact in a double,
+// so rounding it half to even by hand matches printf's exact rounding;
+// anything else goes through snprintf.
+void report_put_fixed2(Report* r, double v) {
+    if (!__builtin_isfinite(v) || v != (double)(float)v || v > 1e15 || v < -1e15) {
+        char tmp[352];
+        int n = snprintf(tmp, sizeof(tmp), "%.2f", v);
+        report_put(r, tmp, n < (int)sizeof(tmp) ? n : (int)sizeof(tmp) - 1);
+        return;
+    }
+    double x = (v < 0 ? -v : v) * 100.0;
+    long long cents = (long long)x;
+    double frac = x - (double)cents;
+    if (frac > 0.5 || (frac == 0.5 && (cents & 1))) cents++;
+    if (__builtin_signbit(v)) report_putc(r, '-');
+    report_put_long(r, (long)(cents / 100));
+    char tail[3] = { '.', (char)('0' + cents % 100 / 10), (char)('0' + cents % 10) };
+    report_put(r, tail, 3);
+}
+
+void report_vtext(Report* r, const char* fmt, va_list ap) {
+    va_list again;
+    va_copy(again, ap);
+    char* p = report_reserve(r, 256);
+    int n = vsnprintf(p, r->cap - r->len, fmt, ap);
+    if (n >= 0 && (size_t)n >= r->cap - r->len) {
+        p = report_reserve(r, n + 1);
+        vsnprintf(p, n + 1, fmt, again);
+    }
+    va_end(again);
+    if (n > 0) r->len += n;
+}
+
+void report_text(Report* r, const char* fmt, ...) {
+    if (r->format != REPORT_TABLE) return;
+    va_list ap;
+    va_start(ap, fmt);
+    report_vtext(r, fmt, ap);
+    va_end(ap);
+}
+
+void report_message(Report* r, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    if (r->format == REPORT_TABLE || r->capture) report_vtext(r, fmt, ap);
+    else vfprintf(stderr, fmt, ap);
+    va_end(ap);
+}
+
+void report_indent(Report* r, int indent) {
+    char* p = report_reserve(r, indent);
+    memset(p, ' ', indent);
+    r->len += indent;
+}
+
+void report_begin(Report* r, int indent) {
+    if (r->cap - r->len < REPORT_RECORD_ROOM) report_reserve(r, REPORT_RECORD_ROOM);
+    r->in_record = 1;
+    r->row_start = r->len;
+    r->fields = 0;
+    r->keys_len = 0;
+    if (r->format == REPORT_TABLE) report_indent(r, indent);
+    else if (r->format == REPORT_JSON) report_putc(r, '{');
+}
+
+void report_break(Report* r, int indent) {
+    if (r->format != REPORT_TABLE) return;
+    report_putc(r, '\n');
+    report_indent(r, indent);
+    r->fields = 0;
+}
+
+// Writes the separator and caption or name; returns 0 if the field is
+// not shown in this format.
+int report_field(Report* r, const char* label, const char* key) {
+    if (r->format == REPORT_TABLE) {
+        if (!label) return 0;
+        if (r->fields++) report_put(r, " | ", 3);
+        report_put(r, label, strlen(label));
+        report_put(r, ": ", 2);
+        return 1;
+    }
+    if (!key) return 0;
+    size_t n = strlen(key);
+    if (r->format == REPORT_CSV) {
+        if (r->fields++) report_putc(r, ',');
+        if (r->keys_len + n + 1 < REPORT_KEYS_LEN) {
+            if (r->keys_len) r->keys[r->keys_len++] = ',';
+            memcpy(r->keys + r->keys_len, key, n);
+            r->keys_len += n;
+        }
+        return 1;
+    }
+    if (r->fields++) report_putc(r, ',');
+    report_putc(r, '"');
+    report_put(r, key, n);
+    report_put(r, "\":", 2);
+    return 1;
+}
+
+void report_int(Report* r, const char* label, const char* key, long v) {
+    if (report_field(r, label, key)) report_put_long(r, v);
+}
+
+void report_money(Report* r, const char* label, const char* key, double v) {
+    if (report_field(r, label, key)) report_put_fixed2(r, v);
+}
+
+void report_put_quoted(Report* r, const char* s, size_t n) {
+    report_putc(r, '"');
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (r->format == REPORT_CSV) {
+            if (c == '"') report_putc(r, '"');
+            report_putc(r, c);
+        } else if (c == '"' || c == '\\') {
+            report_putc(r, '\\');
+            report_putc(r, c);
+        } else if (c < 0x20) {
+            char esc[7];
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            report_put(r, esc, 6);
+        } else {
+            report_putc(r, c);
+        }
+    }
+    report_putc(r, '"');
+}
+
+void report_str(Report* r, const char* label, const char* key, const char* s) {
+    if (!report_field(r, label, key)) return;
+    size_t n = strlen(s);
+    if (r->format == REPORT_TABLE || (r->format == REPORT_CSV && !s[strcspn(s, ",\"\r\n")]))
+        report_put(r, s, n);
+    else
+        report_put_quoted(r, s, n);
+}
+
+// Dates are ddmmyyyy. The table keeps the menu's d-m-yyyy; CSV and JSON
+// get yyyy-mm-dd.
+void report_date(Report* r, const char* label, const char* key, int ddmmyyyy) {
+    if (!report_field(r, label, key)) return;
+    int day = ddmmyyyy / 1000000, month = (ddmmyyyy / 10000) % 100, year = ddmmyyyy % 10000;
+    if (r->format == REPORT_TABLE) {
+        report_put_long(r, day);
+        report_putc(r, '-');
+        report_put_long(r, month);
+        report_putc(r, '-');
+        report_put_long(r, year);
+        return;
+    }
+    char iso[12] = { '"', (char)('0' + year / 1000), (char)('0' + year / 100 % 10), (char)('0' + year / 10 % 10),
+                     (char)('0' + year % 10), '-', (char)('0' + month / 10), (char)('0' + month % 10), '-',
+                     (char)('0' + day / 10), (char)('0' + day % 10), '"' };
+    if (r->format == REPORT_JSON) report_put(r, iso, 12);
+    else report_put(r, iso + 1, 10);
+}
+
+// Ends the record. A CSV row whose columns differ from the last header
+// written gets a new header line in front of it.
+void report_end(Report* r) {
+    if (r->format == REPORT_JSON) report_putc(r, '}');
+    report_putc(r, '\n');
+    if (r->format == REPORT_CSV && (strlen(r->header) != r->keys_len || memcmp(r->header, r->keys, r->keys_len))) {
+        size_t row = r->len - r->row_start;
+        char* p = report_reserve(r, r->keys_len + 1) - row;
+        memmove(p + r->keys_len + 1, p, row);
+        memcpy(p, r->keys, r->keys_len);
+        p[r->keys_len] = '\n';
+        r->len += r->keys_len + 1;
+        memcpy(r->header, r->keys, r->keys_len);
+        r->header[r->keys_len] = '\0';
+    }
+    r->in_record = 0;
+}
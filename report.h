@@ -0,0 +1,69 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define REPORT_BUFFER_SIZE (1 << 20)    // bytes gathered before a write
+#define REPORT_KEYS_LEN 512             // CSV header of one record kind
+
+//  How records are written
+typedef enum ReportFormat {
+    REPORT_TABLE,       // "Label: value | Label: value", as the menu always printed
+    REPORT_CSV,         // a header line whenever the columns change, then rows
+    REPORT_JSON         // one object per line
+} ReportFormat;
+
+//  How much the loader says about each file
+typedef enum LogLevel {
+    LOG_QUIET,          // nothing
+    LOG_SUMMARY,        // one line per file
+    LOG_ROWS            // one line per record, as before
+} LogLevel;
+
+//  Buffered record writer. Output is gathered into a large buffer and
+//  written when it fills or on report_flush; a record is never split
+//  across writes. One Report belongs to one thread at a time. A capturing
+//  Report is never written out: buf collects a response for a client.
+typedef struct Report {
+    FILE* f;                // NULL = stdout
+    char* buf;
+    size_t len;
+    size_t cap;
+    ReportFormat format;
+    int capture;            // keep everything in buf; messages too, in any format
+    int in_record;
+    int fields;             // fields written to the current line
+    size_t row_start;       // where the current record began in buf
+    char keys[REPORT_KEYS_LEN];         // CSV columns of the current record
+    size_t keys_len;
+    char header[REPORT_KEYS_LEN];       // CSV columns last written as a header
+} Report;
+
+void report_init(Report* r, FILE* f, ReportFormat format);
+void report_flush(Report* r);
+void report_free(Report* r);
+int report_parse_format(const char* name, ReportFormat* format);
+
+// Free text: written in table format only, e.g. headings and totals
+void report_text(Report* r, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+// Messages that are not records: in the table, otherwise to stderr
+void report_message(Report* r, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+// Raw bytes in any format
+void report_put(Report* r, const char* s, size_t n);
+
+// A record is report_begin, its fields, report_end. label is the table
+// caption (NULL = not shown in the table); key is the CSV column and
+// JSON name (NULL = table only).
+void report_begin(Report* r, int indent);
+void report_break(Report* r, int indent);   // table only: continue on a new line
+void report_int(Report* r, const char* label, const char* key, long v);
+void report_money(Report* r, const char* label, const char* key, double v);     // 2 decimals
+void report_str(Report* r, const char* label, const char* key, const char* s);
+void report_date(Report* r, const char* label, const char* key, int ddmmyyyy);
+void report_end(Report* r);
+
+extern __thread Report report;  // where reports go on this thread; the menu's writes to stdout
+extern LogLevel report_log_level;
+
+#endif
@@ -0,0 +1,435 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "server.h"
+
+volatile sig_atomic_t server_stopping = 0;
+int server_signal_fd = -1;
+
+void server_on_signal(int sig) {
+    uint64_t one = 1;
+    server_stopping = 1;
+    if (server_signal_fd >= 0 && write(server_signal_fd, &one, sizeof(one)) < 0) {}
+}
+
+void server_buf_reserve(ServerBuf* b, size_t n) {
+    if (b->len + n <= b->cap) return;
+    size_t cap = b->cap ? b->cap * 2 : SERVER_READ_SIZE;
+    while (cap < b->len + n) cap *= 2;
+    char* data = (char*)realloc(b->data, cap);
+    if (!data) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    b->data = data;
+    b->cap = cap;
+}
+
+void server_buf_append(ServerBuf* b, const char* s, size_t n) {
+    server_buf_reserve(b, n);
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+}
+
+int server_listen_unix(const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "%s: socket path too long\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    unlink(path);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Loopback only: the server has no authentication.
+int server_listen_tcp(int port) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        perror("127.0.0.1");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// ---- Worker side: runs a connection's batch into its Report ----
+
+// "car VIN" (or "10 VIN") and nothing else
+int server_parse_lookup(const char* line, int* vin) {
+    const char* p = line + strspn(line, " \t");
+    if (strncmp(p, "car", 3) == 0) p += 3;
+    else if (strncmp(p, "10", 2) == 0) p += 2;
+    else return 0;
+    if (*p != ' ' && *p != '\t') return 0;
+    char* end;
+    errno = 0;
+    long v = strtol(p, &end, 10);
+    if (end == p || errno || v < INT_MIN || v > INT_MAX) return 0;
+    if (end[strspn(end, " \t\r")]) return 0;
+    *vin = (int)v;
+    return 1;
+}
+
+// The SERVER_HEADER_LEN bytes in front of a response body
+void server_header(char* dst, QueryStatus status, size_t body) {
+    char header[32];
+    snprintf(header, sizeof(header), "%d %010lu\n", (int)status, (unsigned long)body);
+    memcpy(dst, header, SERVER_HEADER_LEN);
+}
+
+// Starts a response: a header to be filled in by server_end_response.
+// Each body starts a fresh CSV header so it can be read on its own.
+size_t server_begin_response() {
+    size_t at = report.len;
+    report_put(&report, "0 0000000000\n", SERVER_HEADER_LEN);
+    report.header[0] = '\0';
+    return at;
+}
+
+void server_end_response(size_t at, QueryStatus status) {
+    server_header(report.buf + at, status, report.len - at - SERVER_HEADER_LEN);
+}
+
+// A run of lookups under one read lock of the VIN directory
+void server_lookups(ServerConn* c, const int* vins, int n) {
+    VinLookup found[SERVER_LOOKUP_BATCH];
+    vindir_lookup_batch(&vin_directory, vins, n, found);
+    for (int i = 0; i < n; i++) {
+        size_t at = server_begin_response();
+        report_vin_lookup(&report, vins[i], &found[i]);
+        server_end_response(at, found[i].car ? QUERY_OK : QUERY_FAILED);
+        if (!found[i].car) c->session.failed++;
+    }
+    c->session.commands += n;
+}
+
+// Every line of the batch gets a response, blank ones included, so a
+// client can count them.
+long server_run_batch(ServerConn* c) {
+    char* p = c->batch.data;
+    char* end = p + c->batch.len;
+    long requests = 0;
+    for (char* q = p; q < end; q++)
+        if (*q == '\n') *q = '\0';
+    while (p < end) {
+        int vins[SERVER_LOOKUP_BATCH];
+        int n = 0;
+        while (n < SERVER_LOOKUP_BATCH && p < end && server_parse_lookup(p, &vins[n])) {
+            p += strlen(p) + 1;
+            n++;
+        }
+        if (n > 0) {
+            server_lookups(c, vins, n);
+            requests += n;
+            continue;
+        }
+        char* next = p + strlen(p) + 1;
+        size_t at = server_begin_response();
+        QueryStatus status = query_run(&c->session, p, "request");
+        server_end_response(at, status);
+        requests++;
+        p = next;
+        if (status == QUERY_EXIT) {
+            c->batch_exited = 1;
+            break;
+        }
+    }
+    return requests;
+}
+
+void server_work(void* arg) {
+    ServerConn* c = (ServerConn*)arg;
+    Server* s = c->server;
+    Report saved = report;
+    report = c->resp;
+    long requests = server_run_batch(c);
+    c->resp = report;
+    report = saved;
+
+    pthread_mutex_lock(&s->done_lock);
+    c->next_done = s->done;
+    s->done = c;
+    s->requests += requests;
+    pthread_mutex_unlock(&s->done_lock);
+    uint64_t one = 1;
+    if (write(s->wake_fd, &one, sizeof(one)) < 0) {}
+}
+
+// ---- Event loop side ----
+
+// Registers the events the connection is waiting for; none = not registered,
+// so a hung-up peer does not wake the loop while a worker still runs.
+void server_watch(ServerConn* c) {
+    int want = 0;
+    if (!c->closing && !c->exited && !c->broken && c->in.len < SERVER_MAX_PENDING) want |= EPOLLIN;
+    if (!c->broken && c->out.len > c->sent) want |= EPOLLOUT;
+    if (want == c->events) return;
+    struct epoll_event ev;
+    ev.events = want;
+    ev.data.ptr = c;
+    if (!want) epoll_ctl(c->server->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    else epoll_ctl(c->server->epoll_fd, c->events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, c->fd, &ev);
+    c->events = want;
+}
+
+void server_close(ServerConn* c) {
+    Server* s = c->server;
+    if (c->prev) c->prev->next = c->next;
+    else s->conns = c->next;
+    if (c->next) c->next->prev = c->prev;
+    close(c->fd);
+    free(c->in.data);
+    free(c->batch.data);
+    free(c->out.data);
+    report_free(&c->resp);
+    free(c);
+}
+
+void server_accept(Server* s) {
+    while (1) {
+        int fd = accept(s->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept");
+            return;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        ServerConn* c = (ServerConn*)calloc(1, sizeof(ServerConn));
+        if (!c) {
+            printf("Memory allocation failed!\n");
+            exit(1);
+        }
+        c->fd = fd;
+        c->server = s;
+        report_init(&c->resp, NULL, s->format);
+        c->resp.capture = 1;
+        query_session_init(&c->session, s->showrooms, s->count, 0);
+        c->session.lock = &s->lock;
+        c->session.remote = 1;
+        c->next = s->conns;
+        if (s->conns) s->conns->prev = c;
+        s->conns = c;
+        s->connections++;
+        server_watch(c);
+    }
+}
+
+void server_read(ServerConn* c) {
+    while (c->in.len < SERVER_MAX_PENDING) {
+        server_buf_reserve(&c->in, SERVER_READ_SIZE);
+        ssize_t n = recv(c->fd, c->in.data + c->in.len, c->in.cap - c->in.len, 0);
+        if (n > 0) {
+            c->in.len += n;
+        } else if (n == 0) {
+            c->closing = 1;
+            return;
+        } else if (errno != EINTR) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) c->broken = 1;
+            return;
+        }
+    }
+}
+
+void server_send(ServerConn* c) {
+    while (c->sent < c->out.len) {
+        ssize_t n = send(c->fd, c->out.data + c->sent, c->out.len - c->sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            c->sent += n;
+        } else if (n < 0 && errno != EINTR) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) c->broken = 1;
+            return;
+        }
+    }
+    c->out.len = c->sent = 0;
+}
+
+// A request that cannot be run: answered with a syntax status, then the
+// connection is closed.
+void server_reject(ServerConn* c, const char* why) {
+    char header[SERVER_HEADER_LEN];
+    size_t n = strlen(why);
+    server_header(header, QUERY_SYNTAX, n + 1);
+    server_buf_append(&c->out, header, SERVER_HEADER_LEN);
+    server_buf_append(&c->out, why, n);
+    server_buf_append(&c->out, "\n", 1);
+    c->in.len = 0;
+    c->exited = 1;
+}
+
+// Hands every complete request line received so far to a worker, unless
+// one is already running this connection's requests (which keeps the
+// responses in order) or the client is not reading its responses.
+void server_dispatch(ServerConn* c) {
+    if (c->busy || c->broken || c->exited || c->out.len - c->sent >= SERVER_MAX_PENDING) return;
+    if (c->closing && c->in.len > 0 && c->in.data[c->in.len - 1] != '\n') server_buf_append(&c->in, "\n", 1);
+    size_t n = c->in.len;
+    while (n > 0 && c->in.data[n - 1] != '\n')
+        n--;
+    if (n == 0) {
+        if (c->in.len >= QUERY_LINE_LEN) server_reject(c, "request: line too long");
+        return;
+    }
+    c->batch.len = 0;
+    server_buf_append(&c->batch, c->in.data, n);
+    memmove(c->in.data, c->in.data + n, c->in.len - n);
+    c->in.len -= n;
+    c->busy = 1;
+    threadpool_submit(c->server->pool, server_work, c);
+}
+
+// After anything happened to an idle connection: close it if it is
+// finished, otherwise wait for what it needs next.
+void server_update(ServerConn* c) {
+    if (c->busy) {
+        server_watch(c);
+        return;
+    }
+    int drained = c->out.len == c->sent;
+    if (c->broken || (drained && (c->exited || (c->closing && c->in.len == 0)))) server_close(c);
+    else server_watch(c);
+}
+
+// Picks up the batches the workers finished
+void server_collect(Server* s) {
+    pthread_mutex_lock(&s->done_lock);
+    ServerConn* c = s->done;
+    s->done = NULL;
+    pthread_mutex_unlock(&s->done_lock);
+    while (c) {
+        ServerConn* next = c->next_done;
+        c->busy = 0;
+        c->exited |= c->batch_exited;
+        if (!c->broken) server_buf_append(&c->out, c->resp.buf, c->resp.len);
+        c->resp.len = 0;
+        if (!c->broken) server_send(c);
+        server_dispatch(c);
+        server_update(c);
+        c = next;
+    }
+}
+
+// Serves requests on listen_fd until SIGINT or SIGTERM; threads workers
+// (<= 0: one per CPU) run them. Returns 0, or 1 if the loop failed.
+int server_run(Showroom* showrooms, int count, int listen_fd, int threads, ReportFormat format) {
+    Server s;
+    memset(&s, 0, sizeof(s));
+    s.showrooms = showrooms;
+    s.count = count;
+    s.format = format;
+    s.listen_fd = listen_fd;
+    pthread_rwlock_init(&s.lock, NULL);
+    pthread_mutex_init(&s.done_lock, NULL);
+    // Built now, so no report has to build one under a read lock
+    for (int i = 0; i < count; i++)
+        showroom_enable_indexes(&showrooms[i], IDX_ALL);
+
+    s.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    s.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (s.epoll_fd < 0 || s.wake_fd < 0) {
+        perror("epoll");
+        return 1;
+    }
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = &s.listen_fd;
+    epoll_ctl(s.epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev);
+    ev.data.ptr = &s.wake_fd;
+    epoll_ctl(s.epoll_fd, EPOLL_CTL_ADD, s.wake_fd, &ev);
+
+    struct sigaction sa, old_int, old_term;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = server_on_signal;
+    sigemptyset(&sa.sa_mask);
+    server_stopping = 0;
+    server_signal_fd = s.wake_fd;
+    sigaction(SIGINT, &sa, &old_int);
+    sigaction(SIGTERM, &sa, &old_term);
+
+    s.pool = threadpool_create(threads);
+    int status = 0;
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while (!server_stopping) {
+        int n = epoll_wait(s.epoll_fd, events, SERVER_MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            status = 1;
+            break;
+        }
+        // Finished batches last: a connection closed below must not be
+        // one that is still queued for pick-up.
+        int woken = 0;
+        for (int i = 0; i < n; i++) {
+            void* p = events[i].data.ptr;
+            if (p == &s.listen_fd) {
+                server_accept(&s);
+            } else if (p == &s.wake_fd) {
+                uint64_t v;
+                if (read(s.wake_fd, &v, sizeof(v)) < 0) {}
+                woken = 1;
+            } else {
+                ServerConn* c = (ServerConn*)p;
+                if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && (c->events & EPOLLIN)) server_read(c);
+                if (c->out.len > c->sent && !c->broken) server_send(c);
+                server_dispatch(c);
+                server_update(c);
+            }
+        }
+        if (woken) server_collect(&s);
+    }
+
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+    server_signal_fd = -1;
+    threadpool_wait(s.pool);
+    server_collect(&s);
+    while (s.conns)
+        server_close(s.conns);
+    threadpool_destroy(s.pool);
+    close(s.wake_fd);
+    close(s.epoll_fd);
+    pthread_rwlock_destroy(&s.lock);
+    pthread_mutex_destroy(&s.done_lock);
+    printf("Served %ld request(s) on %ld connection(s)\n", s.requests, s.connections);
+    return status;
+}
@@ -0,0 +1,72 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <pthread.h>
+#include "bptree.h"
+#include "query.h"
+#include "threadpool.h"
+
+#define SERVER_MAX_EVENTS 64
+#define SERVER_READ_SIZE 65536          // bytes read from a socket at a time
+#define SERVER_MAX_PENDING (8 << 20)    // unread requests or unsent responses a connection may pile up
+#define SERVER_LOOKUP_BATCH 256         // "car" requests in a row looked up together
+#define SERVER_HEADER_LEN 13            // "S LLLLLLLLLL\n"
+
+//  Wire protocol: a request is one query command line (see query.c);
+//  requests may be pipelined. Each gets, in order, a header of its status
+//  digit (QueryStatus), a space, the body length as 10 digits and '\n',
+//  then the body in the server's report format. "exit" ends the
+//  connection after its response. There is no authentication, so merge
+//  and snapshot refuse a FILE argument and write only their default paths.
+
+//  A growable byte buffer
+typedef struct ServerBuf {
+    char* data;
+    size_t len;
+    size_t cap;
+} ServerBuf;
+
+//  One client. The event loop owns it while idle; while busy a worker
+//  runs its batch of requests and the loop touches only the socket.
+typedef struct ServerConn {
+    int fd;
+    struct Server* server;
+    ServerBuf in;               // received, not yet handed to a worker
+    ServerBuf batch;            // complete request lines the worker is running
+    Report resp;                // the worker's responses
+    ServerBuf out;              // responses waiting to be sent
+    size_t sent;                // bytes of out already sent
+    int busy;
+    int closing;                // peer is done sending: close once its requests are answered
+    int exited;                 // sent "exit": close once out is sent
+    int batch_exited;           // set by the worker: its batch ended with "exit"
+    int broken;                 // socket error: close as soon as no worker holds it
+    int events;                 // epoll events registered; 0 = not registered
+    QuerySession session;
+    struct ServerConn* prev;
+    struct ServerConn* next;
+    struct ServerConn* next_done;
+} ServerConn;
+
+//  Event loop plus worker pool serving one set of showrooms
+typedef struct Server {
+    Showroom* showrooms;
+    int count;
+    ReportFormat format;
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;                // eventfd: a batch finished, or a signal asked to stop
+    ThreadPool* pool;
+    pthread_rwlock_t lock;      // readers run together, writers alone (see QueryAccess)
+    pthread_mutex_t done_lock;
+    ServerConn* done;           // batches finished by workers, for the loop to pick up
+    ServerConn* conns;
+    long connections;
+    long requests;
+} Server;
+
+int server_listen_unix(const char* path);
+int server_listen_tcp(int port);
+int server_run(Showroom* showrooms, int count, int listen_fd, int threads, ReportFormat format);
+
+#endif
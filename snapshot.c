@@ -0,0 +1,618 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "snapshot.h"
+#include "vindir.h"
+#include "leaderboard.h"
+#include "timeseries.h"
+
+unsigned crc32c_table[256];
+pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+unsigned (*crc32c_kernel)(unsigned crc, const unsigned char* p, size_t len);
+
+unsigned crc32c_bytes(unsigned crc, const unsigned char* p, size_t len) {
+    while (len--)
+        crc = crc32c_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+#if BPTREE_HAVE_X86_SIMD && defined(__x86_64__)
+// SSE4.2 has CRC-32C (not zlib's CRC-32) as an instruction, 8 bytes at a time.
+__attribute__((target("sse4.2")))
+unsigned crc32c_sse42(unsigned crc, const unsigned char* p, size_t len) {
+    unsigned long long c = crc;
+    for (; len >= 8; len -= 8, p += 8) {
+        unsigned long long v;
+        memcpy(&v, p, 8);
+        c = _mm_crc32_u64(c, v);
+    }
+    crc = (unsigned)c;
+    while (len--)
+        crc = _mm_crc32_u8(crc, *p++);
+    return crc;
+}
+#endif
+
+void crc32c_init() {
+    for (unsigned i = 0; i < 256; i++) {
+        unsigned c = i;
+        for (int k = 0; k < 8; k++)
+            c = c & 1 ? 0x82F63B78u ^ (c >> 1) : c >> 1;
+        crc32c_table[i] = c;
+    }
+    crc32c_kernel = crc32c_bytes;
+#if BPTREE_HAVE_X86_SIMD && defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) crc32c_kernel = crc32c_sse42;
+#endif
+}
+
+// CRC-32C (Castagnoli); pass 0 to start, the previous result to continue.
+// Snapshots are hundreds of megabytes, so this one uses the CPU instruction
+// where there is one; the log's short records stay on crc32_update.
+unsigned crc32c_update(unsigned crc, const void* data, size_t len) {
+    pthread_once(&crc32c_once, crc32c_init);
+    return ~crc32c_kernel(~crc, (const unsigned char*)data, len);
+}
+
+//  Sequential writer that tracks the file offset and the body checksum
+typedef struct SnapWriter {
+    FILE* f;
+    const char* path;
+    unsigned long long pos;
+    unsigned crc;
+    int failed;
+} SnapWriter;
+
+void snap_put(SnapWriter* w, const void* data, size_t len) {
+    if (len == 0 || w->failed) return;
+    if (fwrite(data, 1, len, w->f) != len) {
+        report_message(&report, "Snapshot write to %s failed: %s\n", w->path, strerror(errno));
+        w->failed = 1;
+        return;
+    }
+    w->crc = crc32c_update(w->crc, data, len);
+    w->pos += len;
+}
+
+void snap_align(SnapWriter* w) {
+    static const char zeros[SNAPSHOT_ALIGN];
+    size_t pad = (SNAPSHOT_ALIGN - w->pos % SNAPSHOT_ALIGN) % SNAPSHOT_ALIGN;
+    snap_put(w, zeros, pad);
+}
+
+// Copies the keys and records of a tree into new arrays; returns the count.
+unsigned snap_collect(BPTreeNode* root, int** keys_out, void*** data_out) {
+    BPTreeCursor cur;
+    unsigned n = 0;
+    bptree_cursor_first(&cur, root);
+    while (bptree_cursor_next(&cur, NULL, NULL)) n++;
+
+    int* keys = (int*)malloc((n ? n : 1) * sizeof(int));
+    void** data = (void**)malloc((n ? n : 1) * sizeof(void*));
+    if (!keys || !data) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    unsigned i = 0;
+    bptree_cursor_first(&cur, root);
+    while (i < n && bptree_cursor_next(&cur, &keys[i], &data[i])) i++;
+    *keys_out = keys;
+    *data_out = data;
+    return i;
+}
+
+// Writes level 0 (the sorted keys) and the block-start levels above it.
+void snap_put_tree(SnapWriter* w, SnapTree* t, const int* keys, unsigned n, unsigned base) {
+    memset(t, 0, sizeof(*t));
+    t->n = n;
+    t->base = base;
+    if (n == 0) return;
+
+    const int* level = keys;
+    int* upper = NULL;
+    unsigned len = n;
+    while (1) {
+        snap_align(w);
+        t->level_off[t->num_levels] = w->pos;
+        t->level_len[t->num_levels] = len;
+        t->num_levels++;
+        snap_put(w, level, len * sizeof(int));
+        if (len <= SNAPSHOT_FANOUT) break;
+
+        unsigned up = (len + SNAPSHOT_FANOUT - 1) / SNAPSHOT_FANOUT;
+        int* next = (int*)malloc(up * sizeof(int));
+        if (!next) {
+            printf("Memory allocation failed!\n");
+            exit(1);
+        }
+        for (unsigned j = 0; j < up; j++)
+            next[j] = level[(size_t)j * SNAPSHOT_FANOUT];
+        free(upper);
+        upper = next;
+        level = next;
+        len = up;
+    }
+    free(upper);
+}
+
+void snap_put_dict(SnapWriter* w, SnapDict* sd, Dict* d) {
+    int count = d->count;
+    snap_align(w);
+    sd->off = w->pos;
+    sd->count = count;
+
+    unsigned off = count * sizeof(unsigned);
+    for (int id = 0; id < count; id++) {
+        snap_put(w, &off, sizeof(off));
+        off += strlen(dict_name(d, id)) + 1;
+    }
+    for (int id = 0; id < count; id++) {
+        const char* name = dict_name(d, id);
+        snap_put(w, name, strlen(name) + 1);
+    }
+    sd->bytes = off;
+}
+
+int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+void snap_put_showroom(SnapWriter* w, SnapShowroom* ss, Showroom* s) {
+    int *avail_vins, *sold_vins, *ids;
+    void **avail, **sold, **sps;
+    unsigned na = snap_collect(s->available_stock, &avail_vins, &avail);
+    unsigned ns = snap_collect(s->sold_stock, &sold_vins, &sold);
+    unsigned np = snap_collect(s->salespersons, &ids, &sps);
+
+    memset(ss, 0, sizeof(*ss));
+    ss->showroom_id = s->showroom_id;
+    ss->num_available = na;
+    ss->num_sold = ns;
+    ss->num_salespersons = np;
+
+    // Cars, in batches so the checksum runs over large blocks
+    SnapCar batch[1024];
+    int used = 0;
+    snap_align(w);
+    ss->cars_off = w->pos;
+    for (unsigned i = 0; i < na + ns; i++) {
+        Car* car = (Car*)(i < na ? avail[i] : sold[i - na]);
+        SnapCar* sc = &batch[used++];
+        sc->vin = car->vin;
+        sc->price = car->price;
+        sc->model = car->model;
+        sc->color = car->color;
+        sc->fuel = car->fuel;
+        sc->type = car->type;
+        sc->sale = i < na ? SNAPSHOT_NO_SALE : i - na;
+        if (used == 1024 || i + 1 == na + ns) {
+            snap_put(w, batch, used * sizeof(SnapCar));
+            used = 0;
+        }
+    }
+
+    snap_align(w);
+    ss->sales_off = w->pos;
+    for (unsigned i = 0; i < ns; i++)
+        snap_put(w, ((Car*)sold[i])->sale, sizeof(Sale));
+
+    snap_align(w);
+    ss->salespersons_off = w->pos;
+    unsigned sold_first = 0;
+    for (unsigned i = 0; i < np; i++) {
+        Salesperson* sp = (Salesperson*)sps[i];
+        SnapSalesperson r;
+        memset(&r, 0, sizeof(r));
+        r.id = sp->id;
+        memcpy(r.name, sp->name, NAME_LEN);
+        r.target = sp->target;
+        r.achieved = sp->achieved;
+        r.commission = sp->commission;
+        BPTreeCursor cur;
+        bptree_cursor_first(&cur, sp->soldCarsRoot);
+        r.sold_first = sold_first;
+        while (bptree_cursor_next(&cur, NULL, NULL)) r.sold_count++;
+        sold_first += r.sold_count;
+        snap_put(w, &r, sizeof(r));
+    }
+
+    // Sold-by lists: each salesperson's cars as indexes into the car section
+    snap_align(w);
+    ss->sold_by_off = w->pos;
+    for (unsigned i = 0; i < np; i++) {
+        BPTreeCursor cur;
+        int vin;
+        bptree_cursor_first(&cur, ((Salesperson*)sps[i])->soldCarsRoot);
+        while (bptree_cursor_next(&cur, &vin, NULL)) {
+            int* hit = (int*)bsearch(&vin, sold_vins, ns, sizeof(int), compare_ints);
+            unsigned idx = hit ? na + (unsigned)(hit - sold_vins) : SNAPSHOT_NO_SALE;
+            snap_put(w, &idx, sizeof(idx));
+        }
+    }
+
+    snap_put_tree(w, &ss->available, avail_vins, na, 0);
+    snap_put_tree(w, &ss->sold, sold_vins, ns, na);
+    snap_put_tree(w, &ss->by_id, ids, np, 0);
+
+    free(avail_vins);
+    free(avail);
+    free(sold_vins);
+    free(sold);
+    free(ids);
+    free(sps);
+}
+
+// Writes every showroom to a new file and renames it over path, so a crash
+// leaves either the old snapshot or the new one. No sale may be in flight.
+// Returns 0 on failure.
+int snapshot_write(const char* path, Showroom* showrooms, int count) {
+    char tmp[SNAPSHOT_PATH_LEN + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE* f = fopen(tmp, "wb");
+    if (!f) {
+        report_message(&report, "Cannot create %s: %s\n", tmp, strerror(errno));
+        return 0;
+    }
+
+    SnapHeader h;
+    memset(&h, 0, sizeof(h));
+    char blank[SNAPSHOT_HEADER_BYTES];
+    memset(blank, 0, sizeof(blank));
+    SnapWriter w = { f, tmp, 0, 0, 0 };
+    if (fwrite(blank, 1, sizeof(blank), f) != sizeof(blank)) w.failed = 1;
+    w.pos = sizeof(blank);
+
+    Dict* dicts[SNAPSHOT_DICTS] = { &car_models, &car_colors, &car_fuels, &car_types };
+    for (int d = 0; d < SNAPSHOT_DICTS; d++)
+        snap_put_dict(&w, &h.dicts[d], dicts[d]);
+
+    SnapShowroom* table = (SnapShowroom*)calloc(count ? count : 1, sizeof(SnapShowroom));
+    if (!table) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (int i = 0; i < count; i++)
+        snap_put_showroom(&w, &table[i], &showrooms[i]);
+    snap_align(&w);
+    h.showrooms_off = w.pos;
+    snap_put(&w, table, count * sizeof(SnapShowroom));
+    free(table);
+
+    memcpy(h.magic, SNAPSHOT_MAGIC, 8);
+    h.version = SNAPSHOT_VERSION;
+    h.file_size = w.pos;
+    h.body_crc = w.crc;
+    h.fanout = SNAPSHOT_FANOUT;
+    h.car_size = sizeof(SnapCar);
+    h.sale_size = sizeof(Sale);
+    h.salesperson_size = sizeof(SnapSalesperson);
+    h.num_showrooms = count;
+    h.header_crc = crc32c_update(0, &h, sizeof(h));
+
+    if (!w.failed && (fseek(f, 0, SEEK_SET) != 0 || fwrite(&h, 1, sizeof(h), f) != sizeof(h))) w.failed = 1;
+    if (!w.failed && (fflush(f) != 0 || fsync(fileno(f)) != 0)) w.failed = 1;
+    if (fclose(f) != 0) w.failed = 1;
+    if (w.failed || rename(tmp, path) != 0) {
+        report_message(&report, "Cannot write snapshot %s: %s\n", path, strerror(errno));
+        unlink(tmp);
+        return 0;
+    }
+    wal_sync_dir(path);
+    return 1;
+}
+
+// A section of count elements of the given size lies inside the file.
+int snap_section_ok(const Snapshot* snap, unsigned long long off, unsigned long long count, size_t size) {
+    return off % SNAPSHOT_ALIGN == 0 && off <= snap->size && count <= (snap->size - off) / size;
+}
+
+int snap_tree_ok(const Snapshot* snap, const SnapTree* t, unsigned records) {
+    if (t->n == 0) return t->num_levels == 0;
+    if (t->num_levels < 1 || t->num_levels > SNAPSHOT_MAX_LEVELS) return 0;
+    if ((unsigned long long)t->base + t->n > records || t->level_len[0] != t->n) return 0;
+    for (unsigned l = 0; l < t->num_levels; l++) {
+        if (!snap_section_ok(snap, t->level_off[l], t->level_len[l], sizeof(int))) return 0;
+        unsigned above = (t->level_len[l] + SNAPSHOT_FANOUT - 1) / SNAPSHOT_FANOUT;
+        if (l + 1 < t->num_levels ? t->level_len[l + 1] != above : t->level_len[l] > SNAPSHOT_FANOUT) return 0;
+    }
+    return 1;
+}
+
+// Every offset in the image stays inside the mapping, so lookups need no
+// further checks. The body checksum is optional because it reads the whole file.
+int snapshot_check(const Snapshot* snap, int verify) {
+    SnapHeader h = *snap->header;
+    h.header_crc = 0;
+    if (crc32c_update(0, &h, sizeof(h)) != snap->header->header_crc) return 0;
+    h = *snap->header;
+    if (h.version != SNAPSHOT_VERSION || h.fanout != SNAPSHOT_FANOUT || h.file_size != snap->size ||
+        h.car_size != sizeof(SnapCar) || h.sale_size != sizeof(Sale) ||
+        h.salesperson_size != sizeof(SnapSalesperson))
+        return 0;
+    if (!snap_section_ok(snap, h.showrooms_off, h.num_showrooms, sizeof(SnapShowroom))) return 0;
+
+    for (int d = 0; d < SNAPSHOT_DICTS; d++) {
+        const SnapDict* sd = &h.dicts[d];
+        if (!snap_section_ok(snap, sd->off, sd->bytes, 1) || sd->count > CAR_MAX_DICT_ID + 1 ||
+            (unsigned long long)sd->count * sizeof(unsigned) > sd->bytes)
+            return 0;
+        const unsigned* offs = (const unsigned*)(snap->data + sd->off);
+        if (sd->count > 0 && snap->data[sd->off + sd->bytes - 1] != '\0') return 0;
+        for (unsigned id = 0; id < sd->count; id++)
+            if (offs[id] < sd->count * sizeof(unsigned) || offs[id] >= sd->bytes) return 0;
+    }
+
+    const SnapShowroom* table = (const SnapShowroom*)(snap->data + h.showrooms_off);
+    for (unsigned i = 0; i < h.num_showrooms; i++) {
+        const SnapShowroom* s = &table[i];
+        unsigned long long cars = (unsigned long long)s->num_available + s->num_sold;
+        if (!snap_section_ok(snap, s->cars_off, cars, sizeof(SnapCar)) ||
+            !snap_section_ok(snap, s->sales_off, s->num_sold, sizeof(Sale)) ||
+            !snap_section_ok(snap, s->salespersons_off, s->num_salespersons, sizeof(SnapSalesperson)) ||
+            !snap_section_ok(snap, s->sold_by_off, s->num_sold, sizeof(unsigned)))
+            return 0;
+        if (s->available.base != 0 || s->available.n != s->num_available || s->sold.base != s->num_available ||
+            s->sold.n != s->num_sold || s->by_id.n != s->num_salespersons)
+            return 0;
+        if (!snap_tree_ok(snap, &s->available, cars) || !snap_tree_ok(snap, &s->sold, cars) ||
+            !snap_tree_ok(snap, &s->by_id, s->num_salespersons))
+            return 0;
+    }
+
+    if (verify) {
+        madvise((void*)snap->data, snap->size, MADV_SEQUENTIAL);
+        unsigned crc = crc32c_update(0, snap->data + SNAPSHOT_HEADER_BYTES, snap->size - SNAPSHOT_HEADER_BYTES);
+        madvise((void*)snap->data, snap->size, MADV_NORMAL);
+        if (crc != h.body_crc) return 0;
+    }
+    return 1;
+}
+
+// Maps a snapshot read-only. Nothing is copied: lookups read the page
+// cache directly. With verify set the whole body is checksummed first.
+Snapshot* snapshot_open(const char* path, int verify) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Cannot open snapshot %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < SNAPSHOT_HEADER_BYTES) {
+        printf("%s is not a showroom snapshot.\n", path);
+        close(fd);
+        return NULL;
+    }
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Cannot map snapshot %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    Snapshot* snap = (Snapshot*)calloc(1, sizeof(Snapshot));
+    if (!snap) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    snprintf(snap->path, SNAPSHOT_PATH_LEN, "%s", path);
+    snap->data = (const char*)data;
+    snap->size = st.st_size;
+    snap->header = (const SnapHeader*)data;
+    if (memcmp(snap->header->magic, SNAPSHOT_MAGIC, 8) != 0 || !snapshot_check(snap, verify)) {
+        printf("%s is not a showroom snapshot or is damaged.\n", path);
+        snapshot_close(snap);
+        return NULL;
+    }
+    snap->showrooms = (const SnapShowroom*)(snap->data + snap->header->showrooms_off);
+    return snap;
+}
+
+void snapshot_close(Snapshot* snap) {
+    if (!snap) return;
+    munmap((void*)snap->data, snap->size);
+    free(snap);
+}
+
+const SnapShowroom* snapshot_showroom(const Snapshot* snap, int showroom_id) {
+    for (unsigned i = 0; i < snap->header->num_showrooms; i++)
+        if (snap->showrooms[i].showroom_id == showroom_id) return &snap->showrooms[i];
+    return NULL;
+}
+
+// Same descent as bptree_search, but over implicit nodes: block b of a
+// level is keys [b * FANOUT, (b + 1) * FANOUT), and the rank found in it
+// names the block to take one level down. Returns the record index or -1.
+long snap_tree_find(const Snapshot* snap, const SnapTree* t, int key) {
+    if (t->n == 0) return -1;
+    unsigned block = 0;
+    for (int l = t->num_levels - 1; l >= 0; l--) {
+        const int* keys = (const int*)(snap->data + t->level_off[l]) + (size_t)block * SNAPSHOT_FANOUT;
+        unsigned m = t->level_len[l] - block * SNAPSHOT_FANOUT;
+        if (m > SNAPSHOT_FANOUT) m = SNAPSHOT_FANOUT;
+        int r = bptree_rank(keys, m, key);
+        if (r == 0) return -1;
+        unsigned idx = block * SNAPSHOT_FANOUT + r - 1;
+        if (l == 0) return keys[r - 1] == key ? (long)t->base + idx : -1;
+        block = idx;
+    }
+    return -1;
+}
+
+// Finds a car in stock or sold, straight from the mapping.
+const SnapCar* snapshot_find_car(const Snapshot* snap, const SnapShowroom* s, int vin) {
+    const SnapCar* cars = (const SnapCar*)(snap->data + s->cars_off);
+    long i = snap_tree_find(snap, &s->available, vin);
+    if (i < 0) i = snap_tree_find(snap, &s->sold, vin);
+    return i < 0 ? NULL : &cars[i];
+}
+
+const Sale* snapshot_car_sale(const Snapshot* snap, const SnapShowroom* s, const SnapCar* car) {
+    if (car->sale >= s->num_sold) return NULL;
+    return (const Sale*)(snap->data + s->sales_off) + car->sale;
+}
+
+const SnapSalesperson* snapshot_find_salesperson(const Snapshot* snap, const SnapShowroom* s, int id) {
+    long i = snap_tree_find(snap, &s->by_id, id);
+    return i < 0 ? NULL : (const SnapSalesperson*)(snap->data + s->salespersons_off) + i;
+}
+
+// dict is the section number: 0 models, 1 colors, 2 fuels, 3 types.
+const char* snapshot_dict_name(const Snapshot* snap, int dict, int id) {
+    const SnapDict* sd = &snap->header->dicts[dict];
+    if (id < 0 || (unsigned)id >= sd->count) return "?";
+    const unsigned* offs = (const unsigned*)(snap->data + sd->off);
+    return snap->data + sd->off + offs[id];
+}
+
+//  One showroom's restore task
+typedef struct SnapRestore {
+    const Snapshot* snap;
+    const SnapShowroom* ss;
+    Showroom* showroom;
+    unsigned short* remap[SNAPSHOT_DICTS];  // snapshot dictionary id -> process id
+} SnapRestore;
+
+void snapshot_corrupt(const Snapshot* snap) {
+    printf("Snapshot %s is damaged.\n", snap->path);
+    exit(1);
+}
+
+unsigned short snap_dict_id(const Snapshot* snap, const unsigned short* remap, int dict, unsigned short id) {
+    if (id >= snap->header->dicts[dict].count) snapshot_corrupt(snap);
+    return remap[id];
+}
+
+// Rebuilds one showroom's trees. Keys come out of the image already
+// sorted, so every tree is a bulk load; indexes are built on first use and
+// the sales time series is backfilled from sold_stock.
+void snapshot_restore_showroom(void* arg) {
+    SnapRestore* r = (SnapRestore*)arg;
+    const Snapshot* snap = r->snap;
+    const SnapShowroom* ss = r->ss;
+    Showroom* s = r->showroom;
+    unsigned total = ss->num_available + ss->num_sold;
+
+    const SnapCar* src = (const SnapCar*)(snap->data + ss->cars_off);
+    const Sale* sales = (const Sale*)(snap->data + ss->sales_off);
+    unsigned most = total > ss->num_salespersons ? total : ss->num_salespersons;
+    int* keys = (int*)malloc((most ? most : 1) * sizeof(int));
+    void** cars = (void**)malloc((total ? total : 1) * sizeof(void*));
+    void** sps = (void**)malloc((ss->num_salespersons ? ss->num_salespersons : 1) * sizeof(void*));
+    if (!keys || !cars || !sps) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+
+    for (unsigned i = 0; i < total; i++) {
+        Car* car = (Car*)arena_alloc(s->arena, sizeof(Car));
+        car->vin = src[i].vin;
+        car->price = src[i].price;
+        car->model = snap_dict_id(snap, r->remap[0], 0, src[i].model);
+        car->color = snap_dict_id(snap, r->remap[1], 1, src[i].color);
+        car->fuel = snap_dict_id(snap, r->remap[2], 2, src[i].fuel);
+        car->type = snap_dict_id(snap, r->remap[3], 3, src[i].type);
+        car->sale = NULL;
+        if (i >= ss->num_available) {
+            if (src[i].sale != i - ss->num_available) snapshot_corrupt(snap);
+            car->sale = (Sale*)arena_alloc(s->arena, sizeof(Sale));
+            *car->sale = sales[src[i].sale];
+        }
+        keys[i] = car->vin;
+        cars[i] = car;
+    }
+    bptree_bulk_load(&s->available_stock, keys, cars, ss->num_available, bptree_bulk_fill);
+    bptree_bulk_load(&s->sold_stock, keys + ss->num_available, cars + ss->num_available, ss->num_sold,
+                     bptree_bulk_fill);
+
+    const SnapSalesperson* src_sp = (const SnapSalesperson*)(snap->data + ss->salespersons_off);
+    const unsigned* sold_by = (const unsigned*)(snap->data + ss->sold_by_off);
+    int* vins = (int*)malloc((ss->num_sold ? ss->num_sold : 1) * sizeof(int));
+    void** sold = (void**)malloc((ss->num_sold ? ss->num_sold : 1) * sizeof(void*));
+    if (!vins || !sold) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (unsigned i = 0; i < ss->num_salespersons; i++) {
+        const SnapSalesperson* p = &src_sp[i];
+        if ((unsigned long long)p->sold_first + p->sold_count > ss->num_sold) snapshot_corrupt(snap);
+        Salesperson* sp = (Salesperson*)arena_alloc(s->arena, sizeof(Salesperson));
+        sp->id = p->id;
+        memcpy(sp->name, p->name, NAME_LEN);
+        sp->name[NAME_LEN - 1] = '\0';
+        sp->target = p->target;
+        sp->achieved = p->achieved;
+        sp->commission = p->commission;
+        sp->soldCarsRoot = create_bptree_meta(s->meta);
+        for (unsigned j = 0; j < p->sold_count; j++) {
+            unsigned idx = sold_by[p->sold_first + j];
+            if (idx < ss->num_available || idx >= total) snapshot_corrupt(snap);
+            vins[j] = ((Car*)cars[idx])->vin;
+            sold[j] = cars[idx];
+        }
+        bptree_bulk_load(&sp->soldCarsRoot, vins, sold, p->sold_count, bptree_bulk_fill);
+        leaderboard_add(&leaderboard, s->showroom_id, sp);
+        keys[i] = sp->id;
+        sps[i] = sp;
+    }
+    bptree_bulk_load(&s->salespersons, keys, sps, ss->num_salespersons, bptree_bulk_fill);
+    vindir_add_showroom(&vin_directory, s);
+    showroom_backfill_series(s);
+
+    free(keys);
+    free(cars);
+    free(sps);
+    free(vins);
+    free(sold);
+}
+
+// Fills showrooms[i] (freshly initialised with snap->showrooms[i].showroom_id)
+// from the image, one showroom per pool task (threads <= 0: one per CPU).
+// The snapshot can be closed afterwards.
+void snapshot_restore(const Snapshot* snap, Showroom* showrooms, int threads) {
+    int count = snap->header->num_showrooms;
+    if (count <= 0) return;
+    Dict* dicts[SNAPSHOT_DICTS] = { &car_models, &car_colors, &car_fuels, &car_types };
+    unsigned short* remap[SNAPSHOT_DICTS];
+    for (int d = 0; d < SNAPSHOT_DICTS; d++) {
+        unsigned n = snap->header->dicts[d].count;
+        remap[d] = (unsigned short*)malloc((n ? n : 1) * sizeof(unsigned short));
+        if (!remap[d]) {
+            printf("Memory allocation failed!\n");
+            exit(1);
+        }
+        for (unsigned id = 0; id < n; id++) {
+            const char* name = snapshot_dict_name(snap, d, id);
+            int mapped = dict_intern(dicts[d], name, strlen(name));
+            if (mapped > CAR_MAX_DICT_ID) snapshot_corrupt(snap);
+            remap[d][id] = mapped;
+        }
+    }
+
+    SnapRestore* tasks = (SnapRestore*)calloc(count, sizeof(SnapRestore));
+    if (!tasks) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    bptree_rank_name();
+    ThreadPool* pool = threadpool_create(threads);
+    for (int i = 0; i < count; i++) {
+        tasks[i].snap = snap;
+        tasks[i].ss = &snap->showrooms[i];
+        tasks[i].showroom = &showrooms[i];
+        memcpy(tasks[i].remap, remap, sizeof(remap));
+        threadpool_submit(pool, snapshot_restore_showroom, &tasks[i]);
+    }
+    threadpool_wait(pool);
+    threadpool_destroy(pool);
+
+    free(tasks);
+    for (int d = 0; d < SNAPSHOT_DICTS; d++)
+        free(remap[d]);
+}
@@ -0,0 +1,118 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "bptree.h"
+
+#define SNAPSHOT_MAGIC "SRSNAP01"       // 8 bytes at the start of the file
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_DEFAULT_PATH "showroom.snap"
+#define SNAPSHOT_PATH_LEN 256
+#define SNAPSHOT_FANOUT 32              // keys per search block: two cache lines
+#define SNAPSHOT_MAX_LEVELS 8           // 32^7 blocks outgrow any int key count
+#define SNAPSHOT_ALIGN 64               // every section starts on a cache line
+#define SNAPSHOT_DICTS 4                // models, colors, fuels, types
+#define SNAPSHOT_NO_SALE 0xFFFFFFFFu
+
+//  A snapshot is one file of fixed-layout sections addressed by byte
+//  offsets from the start of the file, so a mapped image is usable in place:
+//
+//    SnapHeader | dictionaries | per showroom: cars, sales, salespersons,
+//    sold-by lists, search levels of its three trees | SnapShowroom table
+//
+//  Everything after the header is covered by body_crc (CRC-32C).
+
+//  Static search tree over a sorted key array. levels[0] holds every key;
+//  each level above holds the first key of every SNAPSHOT_FANOUT-key block
+//  of the level below, up to a top level of at most one block. Key i of
+//  level 0 belongs to record base + i of the section it indexes.
+typedef struct SnapTree {
+    unsigned n;
+    unsigned base;
+    unsigned num_levels;
+    unsigned level_len[SNAPSHOT_MAX_LEVELS];
+    unsigned long long level_off[SNAPSHOT_MAX_LEVELS]; // int[level_len]
+} SnapTree;
+
+//  Car record; sale indexes the showroom's Sale section
+typedef struct SnapCar {
+    int vin;
+    float price;
+    unsigned short model, color, fuel, type; // ids in the snapshot's dictionaries
+    unsigned sale;                           // SNAPSHOT_NO_SALE while in stock
+} SnapCar;
+
+//  Salesperson record; sold_first..+sold_count index the sold-by section,
+//  whose entries are car indexes in VIN order
+typedef struct SnapSalesperson {
+    int id;
+    char name[NAME_LEN];
+    float target;
+    float achieved;
+    float commission;
+    unsigned sold_first;
+    unsigned sold_count;
+} SnapSalesperson;
+
+//  One showroom. Cars are available cars then sold cars, each in VIN order.
+typedef struct SnapShowroom {
+    int showroom_id;
+    unsigned num_available;
+    unsigned num_sold;
+    unsigned num_salespersons;
+    unsigned long long cars_off;             // SnapCar[num_available + num_sold]
+    unsigned long long sales_off;            // Sale[num_sold]
+    unsigned long long salespersons_off;     // SnapSalesperson[num_salespersons]
+    unsigned long long sold_by_off;          // unsigned[num_sold]
+    SnapTree available;                      // VINs -> cars[0..]
+    SnapTree sold;                           // VINs -> cars[num_available..]
+    SnapTree by_id;                          // ids -> salespersons
+} SnapShowroom;
+
+//  Dictionary section: offsets[count] relative to the section, then the
+//  NUL-terminated names
+typedef struct SnapDict {
+    unsigned long long off;
+    unsigned count;
+    unsigned bytes;
+} SnapDict;
+
+//  File header
+typedef struct SnapHeader {
+    char magic[8];
+    unsigned version;
+    unsigned header_crc;         // CRC-32C of the header with this field zeroed
+    unsigned long long file_size;
+    unsigned body_crc;           // CRC-32C of every byte after the header
+    unsigned fanout;
+    unsigned car_size, sale_size, salesperson_size; // reject foreign layouts
+    unsigned num_showrooms;
+    unsigned long long showrooms_off;        // SnapShowroom[num_showrooms]
+    SnapDict dicts[SNAPSHOT_DICTS];
+} SnapHeader;
+
+#define SNAPSHOT_HEADER_BYTES ((sizeof(SnapHeader) + SNAPSHOT_ALIGN - 1) & ~(size_t)(SNAPSHOT_ALIGN - 1))
+
+//  Read-only mapping of a snapshot file
+typedef struct Snapshot {
+    char path[SNAPSHOT_PATH_LEN];
+    const char* data;
+    size_t size;
+    const SnapHeader* header;
+    const SnapShowroom* showrooms;
+} Snapshot;
+
+unsigned crc32c_update(unsigned crc, const void* data, size_t len);
+
+int snapshot_write(const char* path, Showroom* showrooms, int count);
+Snapshot* snapshot_open(const char* path, int verify);
+void snapshot_close(Snapshot* snap);
+
+const SnapShowroom* snapshot_showroom(const Snapshot* snap, int showroom_id);
+const SnapCar* snapshot_find_car(const Snapshot* snap, const SnapShowroom* s, int vin);
+const Sale* snapshot_car_sale(const Snapshot* snap, const SnapShowroom* s, const SnapCar* car);
+const SnapSalesperson* snapshot_find_salesperson(const Snapshot* snap, const SnapShowroom* s, int id);
+const char* snapshot_dict_name(const Snapshot* snap, int dict, int id);
+
+void snapshot_restore(const Snapshot* snap, Showroom* showrooms, int threads);
+
+#endif
@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "threadpool.h"
+
+// One worker per online CPU.
+int threadpool_default_threads() {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+void* threadpool_worker(void* arg) {
+    ThreadPool* pool = (ThreadPool*)arg;
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (!pool->head && !pool->shutdown)
+            pthread_cond_wait(&pool->work, &pool->lock);
+        if (!pool->head) break;
+
+        ThreadTask* task = pool->head;
+        pool->head = task->next;
+        if (!pool->head) pool->tail = NULL;
+        pthread_mutex_unlock(&pool->lock);
+
+        task->fn(task->arg);
+        free(task);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0)
+            pthread_cond_broadcast(&pool->idle);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// num_threads <= 0 picks threadpool_default_threads(). With one thread the
+// tasks run in submission order.
+ThreadPool* threadpool_create(int num_threads) {
+    if (num_threads <= 0) num_threads = threadpool_default_threads();
+    ThreadPool* pool = (ThreadPool*)malloc(sizeof(ThreadPool));
+    pthread_t* threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+    if (!pool || !threads) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    pool->threads = threads;
+    pool->num_threads = 0;
+    pool->head = pool->tail = NULL;
+    pool->pending = 0;
+    pool->shutdown = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    for (int i = 0; i < num_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, threadpool_worker, pool) != 0) break;
+        pool->num_threads++;
+    }
+    if (pool->num_threads == 0) {
+        printf("Could not start worker threads!\n");
+        exit(1);
+    }
+    return pool;
+}
+
+void threadpool_submit(ThreadPool* pool, ThreadTaskFn fn, void* arg) {
+    ThreadTask* task = (ThreadTask*)malloc(sizeof(ThreadTask));
+    if (!task) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    task->fn = fn;
+    task->arg = arg;
+    task->next = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->tail) pool->tail->next = task;
+    else pool->head = task;
+    pool->tail = task;
+    pool->pending++;
+    pthread_cond_signal(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Blocks until every submitted task has finished. Must not be called from
+// inside a task.
+void threadpool_wait(ThreadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0)
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Finishes the queued tasks, then joins the workers.
+void threadpool_destroy(ThreadPool* pool) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->num_threads; i++)
+        pthread_join(pool->threads[i], NULL);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->idle);
+    free(pool->threads);
+    free(pool);
+}
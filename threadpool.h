@@ -0,0 +1,34 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+
+typedef void (*ThreadTaskFn)(void* arg);
+
+//  Queued unit of work
+typedef struct ThreadTask {
+    ThreadTaskFn fn;
+    void* arg;
+    struct ThreadTask* next;
+} ThreadTask;
+
+//  Fixed set of worker threads draining one FIFO queue
+typedef struct ThreadPool {
+    pthread_t* threads;
+    int num_threads;
+    ThreadTask* head;
+    ThreadTask* tail;
+    int pending;                // queued + running tasks
+    int shutdown;
+    pthread_mutex_t lock;
+    pthread_cond_t work;        // signalled when a task is queued
+    pthread_cond_t idle;        // signalled when pending drops to 0
+} ThreadPool;
+
+int threadpool_default_threads();
+ThreadPool* threadpool_create(int num_threads);
+void threadpool_submit(ThreadPool* pool, ThreadTaskFn fn, void* arg);
+void threadpool_wait(ThreadPool* pool);
+void threadpool_destroy(ThreadPool* pool);
+
+#endif
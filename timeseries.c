@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "timeseries.h"
+
+// Days from 1-1-0000 in the proleptic Gregorian calendar.
+int ts_civil_days(int year, int month, int day) {
+    static const int before[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+    int y = year - (month <= 2);
+    return year * 365 + y / 4 - y / 100 + y / 400 + before[month - 1] + day - 1;
+}
+
+int ts_days_in_month(int year, int month) {
+    static const int days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    int leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return days[month - 1] + (month == 2 && leap);
+}
+
+// Month number of a ddmmyyyy date, -1 if the month or year is out of range.
+int ts_month_number(int ddmmyyyy) {
+    int month = (ddmmyyyy / 10000) % 100;
+    int year = ddmmyyyy % 10000;
+    if (month < 1 || month > 12 || year < TS_MIN_YEAR || year > TS_MAX_YEAR) return -1;
+    return year * 12 + month - 1;
+}
+
+// Day number of a ddmmyyyy date, -1 if it is not a calendar date.
+int ts_day_number(int ddmmyyyy) {
+    int day = ddmmyyyy / 1000000;
+    int month = (ddmmyyyy / 10000) % 100;
+    int year = ddmmyyyy % 10000;
+    if (ts_month_number(ddmmyyyy) < 0 || day < 1 || day > ts_days_in_month(year, month)) return -1;
+    return ts_civil_days(year, month, day) - ts_civil_days(TS_MIN_YEAR, 1, 1);
+}
+
+// Bucket of a period, growing the run to cover it. Growth at least doubles
+// the run and leaves the slack on the side it grew towards.
+SalesBucket* run_slot(SalesRun* r, int period) {
+    if (r->n == 0) r->first = period;
+    if (period < r->first || period >= r->first + r->n) {
+        int lo = period < r->first ? period : r->first;
+        int hi = period >= r->first + r->n ? period + 1 : r->first + r->n;
+        int n = r->n * 2 > hi - lo ? r->n * 2 : hi - lo;
+        if (n < 32) n = 32;
+        int first = period < r->first ? hi - n : lo;
+        SalesBucket* b = (SalesBucket*)calloc(n, sizeof(SalesBucket));
+        if (!b) {
+            printf("Memory allocation failed!\n");
+            exit(1);
+        }
+        if (r->n) memcpy(b + (r->first - first), r->buckets, r->n * sizeof(SalesBucket));
+        free(r->buckets);
+        r->buckets = b;
+        r->first = first;
+        r->n = n;
+    }
+    return &r->buckets[period - r->first];
+}
+
+// Adds the buckets of periods last - n + 1 .. last to out, oldest first.
+void run_sum(const SalesRun* r, int last, int n, SalesBucket* out) {
+    for (int i = 0; i < n; i++) {
+        int p = last - n + 1 + i - r->first;
+        if (p < 0 || p >= r->n) continue;
+        out[i].count += r->buckets[p].count;
+        out[i].revenue += r->buckets[p].revenue;
+    }
+}
+
+SalesSeries* timeseries_create() {
+    SalesSeries* ts = (SalesSeries*)calloc(1, sizeof(SalesSeries));
+    if (!ts) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    pthread_mutex_init(&ts->lock, NULL);
+    return ts;
+}
+
+void timeseries_free(SalesSeries* ts) {
+    if (!ts) return;
+    free(ts->days.buckets);
+    free(ts->months.buckets);
+    for (int i = 0; i < ts->num_models; i++)
+        free(ts->models[i].buckets);
+    free(ts->models);
+    pthread_mutex_destroy(&ts->lock);
+    free(ts);
+}
+
+// Records one sale; O(1) apart from the occasional run growth.
+void timeseries_add(SalesSeries* ts, int ddmmyyyy, int model, float price) {
+    int month = ts_month_number(ddmmyyyy);
+    if (month < 0) return;
+    int day = ts_day_number(ddmmyyyy);
+
+    pthread_mutex_lock(&ts->lock);
+    SalesBucket* b = run_slot(&ts->months, month);
+    b->count++;
+    b->revenue += price;
+    if (day >= 0) {
+        b = run_slot(&ts->days, day);
+        b->count++;
+        b->revenue += price;
+    }
+    if (model >= ts->num_models) {
+        int n = model + 1 > ts->num_models * 2 ? model + 1 : ts->num_models * 2;
+        ts->models = (SalesRun*)realloc(ts->models, n * sizeof(SalesRun));
+        if (!ts->models) {
+            printf("Memory allocation failed!\n");
+            exit(1);
+        }
+        memset(ts->models + ts->num_models, 0, (n - ts->num_models) * sizeof(SalesRun));
+        ts->num_models = n;
+    }
+    b = run_slot(&ts->models[model], month);
+    b->count++;
+    b->revenue += price;
+    pthread_mutex_unlock(&ts->lock);
+}
+
+// Rebuilds the series from sold_stock in one pass, for showrooms whose
+// sold cars were loaded without going through showroom_sell_car.
+void showroom_backfill_series(Showroom* s) {
+    timeseries_free(s->series);
+    s->series = timeseries_create();
+    BPTreeCursor cur;
+    void* data;
+    bptree_cursor_first(&cur, s->sold_stock);
+    while (bptree_cursor_next(&cur, NULL, &data)) {
+        Car* car = (Car*)data;
+        timeseries_add(s->series, car->sale->d_o_prchse, car->model, car->price);
+    }
+}
+
+// Daily totals of all showrooms for days last_day - n + 1 .. last_day,
+// oldest first; O(n) per showroom.
+void timeseries_days(Showroom* showrooms, int count, int last_day, int n, SalesBucket* out) {
+    memset(out, 0, n * sizeof(SalesBucket));
+    for (int i = 0; i < count; i++) {
+        SalesSeries* ts = showrooms[i].series;
+        if (!ts) continue;
+        pthread_mutex_lock(&ts->lock);
+        run_sum(&ts->days, last_day, n, out);
+        pthread_mutex_unlock(&ts->lock);
+    }
+}
+
+// Monthly totals of all showrooms, as timeseries_days.
+void timeseries_months(Showroom* showrooms, int count, int last_month, int n, SalesBucket* out) {
+    memset(out, 0, n * sizeof(SalesBucket));
+    for (int i = 0; i < count; i++) {
+        SalesSeries* ts = showrooms[i].series;
+        if (!ts) continue;
+        pthread_mutex_lock(&ts->lock);
+        run_sum(&ts->months, last_month, n, out);
+        pthread_mutex_unlock(&ts->lock);
+    }
+}
+
+// Monthly totals of one car model (car_models id) across all showrooms.
+void timeseries_model_months(Showroom* showrooms, int count, int model, int last_month, int n, SalesBucket* out) {
+    memset(out, 0, n * sizeof(SalesBucket));
+    for (int i = 0; i < count; i++) {
+        SalesSeries* ts = showrooms[i].series;
+        if (!ts) continue;
+        pthread_mutex_lock(&ts->lock);
+        if (model < ts->num_models) run_sum(&ts->models[model], last_month, n, out);
+        pthread_mutex_unlock(&ts->lock);
+    }
+}
+
+// Mean sales count of the k buckets ending at b[n - 1].
+double timeseries_moving_average(const SalesBucket* b, int n, int k) {
+    if (k > n) k = n;
+    if (k <= 0) return 0.0;
+    long sum = 0;
+    for (int i = n - k; i < n; i++)
+        sum += b[i].count;
+    return (double)sum / k;
+}
+
+// The last `months` months up to today's, with the change against the same
+// month a year earlier and a TS_TREND_AVERAGE-month moving average.
+void print_sales_trend(Showroom* showrooms, int count, int today_date, int months) {
+    int last = ts_month_number(today_date);
+    if (last < 0 || months <= 0) {
+        report_message(&report, "Invalid option.\n");
+        return;
+    }
+    int n = months + 12;
+    SalesBucket* b = (SalesBucket*)malloc(n * sizeof(SalesBucket));
+    if (!b) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    timeseries_months(showrooms, count, last, n, b);
+
+    char average[32], label[32], change[32];
+    snprintf(average, sizeof(average), "%d-month average", TS_TREND_AVERAGE);
+    for (int i = 12; i < n; i++) {
+        int month = last - n + 1 + i;
+        if (b[i - 12].count)
+            snprintf(change, sizeof(change), "%+.1f%%", 100.0 * (b[i].count - b[i - 12].count) / b[i - 12].count);
+        else
+            snprintf(change, sizeof(change), "n/a");
+        report_begin(&report, 0);
+        snprintf(label, sizeof(label), "%d-%d", month % 12 + 1, month / 12);
+        report_str(&report, "Month", NULL, label);
+        snprintf(label, sizeof(label), "%04d-%02d", month / 12, month % 12 + 1);
+        report_str(&report, NULL, "month", label);
+        report_int(&report, "Sales", "sales", b[i].count);
+        report_money(&report, "Revenue", "revenue", b[i].revenue);
+        report_str(&report, "Year over year", "year_over_year", change);
+        report_money(&report, average, "moving_average", timeseries_moving_average(b, i + 1, TS_TREND_AVERAGE));
+        report_end(&report);
+    }
+    free(b);
+}
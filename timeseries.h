@@ -0,0 +1,51 @@
+#ifndef TIMESERIES_H
+#define TIMESERIES_H
+
+#include <pthread.h>
+#include "bptree.h"
+
+#define TS_MIN_YEAR 1900               // sales dated outside these years are not bucketed
+#define TS_MAX_YEAR 2199
+#define TS_TREND_AVERAGE 3             // months in the trend's moving average
+
+//  Sales of one day or month
+typedef struct SalesBucket {
+    long count;
+    double revenue;             // sum of car prices
+} SalesBucket;
+
+//  Buckets for a contiguous run of periods, grown at either end as sales
+//  with earlier or later dates arrive
+typedef struct SalesRun {
+    SalesBucket* buckets;
+    int first;                  // period of buckets[0]
+    int n;                      // periods covered
+} SalesRun;
+
+//  Per-showroom sales time series. Periods are day numbers (days since
+//  1-1-TS_MIN_YEAR) and month numbers (year * 12 + month - 1), so windows
+//  that cross a year end need no special casing.
+typedef struct SalesSeries {
+    SalesRun days;
+    SalesRun months;
+    SalesRun* models;           // monthly, indexed by car_models id
+    int num_models;
+    pthread_mutex_t lock;       // serializes concurrent sales
+} SalesSeries;
+
+int ts_day_number(int ddmmyyyy);
+int ts_month_number(int ddmmyyyy);
+
+SalesSeries* timeseries_create();
+void timeseries_free(SalesSeries* ts);
+void timeseries_add(SalesSeries* ts, int ddmmyyyy, int model, float price);
+void showroom_backfill_series(Showroom* s);
+
+void timeseries_days(Showroom* showrooms, int count, int last_day, int n, SalesBucket* out);
+void timeseries_months(Showroom* showrooms, int count, int last_month, int n, SalesBucket* out);
+void timeseries_model_months(Showroom* showrooms, int count, int model, int last_month, int n, SalesBucket* out);
+double timeseries_moving_average(const SalesBucket* b, int n, int k);
+
+void print_sales_trend(Showroom* showrooms, int count, int today_date, int months);
+
+#endif
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "vindir.h"
+
+VinDirectory vin_directory = VINDIR_INIT;
+
+long vindir_slot(int vin, long num_slots) {
+    return (long)(((unsigned)vin * 2654435761u) & (num_slots - 1));
+}
+
+// Caller holds the write lock. A VIN stocked by two showrooms keeps the
+// entry of the lower showroom id, whatever order the loaders finish in.
+void vindir_put(VinDirectory* d, int vin, Showroom* s, Car* car) {
+    long h = vindir_slot(vin, d->num_slots);
+    while (d->slots[h].car) {
+        VinEntry* e = &d->slots[h];
+        if (e->vin == vin) {
+            if (s->showroom_id < e->showroom->showroom_id) {
+                e->showroom = s;
+                e->car = car;
+            }
+            return;
+        }
+        h = (h + 1) & (d->num_slots - 1);
+    }
+    d->slots[h].vin = vin;
+    d->slots[h].showroom = s;
+    d->slots[h].car = car;
+    d->count++;
+}
+
+// Caller holds the write lock. Rebuilds the table with room for `want`
+// entries at a load factor of at most 1/2, dropping entries of `skip`.
+void vindir_rehash(VinDirectory* d, long want, Showroom* skip) {
+    long num_slots = VINDIR_MIN_SLOTS;
+    while (num_slots < want * 2) num_slots *= 2;
+    VinEntry* old = d->slots;
+    long old_slots = d->num_slots;
+
+    d->slots = (VinEntry*)calloc(num_slots, sizeof(VinEntry));
+    if (!d->slots) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    d->num_slots = num_slots;
+    d->count = 0;
+    for (long i = 0; i < old_slots; i++)
+        if (old[i].car && old[i].showroom != skip) vindir_put(d, old[i].vin, old[i].showroom, old[i].car);
+    free(old);
+}
+
+void vindir_add_tree(VinDirectory* d, Showroom* s, BPTreeNode* root) {
+    BPTreeCursor cur;
+    int vin;
+    void* data;
+    bptree_cursor_first(&cur, root);
+    while (bptree_cursor_next(&cur, &vin, &data))
+        vindir_put(d, vin, s, (Car*)data);
+}
+
+// Registers every car of a freshly loaded showroom in one write-locked pass.
+void vindir_add_showroom(VinDirectory* d, Showroom* s) {
+    long n = 0;
+    BPTreeCursor cur;
+    bptree_cursor_first(&cur, s->available_stock);
+    while (bptree_cursor_next(&cur, NULL, NULL)) n++;
+    bptree_cursor_first(&cur, s->sold_stock);
+    while (bptree_cursor_next(&cur, NULL, NULL)) n++;
+
+    pthread_rwlock_wrlock(&d->lock);
+    if ((d->count + n) * 2 > d->num_slots) vindir_rehash(d, d->count + n, NULL);
+    vindir_add_tree(d, s, s->available_stock);
+    vindir_add_tree(d, s, s->sold_stock);
+    pthread_rwlock_unlock(&d->lock);
+}
+
+// Forgets a showroom before it is destroyed. Linear probing cannot simply
+// clear slots, so the table is rebuilt without it.
+void vindir_remove_showroom(VinDirectory* d, Showroom* s) {
+    pthread_rwlock_wrlock(&d->lock);
+    for (long i = 0; i < d->num_slots; i++) {
+        if (d->slots[i].car && d->slots[i].showroom == s) {
+            vindir_rehash(d, d->count, s);
+            break;
+        }
+    }
+    pthread_rwlock_unlock(&d->lock);
+}
+
+// Caller holds the read lock.
+int vindir_find(VinDirectory* d, int vin, VinLookup* out) {
+    out->showroom = NULL;
+    out->car = NULL;
+    out->sold = 0;
+    if (d->num_slots == 0) return 0;
+    long h = vindir_slot(vin, d->num_slots);
+    while (d->slots[h].car) {
+        if (d->slots[h].vin == vin) {
+            out->showroom = d->slots[h].showroom;
+            out->car = d->slots[h].car;
+            out->sold = __atomic_load_n(&out->car->sale, __ATOMIC_ACQUIRE) != NULL;
+            return 1;
+        }
+        h = (h + 1) & (d->num_slots - 1);
+    }
+    return 0;
+}
+
+int vindir_lookup(VinDirectory* d, int vin, VinLookup* out) {
+    pthread_rwlock_rdlock(&d->lock);
+    int found = vindir_find(d, vin, out);
+    pthread_rwlock_unlock(&d->lock);
+    return found;
+}
+
+// Looks up n VINs under one read lock; returns how many were found. Slots
+// are prefetched a few VINs ahead, so the cache misses of neighbouring
+// lookups overlap instead of queueing up one by one.
+long vindir_lookup_batch(VinDirectory* d, const int* vins, long n, VinLookup* out) {
+    long found = 0;
+    pthread_rwlock_rdlock(&d->lock);
+    if (d->num_slots > 0) {
+        for (long i = 0; i < n && i < VINDIR_PREFETCH; i++)
+            __builtin_prefetch(&d->slots[vindir_slot(vins[i], d->num_slots)]);
+    }
+    for (long i = 0; i < n; i++) {
+        if (d->num_slots > 0 && i + VINDIR_PREFETCH < n)
+            __builtin_prefetch(&d->slots[vindir_slot(vins[i + VINDIR_PREFETCH], d->num_slots)]);
+        found += vindir_find(d, vins[i], &out[i]);
+    }
+    pthread_rwlock_unlock(&d->lock);
+    return found;
+}
+
+void vindir_free(VinDirectory* d) {
+    pthread_rwlock_wrlock(&d->lock);
+    free(d->slots);
+    d->slots = NULL;
+    d->num_slots = 0;
+    d->count = 0;
+    pthread_rwlock_unlock(&d->lock);
+}
+
+// A lookup as the menu shows it: the car, or a message if the VIN is unknown.
+void report_vin_lookup(Report* r, int vin, const VinLookup* l) {
+    if (!l->car) {
+        report_message(r, "Car with VIN %d not found.\n", vin);
+        return;
+    }
+
+    Car* car = l->car;
+    report_begin(r, 0);
+    report_int(r, "VIN", "vin", car->vin);
+    report_break(r, 0);
+    report_str(r, "Name", "name", car_name(car));
+    report_break(r, 0);
+    report_str(r, "Color", "color", car_color(car));
+    report_break(r, 0);
+    report_str(r, "Fuel", "fuel", car_fuel(car));
+    report_break(r, 0);
+    report_str(r, "Type", "type", car_type(car));
+    report_break(r, 0);
+    report_money(r, "Price", "price", car->price);
+    report_break(r, 0);
+    report_int(r, "Showroom", "showroom", l->showroom->showroom_id);
+    report_break(r, 0);
+    if (l->sold) {
+        int date = car->sale->d_o_prchse;
+        report_text(r, "Status: Sold to %s on %d-%d-%d", car->sale->cust_name, date / 1000000, (date / 10000) % 100, date % 10000);
+        report_str(r, NULL, "status", "Sold");
+        report_str(r, NULL, "sold_to", car->sale->cust_name);
+        report_date(r, NULL, "date", date);
+    } else {
+        report_str(r, "Status", "status", "In stock");
+    }
+    report_end(r);
+}
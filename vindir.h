@@ -0,0 +1,45 @@
+#ifndef VINDIR_H
+#define VINDIR_H
+
+#include <pthread.h>
+#include "bptree.h"
+
+#define VINDIR_MIN_SLOTS 1024          // power of two
+#define VINDIR_PREFETCH 16             // batch lookups prefetch this far ahead
+
+//  Directory slot; car == NULL marks an empty slot
+typedef struct VinEntry {
+    int vin;
+    Showroom* showroom;
+    Car* car;
+} VinEntry;
+
+//  Every car of every loaded showroom by VIN, in stock or sold. The Car
+//  record moves between trees on a sale but never in memory, so entries
+//  stay valid and the sale status is read from car->sale.
+typedef struct VinDirectory {
+    VinEntry* slots;            // open addressing, linear probing
+    long num_slots;
+    long count;
+    pthread_rwlock_t lock;      // loader threads write, terminals read
+} VinDirectory;
+
+#define VINDIR_INIT { NULL, 0, 0, PTHREAD_RWLOCK_INITIALIZER }
+
+//  Result of a lookup
+typedef struct VinLookup {
+    Showroom* showroom;         // NULL if the VIN is unknown
+    Car* car;
+    int sold;
+} VinLookup;
+
+void vindir_add_showroom(VinDirectory* d, Showroom* s);
+void vindir_remove_showroom(VinDirectory* d, Showroom* s);
+int vindir_lookup(VinDirectory* d, int vin, VinLookup* out);
+long vindir_lookup_batch(VinDirectory* d, const int* vins, long n, VinLookup* out);
+void report_vin_lookup(Report* r, int vin, const VinLookup* l);
+void vindir_free(VinDirectory* d);
+
+extern VinDirectory vin_directory;
+
+#endif
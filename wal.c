@@ -0,0 +1,453 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "wal.h"
+
+unsigned crc32_table[256];
+pthread_once_t crc32_once = PTHREAD_ONCE_INIT;
+
+void crc32_init() {
+    for (unsigned i = 0; i < 256; i++) {
+        unsigned c = i;
+        for (int k = 0; k < 8; k++)
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crc32_table[i] = c;
+    }
+}
+
+// Standard CRC-32 (as in zlib); pass 0 to start, the previous result to continue.
+unsigned crc32_update(unsigned crc, const void* data, size_t len) {
+    pthread_once(&crc32_once, crc32_init);
+    const unsigned char* p = (const unsigned char*)data;
+    crc = ~crc;
+    while (len--)
+        crc = crc32_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+unsigned wal_record_crc(const WalRecordHeader* h, const void* payload) {
+    unsigned crc = crc32_update(0, (const char*)h + sizeof(h->crc), sizeof(*h) - sizeof(h->crc));
+    return crc32_update(crc, payload, h->len);
+}
+
+void wal_write_all(int fd, const char* buf, size_t len, const char* path) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            printf("Log write to %s failed: %s\n", path, strerror(errno));
+            exit(1);
+        }
+        buf += n;
+        len -= n;
+    }
+}
+
+void wal_sync(int fd, const char* path) {
+    if (fdatasync(fd) != 0) {
+        printf("Log sync of %s failed: %s\n", path, strerror(errno));
+        exit(1);
+    }
+}
+
+// Makes a rename in the log's directory durable.
+void wal_sync_dir(const char* path) {
+    char dir[WAL_PATH_LEN];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char* slash = strrchr(dir, '/');
+    if (slash) *(slash == dir ? slash + 1 : slash) = '\0';
+    else strcpy(dir, ".");
+    int fd = open(dir, O_RDONLY);
+    if (fd < 0) return;
+    fsync(fd);
+    close(fd);
+}
+
+char* wal_alloc(size_t size) {
+    char* p = (char*)malloc(size);
+    if (!p) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    return p;
+}
+
+// Opens (or creates) the log. Call wal_replay before appending.
+Wal* wal_open(const char* path, Showroom* showrooms, int count) {
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        printf("Cannot open log %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    Wal* wal = (Wal*)calloc(1, sizeof(Wal));
+    if (!wal) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    wal->fd = fd;
+    snprintf(wal->path, WAL_PATH_LEN, "%s", path);
+    wal->showrooms = showrooms;
+    wal->count = count;
+    wal->group_commit = 1;
+    pthread_mutex_init(&wal->lock, NULL);
+    pthread_cond_init(&wal->flushed, NULL);
+    wal->cap = wal->flush_cap = WAL_BUFFER_SIZE;
+    wal->buf = wal_alloc(wal->cap);
+    wal->flush_buf = wal_alloc(wal->flush_cap);
+    wal->next_lsn = wal->durable_lsn = 1;
+
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size == 0) {
+        wal_write_all(fd, WAL_MAGIC, 8, path);
+        wal_sync(fd, path);
+        size = 8;
+    }
+    wal->file_bytes = size;
+    return wal;
+}
+
+Showroom* wal_showroom(Wal* wal, int id) {
+    for (int i = 0; i < wal->count; i++)
+        if (wal->showrooms[i].showroom_id == id) return &wal->showrooms[i];
+    return NULL;
+}
+
+// Re-applies one record; returns 0 if it no longer applies.
+int wal_apply(Wal* wal, const WalRecordHeader* h, const char* payload) {
+    Showroom* s = wal_showroom(wal, h->showroom);
+    if (!s) return 0;
+
+    if (h->type == WAL_SALE && h->len == sizeof(WalSale)) {
+        WalSale r;
+        memcpy(&r, payload, sizeof(r));
+        Salesperson* sp = get_salesperson(s->salespersons, r.salesperson_id);
+        return sp && showroom_sell_car(s, r.vin, sp, &r.sale) == SALE_OK;
+    }
+    if (h->type == WAL_SALESPERSON && h->len == sizeof(WalSalesperson)) {
+        WalSalesperson r;
+        memcpy(&r, payload, sizeof(r));
+        r.name[NAME_LEN - 1] = '\0';
+        if (get_salesperson(s->salespersons, r.id)) return 0;
+        showroom_add_salesperson(s, r.id, r.name, r.target);
+        return 1;
+    }
+    return 0;
+}
+
+// Walks the intact records of a mapped log, calling visit for each. Returns
+// the length of the intact prefix; anything after it is a torn write.
+size_t wal_scan(const char* data, size_t size, unsigned long long* max_lsn,
+                void (*visit)(const WalRecordHeader* h, const char* payload, size_t off, void* ctx), void* ctx) {
+    size_t off = 8;
+    while (size - off >= sizeof(WalRecordHeader)) {
+        WalRecordHeader h;
+        memcpy(&h, data + off, sizeof(h));
+        const char* payload = data + off + sizeof(h);
+        if (h.len > WAL_MAX_RECORD || size - off - sizeof(h) < h.len) break;
+        if (wal_record_crc(&h, payload) != h.crc) break;
+        if (h.lsn > *max_lsn) *max_lsn = h.lsn;
+        visit(&h, payload, off, ctx);
+        off += sizeof(h) + h.len;
+    }
+    return off;
+}
+
+typedef struct WalReplay {
+    Wal* wal;
+    int applied;
+} WalReplay;
+
+void wal_replay_record(const WalRecordHeader* h, const char* payload, size_t off, void* ctx) {
+    WalReplay* r = (WalReplay*)ctx;
+    r->applied += wal_apply(r->wal, h, payload);
+}
+
+// Applies every intact record to the showrooms, then cuts off a torn tail
+// left by a crash so new records follow the last good one. Returns the
+// number of records that changed something.
+int wal_replay(Wal* wal) {
+    TextFile tf;
+    if (!text_file_open(&tf, wal->path)) return 0;
+    if (tf.size < 8 || memcmp(tf.data, WAL_MAGIC, 8) != 0) {
+        printf("%s is not a showroom log.\n", wal->path);
+        exit(1);
+    }
+
+    WalReplay r = { wal, 0 };
+    unsigned long long max_lsn = 0;
+    size_t good = wal_scan(tf.data, tf.size, &max_lsn, wal_replay_record, &r);
+    size_t size = tf.size;
+    text_file_close(&tf);
+
+    if (good < size) {
+        fprintf(stderr, "%s: dropping %zu bytes of incomplete records\n", wal->path, size - good);
+        if (ftruncate(wal->fd, good) != 0) {
+            printf("Cannot truncate %s: %s\n", wal->path, strerror(errno));
+            exit(1);
+        }
+        wal_sync(wal->fd, wal->path);
+    }
+    wal->file_bytes = wal->checkpoint_bytes = good;
+    wal->next_lsn = wal->durable_lsn = max_lsn + 1;
+    return r.applied;
+}
+
+// Copies a record into the append buffer and returns its LSN. Nothing is
+// durable until wal_commit returns for that LSN.
+unsigned long long wal_append(Wal* wal, int type, int showroom, const void* payload, unsigned len) {
+    WalRecordHeader h;
+    memset(&h, 0, sizeof(h));
+    h.len = len;
+    h.type = (unsigned short)type;
+    h.showroom = (unsigned short)showroom;
+
+    pthread_mutex_lock(&wal->lock);
+    h.lsn = wal->next_lsn++;
+    h.crc = wal_record_crc(&h, payload);
+    size_t need = sizeof(h) + len;
+    if (wal->used + need > wal->cap) {
+        while (wal->used + need > wal->cap) wal->cap *= 2;
+        wal->buf = (char*)realloc(wal->buf, wal->cap);
+        if (!wal->buf) {
+            printf("Memory allocation failed!\n");
+            exit(1);
+        }
+    }
+    memcpy(wal->buf + wal->used, &h, sizeof(h));
+    memcpy(wal->buf + wal->used + sizeof(h), payload, len);
+    wal->used += need;
+    wal->records++;
+    pthread_mutex_unlock(&wal->lock);
+    return h.lsn;
+}
+
+// Caller holds wal->lock and no flush is running. Writes and syncs all
+// appended records; with group commit the lock is dropped for the I/O so
+// new records keep piling up for the next leader.
+void wal_flush_locked(Wal* wal) {
+    char* buf = wal->buf;
+    size_t used = wal->used, cap = wal->cap;
+    unsigned long long upto = wal->next_lsn;
+    wal->buf = wal->flush_buf;
+    wal->cap = wal->flush_cap;
+    wal->used = 0;
+    wal->flush_buf = buf;
+    wal->flush_cap = cap;
+    wal->flushing = 1;
+
+    if (wal->group_commit) pthread_mutex_unlock(&wal->lock);
+    wal_write_all(wal->fd, buf, used, wal->path);
+    wal_sync(wal->fd, wal->path);
+    if (wal->group_commit) pthread_mutex_lock(&wal->lock);
+
+    wal->file_bytes += used;
+    wal->syncs++;
+    wal->durable_lsn = upto;
+    wal->flushing = 0;
+    pthread_cond_broadcast(&wal->flushed);
+}
+
+// Returns once the record with this LSN is on disk. Committers that arrive
+// while a flush is running wait and are covered by the next one, so one
+// fsync serves many sales.
+void wal_commit(Wal* wal, unsigned long long lsn) {
+    pthread_mutex_lock(&wal->lock);
+    while (wal->durable_lsn <= lsn) {
+        if (wal->flushing) pthread_cond_wait(&wal->flushed, &wal->lock);
+        else wal_flush_locked(wal);
+    }
+    int due = !wal->checkpointing && wal->file_bytes - wal->checkpoint_bytes >= WAL_CHECKPOINT_BYTES;
+    if (due) wal->checkpointing = 1;
+    pthread_mutex_unlock(&wal->lock);
+    if (due) wal_checkpoint(wal);
+}
+
+int sale_equal(const Sale* a, const Sale* b) {
+    return a->d_o_prchse == b->d_o_prchse && a->payment_code == b->payment_code &&
+           strncmp(a->cust_name, b->cust_name, NAME_LEN) == 0 &&
+           strncmp(a->cust_mobile, b->cust_mobile, NAME_LEN) == 0 &&
+           strncmp(a->cust_address, b->cust_address, ADDRESS_LEN) == 0 &&
+           strncmp(a->reg_no, b->reg_no, NAME_LEN) == 0 &&
+           strncmp(a->payment_method, b->payment_method, NAME_LEN) == 0;
+}
+
+//  Record kept by a checkpoint
+typedef struct WalLive {
+    WalRecordHeader h;
+    size_t off;
+    int key;                     // salesperson id or VIN
+} WalLive;
+
+typedef struct WalCompact {
+    Wal* wal;
+    WalLive* live;
+    int n, cap;
+} WalCompact;
+
+void wal_collect_record(const WalRecordHeader* h, const char* payload, size_t off, void* ctx) {
+    WalCompact* c = (WalCompact*)ctx;
+    Showroom* s = wal_showroom(c->wal, h->showroom);
+    if (!s) return;
+
+    int key;
+    if (h->type == WAL_SALE && h->len == sizeof(WalSale)) {
+        // Keep a sale only while it is the one recorded on the car
+        WalSale r;
+        memcpy(&r, payload, sizeof(r));
+        Car* car = (Car*)bptree_search(s->sold_stock, r.vin);
+        if (!car || !car->sale || !sale_equal(car->sale, &r.sale)) return;
+        key = r.vin;
+    } else if (h->type == WAL_SALESPERSON && h->len == sizeof(WalSalesperson)) {
+        WalSalesperson r;
+        memcpy(&r, payload, sizeof(r));
+        if (!get_salesperson(s->salespersons, r.id)) return;
+        key = r.id;
+    } else {
+        return;
+    }
+
+    if (c->n == c->cap) {
+        c->cap = c->cap ? c->cap * 2 : 1024;
+        c->live = (WalLive*)realloc(c->live, c->cap * sizeof(WalLive));
+        if (!c->live) {
+            printf("Memory allocation failed!\n");
+            exit(1);
+        }
+    }
+    c->live[c->n].h = *h;
+    c->live[c->n].off = off;
+    c->live[c->n].key = key;
+    c->n++;
+}
+
+// Salespersons before the sales that name them, then by showroom and key;
+// the newest record of a key comes first so duplicates can be skipped.
+int compare_live(const void* a, const void* b) {
+    const WalLive* x = (const WalLive*)a;
+    const WalLive* y = (const WalLive*)b;
+    if (x->h.type != y->h.type) return x->h.type == WAL_SALESPERSON ? -1 : 1;
+    if (x->h.showroom != y->h.showroom) return x->h.showroom < y->h.showroom ? -1 : 1;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return (x->h.lsn < y->h.lsn) - (x->h.lsn > y->h.lsn);
+}
+
+// Rewrites the log with only the records still reflected in memory: one per
+// salesperson and per sold car, salespersons first, sales in VIN order.
+// The new log is written beside the old one and renamed over it, so a crash
+// at any point leaves one complete log. Appends wait until it is done.
+void wal_checkpoint(Wal* wal) {
+    pthread_mutex_lock(&wal->lock);
+    while (wal->flushing) pthread_cond_wait(&wal->flushed, &wal->lock);
+    int group = wal->group_commit;
+    wal->group_commit = 0;          // keep the lock across this flush
+    if (wal->used) wal_flush_locked(wal);
+    wal->group_commit = group;
+
+    TextFile tf;
+    if (!text_file_open(&tf, wal->path)) {
+        wal->checkpointing = 0;
+        pthread_mutex_unlock(&wal->lock);
+        return;
+    }
+    WalCompact c = { wal, NULL, 0, 0 };
+    unsigned long long max_lsn = 0;
+    wal_scan(tf.data, tf.size, &max_lsn, wal_collect_record, &c);
+    qsort(c.live, c.n, sizeof(WalLive), compare_live);
+
+    char tmp[WAL_PATH_LEN + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", wal->path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Cannot write checkpoint %s: %s\n", tmp, strerror(errno));
+        text_file_close(&tf);
+        free(c.live);
+        wal->checkpointing = 0;
+        pthread_mutex_unlock(&wal->lock);
+        return;
+    }
+
+    size_t used = 0;
+    wal_write_all(fd, WAL_MAGIC, 8, tmp);
+    size_t bytes = 8;
+    for (int i = 0; i < c.n; i++) {
+        if (i > 0 && c.live[i].h.type == c.live[i - 1].h.type && c.live[i].h.showroom == c.live[i - 1].h.showroom &&
+            c.live[i].key == c.live[i - 1].key)
+            continue;
+        size_t len = sizeof(WalRecordHeader) + c.live[i].h.len;
+        if (used + len > wal->flush_cap) {
+            wal_write_all(fd, wal->flush_buf, used, tmp);
+            used = 0;
+        }
+        memcpy(wal->flush_buf + used, tf.data + c.live[i].off, len);
+        used += len;
+        bytes += len;
+    }
+    wal_write_all(fd, wal->flush_buf, used, tmp);
+    wal_sync(fd, tmp);
+    close(fd);
+    text_file_close(&tf);
+    free(c.live);
+
+    if (rename(tmp, wal->path) != 0) {
+        printf("Cannot replace %s: %s\n", wal->path, strerror(errno));
+        exit(1);
+    }
+    wal_sync_dir(wal->path);
+    close(wal->fd);
+    wal->fd = open(wal->path, O_RDWR | O_APPEND);
+    if (wal->fd < 0) {
+        printf("Cannot reopen log %s: %s\n", wal->path, strerror(errno));
+        exit(1);
+    }
+    wal->file_bytes = wal->checkpoint_bytes = bytes;
+    wal->checkpointing = 0;
+    wal->checkpoints++;
+    pthread_mutex_unlock(&wal->lock);
+}
+
+// Flushes, compacts and closes the log.
+void wal_close(Wal* wal) {
+    if (!wal) return;
+    wal_checkpoint(wal);
+    close(wal->fd);
+    pthread_mutex_destroy(&wal->lock);
+    pthread_cond_destroy(&wal->flushed);
+    free(wal->buf);
+    free(wal->flush_buf);
+    free(wal);
+}
+
+void wal_log_sale(Wal* wal, Showroom* s, int salesperson_id, int vin, const Sale* sale) {
+    WalSale r;
+    memset(&r, 0, sizeof(r));
+    r.salesperson_id = salesperson_id;
+    r.vin = vin;
+    r.sale = *sale;
+    wal_commit(wal, wal_append(wal, WAL_SALE, s->showroom_id, &r, sizeof(r)));
+}
+
+// Logs a batch of completed sales and waits for them with a single commit.
+void wal_log_sales(Wal* wal, Showroom* s, SaleRequest** sales, int n) {
+    unsigned long long lsn = 0;
+    WalSale r;
+    for (int i = 0; i < n; i++) {
+        memset(&r, 0, sizeof(r));
+        r.salesperson_id = sales[i]->sp->id;
+        r.vin = sales[i]->vin;
+        r.sale = *sales[i]->sale;
+        lsn = wal_append(wal, WAL_SALE, s->showroom_id, &r, sizeof(r));
+    }
+    if (n > 0) wal_commit(wal, lsn);
+}
+
+void wal_log_salesperson(Wal* wal, Showroom* s, const Salesperson* sp) {
+    WalSalesperson r;
+    memset(&r, 0, sizeof(r));
+    r.id = sp->id;
+    memcpy(r.name, sp->name, NAME_LEN);
+    r.target = sp->target;
+    wal_commit(wal, wal_append(wal, WAL_SALESPERSON, s->showroom_id, &r, sizeof(r)));
+}
@@ -0,0 +1,81 @@
+#ifndef WAL_H
+#define WAL_H
+
+#include <pthread.h>
+#include "bptree.h"
+
+#define WAL_MAGIC "SRWAL001"            // 8 bytes at the start of the file
+#define WAL_DEFAULT_PATH "showroom.wal"
+#define WAL_PATH_LEN 256
+#define WAL_BUFFER_SIZE (1 << 20)       // initial size of each append buffer
+#define WAL_CHECKPOINT_BYTES (64 << 20) // log growth that triggers a checkpoint
+#define WAL_MAX_RECORD (1 << 16)        // sanity bound for replay
+
+// Record types
+#define WAL_SALE 1
+#define WAL_SALESPERSON 2
+
+//  On-disk record header, followed by len bytes of payload
+typedef struct WalRecordHeader {
+    unsigned crc;                // CRC-32 of the rest of the header and the payload
+    unsigned len;
+    unsigned long long lsn;      // log sequence number, increasing
+    unsigned short type;         // WAL_*
+    unsigned short showroom;     // showroom_id
+    unsigned pad;
+} WalRecordHeader;
+
+//  WAL_SALE payload: one car sold through showroom_sell_car
+typedef struct WalSale {
+    int salesperson_id;
+    int vin;
+    Sale sale;
+} WalSale;
+
+//  WAL_SALESPERSON payload: a salesperson added at a terminal
+typedef struct WalSalesperson {
+    int id;
+    char name[NAME_LEN];
+    float target;
+} WalSalesperson;
+
+//  Append-only log with group commit: appends only copy into memory, and
+//  the first committer to find no flush running writes and fsyncs every
+//  record appended so far on behalf of all waiting committers.
+typedef struct Wal {
+    int fd;
+    char path[WAL_PATH_LEN];
+    Showroom* showrooms;         // what checkpoints compact against
+    int count;
+    int group_commit;            // 0 = write and fsync per commit (for comparison)
+
+    pthread_mutex_t lock;
+    pthread_cond_t flushed;
+    char* buf;                   // appended, not yet written
+    size_t used, cap;
+    char* flush_buf;             // being written by the current leader
+    size_t flush_cap;
+    unsigned long long next_lsn;
+    unsigned long long durable_lsn; // every record below this is on disk
+    int flushing;
+    size_t file_bytes;
+    size_t checkpoint_bytes;     // file size right after the last checkpoint
+    int checkpointing;
+
+    long records, syncs, checkpoints; // counters for benchmarks
+} Wal;
+
+unsigned crc32_update(unsigned crc, const void* data, size_t len);
+
+Wal* wal_open(const char* path, Showroom* showrooms, int count);
+int wal_replay(Wal* wal);
+unsigned long long wal_append(Wal* wal, int type, int showroom, const void* payload, unsigned len);
+void wal_commit(Wal* wal, unsigned long long lsn);
+void wal_checkpoint(Wal* wal);
+void wal_close(Wal* wal);
+
+void wal_log_sale(Wal* wal, Showroom* s, int salesperson_id, int vin, const Sale* sale);
+void wal_log_sales(Wal* wal, Showroom* s, SaleRequest** sales, int n);
+void wal_log_salesperson(Wal* wal, Showroom* s, const Salesperson* sp);
+
+#endif